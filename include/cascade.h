@@ -63,9 +63,17 @@ class Cascade : public std::iostream {
     Cascade& set_fopen_dirs(const std::string& path);
     Cascade& set_include_dirs(const std::string& path);
     Cascade& set_enable_inlining(bool enable);
-    Cascade& set_open_loop_target(size_t n);
+    Cascade& set_enable_bytecode(bool enable);
+    Cascade& set_enable_levelization(bool enable);
+    Cascade& set_enable_slot_compilation(bool enable);
+    Cascade& set_native_path(const std::string& path);
+    Cascade& set_open_loop_target(double s);
     Cascade& set_quartus_server(const std::string& host, size_t port);
     Cascade& set_profile_interval(size_t n);
+    Cascade& set_eval_threads(size_t n);
+    Cascade& set_sim_threads(size_t n);
+    Cascade& set_checkpoint(const std::string& path, size_t n);
+    Cascade& set_speculation(const std::string& marches);
     Cascade& set_stdin(std::streambuf* sb);
     Cascade& set_stdout(std::streambuf* sb);
     Cascade& set_stderr(std::streambuf* sb);
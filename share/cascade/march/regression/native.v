@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_NATIVE_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_NATIVE_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__target="sw;native"*)
+Root root();
+
+Clock clock();
+
+`endif
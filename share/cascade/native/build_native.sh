@@ -0,0 +1,10 @@
+#!/bin/sh
+
+# $1 = unique compilation directory
+# $2 = cxx compiler path
+# $3 = cascade source directory
+# $4 = cascade install prefix
+
+# Everything the generated code depends on is header-only, so a single
+# invocation of the compiler is all that's required to build a dll.
+$2 --std=c++17 -O3 -fPIC -shared -fno-stack-protector -DNDEBUG -I$3/src/cascade -I$4/include/cascade -o $1/libnative.so $1/program_logic.cc
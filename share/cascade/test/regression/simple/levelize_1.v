@@ -0,0 +1,21 @@
+reg[3:0] a = 0;
+wire[3:0] b = a + 1;
+wire[3:0] c = b + 1;
+wire[3:0] d = a + c;
+
+integer count = 0;
+always @(d) begin
+  count = count + 1;
+end
+
+integer start = 0;
+always @(posedge clock.val) begin
+  if (a == 1) begin
+    start <= count;
+  end
+  if (a == 4) begin
+    $write(count - start);
+    $finish;
+  end
+  a <= a + 1;
+end
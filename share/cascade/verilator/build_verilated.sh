@@ -0,0 +1,18 @@
+#!/bin/sh
+
+# $1 = unique compilation name
+# $2 = cxx compiler path
+
+# Check whether cxx compiler maps to clang or g++
+$2 --version | grep clang 
+if [ $? -eq 0 ] ; then
+  VER_INSTALL=/usr/local/share/verilator/
+  ARGS="-fbracket-depth=4096 -Qunused-arguments"
+else 
+  VER_INSTALL=/usr/share/verilator/
+  ARGS="-ftemplate-depth=4096 -fconstexpr-depth=4096"
+fi
+
+# Compile verilator's runtime library: This only depends on the toolchain, so it's built once and shared by every program that's linked by link_verilator.sh. We build it with the same flags as the slots in build_verilator_slot.sh
+cd $1
+$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fPIC -fno-stack-protector -DNDEBUG -DVL_INLINE_OPT=inline -c -o verilated.o $VER_INSTALL/include/verilated.cpp 
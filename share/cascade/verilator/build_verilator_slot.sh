@@ -0,0 +1,27 @@
+#!/bin/sh
+
+# $1 = unique compilation name
+# $2 = cxx compiler path
+# $3 = slot index
+
+# Check whether cxx compiler maps to clang or g++
+$2 --version | grep clang 
+if [ $? -eq 0 ] ; then
+  VER_INSTALL=/usr/local/share/verilator/
+  ARGS="-fbracket-depth=4096 -Qunused-arguments"
+else 
+  VER_INSTALL=/usr/share/verilator/
+  ARGS="-ftemplate-depth=4096 -fconstexpr-depth=4096"
+fi
+
+# Invoke verilator on a single slot: S$3 is a wrapper around M$3 which exposes the slot's avalon ports under names verilator won't mangle
+verilator -Mdir $1 --prefix VS$3 --top-module S$3 -Wno-lint -Wno-fatal -cc -O3 --x-assign fast --x-initial fast --noassert --clk clk $1.v --exe fake_main.cpp
+
+# Invoke verilator's Makefile: These objects are linked into a shared object by link_verilator.sh, so we build them position-independent and without lto to keep linking cheap. verilated.o is built separately by build_verilated.sh
+cd $1
+perl $VER_INSTALL/bin/verilator_includer -DVL_INCLUDE_OPT=include VS$3.cpp > VS$3__ALLcls.cpp 
+$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fPIC -fno-stack-protector -DNDEBUG -DVL_INLINE_OPT=inline -c -o VS$3__ALLcls.o VS$3__ALLcls.cpp 
+perl $VER_INSTALL/bin/verilator_includer -DVL_INCLUDE_OPT=include VS$3__Syms.cpp > VS$3__ALLsup.cpp 
+$2 -I.  -MMD -I$VER_INSTALL/include -I$VER_INSTALL/include/vltstd -DVL_PRINTF=printf -DVM_COVERAGE=0 -DVM_SC=0 -DVM_TRACE=0 -faligned-new $ARGS -Wno-parentheses-equality -Wno-sign-compare -Wno-uninitialized -Wno-unused-parameter -Wno-unused-variable -Wno-shadow  -O3 -fPIC -fno-stack-protector -DNDEBUG -DVL_INLINE_OPT=inline -c -o VS$3__ALLsup.o VS$3__ALLsup.cpp 
+ar r VS$3__ALL.a VS$3__ALLcls.o VS$3__ALLsup.o 
+ranlib VS$3__ALL.a 
@@ -0,0 +1,30 @@
+#!/bin/sh
+
+# $1 = unique compilation name (contains harness.cpp)
+# $2 = cxx compiler path
+# $3 = build directory produced by build_verilated.sh
+# $4... = slot build directories produced by build_verilator_slot.sh
+
+# Check whether cxx compiler maps to clang or g++
+$2 --version | grep clang 
+if [ $? -eq 0 ] ; then
+  VER_INSTALL=/usr/local/share/verilator/
+else 
+  VER_INSTALL=/usr/share/verilator/
+fi
+
+OUT=$1
+CXX=$2
+VERILATED=$3/verilated.o
+shift 3
+
+INCS=""
+LIBS=""
+for DIR in "$@" ; do
+  INCS="$INCS -I$DIR"
+  LIBS="$LIBS `ls $DIR/VS*__ALL.a`"
+done
+
+# Compile the generated harness, which multiplexes avalon requests between slots, and wrap everything up in a dll
+$CXX --std=c++17 -fPIC -fno-stack-protector -DNDEBUG -I$VER_INSTALL/include/ $INCS -c $OUT/harness.cpp -o $OUT/harness.o
+$CXX -fPIC -shared -o $OUT/libverilator.so $OUT/harness.o $LIBS $VERILATED
@@ -36,6 +36,7 @@
 #include "target/core/avmm/de10/de10_compiler.h"
 #include "target/core/avmm/ulx3s/ulx3s_compiler.h"
 #include "target/core/avmm/verilator/verilator_compiler.h"
+#include "target/core/native/native_compiler.h"
 #include "target/core/sw/sw_compiler.h"
 #include "target/core/proxy/proxy_compiler.h"
 
@@ -47,10 +48,11 @@ Cascade::Cascade() : eval_(this), iostream(&sb_), sb_() {
   is_running_ = false;
 
   set_enable_inlining(true);
-  set_open_loop_target(1);
+  set_open_loop_target(0.01);
 
   runtime_.get_compiler()->set("avalon32", new avmm::Avalon32Compiler());
   runtime_.get_compiler()->set("de10", new avmm::De10Compiler());
+  runtime_.get_compiler()->set("native", new native::NativeCompiler());
   runtime_.get_compiler()->set("proxy", new proxy::ProxyCompiler());
   runtime_.get_compiler()->set("sw", new sw::SwCompiler());
   runtime_.get_compiler()->set("ulx3s32", new avmm::Ulx3s32Compiler());
@@ -85,9 +87,46 @@ Cascade& Cascade::set_enable_inlining(bool enable) {
   return *this;
 }
 
-Cascade& Cascade::set_open_loop_target(size_t n) {
+Cascade& Cascade::set_enable_bytecode(bool enable) {
   assert(!is_running_);
-  runtime_.set_open_loop_target(n);
+  auto* sc = runtime_.get_compiler()->get("sw");
+  assert(sc != nullptr);
+  static_cast<sw::SwCompiler*>(sc)->set_bytecode(enable);
+  return *this;
+}
+
+Cascade& Cascade::set_enable_levelization(bool enable) {
+  assert(!is_running_);
+  auto* sc = runtime_.get_compiler()->get("sw");
+  assert(sc != nullptr);
+  static_cast<sw::SwCompiler*>(sc)->set_levelize(enable);
+  return *this;
+}
+
+Cascade& Cascade::set_enable_slot_compilation(bool enable) {
+  assert(!is_running_);
+  auto* vc32 = runtime_.get_compiler()->get("verilator32");
+  assert(vc32 != nullptr);
+  static_cast<avmm::Verilator32Compiler*>(vc32)->set_slot_compilation(enable);
+  #if __x86_64__ || __ppc64__
+  auto* vc64 = runtime_.get_compiler()->get("verilator64");
+  assert(vc64 != nullptr);
+  static_cast<avmm::Verilator64Compiler*>(vc64)->set_slot_compilation(enable);
+  #endif
+  return *this;
+}
+
+Cascade& Cascade::set_native_path(const string& path) {
+  assert(!is_running_);
+  auto* nc = runtime_.get_compiler()->get("native");
+  assert(nc != nullptr);
+  static_cast<native::NativeCompiler*>(nc)->set_path(path);
+  return *this;
+}
+
+Cascade& Cascade::set_open_loop_target(double s) {
+  assert(!is_running_);
+  runtime_.set_open_loop_target(s);
   return *this;
 }
 
@@ -106,6 +145,32 @@ Cascade& Cascade::set_profile_interval(size_t n) {
   return *this;
 }
 
+Cascade& Cascade::set_eval_threads(size_t n) {
+  assert(!is_running_);
+  runtime_.set_eval_threads(n);
+  return *this;
+}
+
+Cascade& Cascade::set_sim_threads(size_t n) {
+  assert(!is_running_);
+  auto* sc = runtime_.get_compiler()->get("sw");
+  assert(sc != nullptr);
+  static_cast<sw::SwCompiler*>(sc)->set_partitions(n);
+  return *this;
+}
+
+Cascade& Cascade::set_checkpoint(const string& path, size_t n) {
+  assert(!is_running_);
+  runtime_.set_checkpoint(path, n);
+  return *this;
+}
+
+Cascade& Cascade::set_speculation(const string& marches) {
+  assert(!is_running_);
+  runtime_.set_speculation(marches);
+  return *this;
+}
+
 Cascade& Cascade::set_stdin(streambuf* sb) {
   assert(!is_running_);
   runtime_.rdbuf(0, sb);
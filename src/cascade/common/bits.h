@@ -41,7 +41,8 @@
 #include <type_traits>
 #include <vector>
 #include "common/serializable.h"
-#include "common/vector.h"
+#include "common/simd.h"
+#include "common/small_vector.h"
 
 namespace cascade {
 
@@ -218,8 +219,9 @@ class BitsBase : public Serializable {
     bool operator>=(const BitsBase& rhs) const;
 
   private:
-    // Bit-string representation
-    Vector<T> val_;
+    // Bit-string representation. Values of up to 64 bits are stored inline,
+    // which on 64-bit platforms costs no more space than a heap pointer.
+    SmallVector<T, sizeof(uint64_t)/sizeof(T)> val_;
     // Total number of bits in this string
     uint32_t size_;
     // How is this value being interpreted
@@ -250,6 +252,30 @@ class BitsBase : public Serializable {
     void bitwise_sll_const(const BitsBase& lhs, size_t samt);
     void bitwise_sxr_const(const BitsBase& lhs, size_t samt, bool arith);
 
+    // Multi-word Arithmetic Helpers:
+    //
+    // These methods operate on little-endian arrays of n words. Results may not
+    // alias inputs. 
+    //
+    // Sets r (2n words) to a*b. Uses Karatsuba above karatsuba_threshold(),
+    // in which case ws must point to mul_full_scratch(n) words of scratch.
+    static void mul_full(const T* a, const T* b, size_t n, T* r, T* ws);
+    static size_t mul_full_scratch(size_t n);
+    // Sets r (n words) to a*b, truncated to n words. Schoolbook only computes
+    // half of the partial products here, so this uses Karatsuba above twice
+    // karatsuba_threshold(). Scratch requirements are otherwise as above.
+    static void mul_trunc(const T* a, const T* b, size_t n, T* r, T* ws);
+    static size_t mul_trunc_scratch(size_t n);
+    // Convenience wrapper for mul_trunc which allocates its own scratch space.
+    static void mul_trunc(const T* a, const T* b, size_t n, T* r);
+    // Sets q and r to the unsigned quotient and remainder of u/v using Knuth's
+    // algorithm D. v must be non-zero.
+    static void div_words(const T* u, const T* v, size_t n, T* q, T* r);
+    // Sets this to the quotient or remainder of lhs and rhs. Handles signs.
+    void arithmetic_divmod(const BitsBase& lhs, const BitsBase& rhs, bool quotient);
+    // Returns the number of words above which multiplication uses Karatsuba.
+    static constexpr size_t karatsuba_threshold();
+
     // Returns the nth (possibly greater than val_.size()th) word of this value.
     // Performs sign extension as necessary.
     T signed_get(size_t n) const;
@@ -618,7 +644,12 @@ inline void BitsBase<T, BT, ST>::bitwise_and(const BitsBase& lhs, const BitsBase
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    Simd::bitwise_and(val_.data(), lhs.val_.data(), rhs.val_.data(), n*sizeof(T));
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
     val_[i] = lhs.val_[i] & rhs.val_[i];
   }
 }
@@ -629,7 +660,12 @@ inline void BitsBase<T, BT, ST>::bitwise_or(const BitsBase& lhs, const BitsBase&
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    Simd::bitwise_or(val_.data(), lhs.val_.data(), rhs.val_.data(), n*sizeof(T));
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
     val_[i] = lhs.val_[i] | rhs.val_[i];
   }
 }
@@ -640,7 +676,12 @@ inline void BitsBase<T, BT, ST>::bitwise_xor(const BitsBase& lhs, const BitsBase
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    Simd::bitwise_xor(val_.data(), lhs.val_.data(), rhs.val_.data(), n*sizeof(T));
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
     val_[i] = lhs.val_[i] ^ rhs.val_[i];
   }
 }
@@ -651,8 +692,13 @@ inline void BitsBase<T, BT, ST>::bitwise_xnor(const BitsBase& lhs, const BitsBas
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = ~(lhs.val_[i] ^ rhs.val_[i]);
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    Simd::bitwise_xnor(val_.data(), lhs.val_.data(), rhs.val_.data(), n*sizeof(T));
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      val_[i] = ~(lhs.val_[i] ^ rhs.val_[i]);
+    }
   }
   trim();
 }
@@ -689,8 +735,13 @@ inline void BitsBase<T, BT, ST>::bitwise_not(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
   assert(size() == lhs.size());
 
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
-    val_[i] = ~lhs.val_[i];
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    Simd::bitwise_not(val_.data(), lhs.val_.data(), n*sizeof(T));
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      val_[i] = ~lhs.val_[i];
+    }
   }
   trim();
 }
@@ -781,19 +832,21 @@ inline void BitsBase<T, BT, ST>::arithmetic_multiply(const BitsBase& lhs, const
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  // This is the optimized space algorithm described in wiki's multiplication
-  // algorithm article. The code is simplified here, as we can assume that both
-  // inputs and the result are capped at S words. 
-
+  // Fast Path: Single word values can be multiplied directly
   const auto S = val_.size();
-  BT tot = 0;
-  for (size_t ri = 0; ri < S; ++ri) {
-    for (size_t bi = 0; bi <= ri; ++bi) {
-      size_t ai = ri - bi;
-      tot += static_cast<BT>(lhs.val_[ai]) * static_cast<BT>(rhs.val_[bi]);
-    }
-    val_[ri] = static_cast<T>(tot);
-    tot >>= bits_per_word();
+  if (S == 1) {
+    val_[0] = lhs.val_[0] * rhs.val_[0];
+    trim();
+    return;
+  }
+  // Multi-word values are multiplied into scratch space if this aliases an
+  // operand. The product is truncated to S words in either case.
+  if ((this == &lhs) || (this == &rhs)) {
+    std::vector<T> res(S);
+    mul_trunc(lhs.val_.data(), rhs.val_.data(), S, res.data());
+    std::copy(res.begin(), res.end(), val_.begin());
+  } else {
+    mul_trunc(lhs.val_.data(), rhs.val_.data(), S, val_.data());
   }
   trim();
 }
@@ -809,10 +862,14 @@ inline void BitsBase<T, BT, ST>::arithmetic_divide(const BitsBase& lhs, const Bi
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  // TODO(eschkufz) This only words for single word inputs
-  assert(val_.size() == 1);
-
-  if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+  // Multi-word values are handled by long division
+  if (val_.size() > 1) {
+    return arithmetic_divmod(lhs, rhs, true);
+  }
+  // Division by zero is undefined in verilog. Like verilator, we return zero.
+  if (rhs.val_[0] == 0) {
+    val_[0] = 0;
+  } else if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
     const ST l = lhs.is_neg_signed() ? (lhs.val_[0] | (static_cast<BT>(-1) << size_)) : lhs.val_[0];
     const ST r = rhs.is_neg_signed() ? (rhs.val_[0] | (static_cast<BT>(-1) << rhs.size_)) : rhs.val_[0]; 
     val_[0] = l / r;
@@ -828,10 +885,14 @@ inline void BitsBase<T, BT, ST>::arithmetic_mod(const BitsBase& lhs, const BitsB
   assert(size() == lhs.size());
   assert(size() == rhs.size());
 
-  // TODO(eschkufz) This only words for single word inputs
-  assert(val_.size() == 1);
-
-  if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
+  // Multi-word values are handled by long division
+  if (val_.size() > 1) {
+    return arithmetic_divmod(lhs, rhs, false);
+  }
+  // Modulus by zero is undefined in verilog. Like verilator, we return zero.
+  if (rhs.val_[0] == 0) {
+    val_[0] = 0;
+  } else if ((lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED)) {
     const ST l = lhs.is_neg_signed() ? (lhs.val_[0] | (static_cast<BT>(-1) << size_)) : lhs.val_[0];
     const ST r = rhs.is_neg_signed() ? (rhs.val_[0] | (static_cast<BT>(-1) << rhs.size_)) : rhs.val_[0]; 
     val_[0] = l % r;
@@ -843,18 +904,71 @@ inline void BitsBase<T, BT, ST>::arithmetic_mod(const BitsBase& lhs, const BitsB
 
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::arithmetic_pow(const BitsBase& lhs, const BitsBase& rhs) {
-  // TODO(eschkufz) There's a lot wrong here:
-  // 1. We're not respecting verilog semantics (wrt sign and result)
-  // 2. This only works for single word inputs
-  // 3. We're not supporting reals, which this should be defined for
+  if (lhs.is_real() || rhs.is_real()) {
+    assert(size() == 64);
+    *reinterpret_cast<double*>(val_.data()) = std::pow(lhs.to_double(), rhs.to_double());
+    return;
+  }
 
-  assert(!lhs.is_real() && !rhs.is_real());
   assert(size() == lhs.size());
   assert(size() == rhs.size());
-  assert(val_.size() == 1);
 
-  // No resize. This method preserves the bit-width of lhs
-  val_[0] = std::pow(lhs.val_[0], rhs.val_[0]);
+  // Negative exponents follow table 5-6 of the 2005 spec: 1 and -1 are the
+  // only bases with non-zero results. The result for a base of zero is
+  // undefined. Like division by zero, we return zero.
+  const auto S = val_.size();
+  if ((rhs.type_ == Type::SIGNED) && rhs.is_neg_signed()) {
+    auto one = lhs.val_[0] == 1;
+    auto neg_one = lhs.is_neg_signed();
+    for (size_t i = 0; i < S; ++i) {
+      one = one && ((i == 0) || (lhs.val_[i] == 0));
+      neg_one = neg_one && (lhs.signed_get(i) == static_cast<T>(-1));
+    }
+    const auto odd = rhs.get(0);
+    std::fill(val_.begin(), val_.end(), static_cast<T>(0));
+    if (one || (neg_one && !odd)) {
+      val_[0] = 1;
+    } else if (neg_one) {
+      std::fill(val_.begin(), val_.end(), static_cast<T>(-1));
+    }
+    trim();
+    return;
+  }
+
+  // Otherwise, square and multiply. Truncating each intermediate product to
+  // the width of the result preserves the low order bits of the final result.
+  if (S == 1) {
+    T res = 1;
+    T base = lhs.val_[0];
+    for (auto e = rhs.val_[0]; e != 0; e >>= 1) {
+      if (e & 1) {
+        res *= base;
+      }
+      base *= base;
+    }
+    val_[0] = res;
+    trim();
+    return;
+  }
+  std::vector<T> res(S, static_cast<T>(0));
+  std::vector<T> base(lhs.val_.begin(), lhs.val_.end());
+  std::vector<T> tmp(S);
+  res[0] = 1;
+  size_t top = rhs.size_;
+  while ((top > 0) && !rhs.get(top-1)) {
+    --top;
+  }
+  for (size_t i = 0; i < top; ++i) {
+    if (rhs.get(i)) {
+      mul_trunc(res.data(), base.data(), S, tmp.data());
+      res.swap(tmp);
+    }
+    if ((i+1) < top) {
+      mul_trunc(base.data(), base.data(), S, tmp.data());
+      base.swap(tmp);
+    }
+  }
+  std::copy(res.begin(), res.end(), val_.begin());
   trim();
 }
 
@@ -925,14 +1039,24 @@ template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_and(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
   // Logical operations always yield unsigned results
-  for (size_t i = 0, ie = lhs.val_.size()-1; i < ie; ++i) {
-    if (lhs.val_[i] != static_cast<T>(-1)) {
+  const auto n = lhs.val_.size()-1;
+  if (Simd::profitable(n*sizeof(T))) {
+    if (!Simd::all_ones(lhs.val_.data(), n*sizeof(T))) {
       val_[0] = static_cast<T>(0);
       trim();
       return;
     }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      if (lhs.val_[i] != static_cast<T>(-1)) {
+        val_[0] = static_cast<T>(0);
+        trim();
+        return;
+      }
+    }
   }
-  const auto mask = (static_cast<T>(1) << (size_ % bits_per_word())) - 1;
+  const auto top = lhs.size_ % bits_per_word();
+  const auto mask = (top == 0) ? static_cast<T>(-1) : ((static_cast<T>(1) << top) - 1);
   if ((lhs.val_.back() & mask) != mask) {
     val_[0] = static_cast<T>(0);
     trim();
@@ -953,7 +1077,13 @@ inline void BitsBase<T, BT, ST>::reduce_nand(const BitsBase& lhs) {
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_or(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
-  for (size_t i = 0, ie = lhs.val_.size(); i < ie; ++i) {
+  const auto n = lhs.val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    val_[0] = Simd::any(lhs.val_.data(), n*sizeof(T)) ? static_cast<T>(1) : static_cast<T>(0);
+    trim();
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
     if (lhs.val_[i]) {
       val_[0] = static_cast<T>(1);
       trim();
@@ -974,9 +1104,14 @@ inline void BitsBase<T, BT, ST>::reduce_nor(const BitsBase& lhs) {
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::reduce_xor(const BitsBase& lhs) {
   assert(!is_real() && !lhs.is_real());
+  const auto n = lhs.val_.size();
   size_t cnt = 0;
-  for (size_t i = 0, ie = lhs.val_.size(); i < ie; ++i) {
-    cnt += __builtin_popcount(lhs.val_[i]);
+  if (Simd::profitable(n*sizeof(T))) {
+    cnt = Simd::popcount(lhs.val_.data(), n*sizeof(T));
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      cnt += __builtin_popcountll(lhs.val_[i]);
+    }
   }
   val_[0] = static_cast<T>(cnt % 2);
   trim();
@@ -1015,8 +1150,17 @@ inline bool BitsBase<T, BT, ST>::eq(const BitsBase& rhs) const {
     return eq(temp);
   }
 
+  // Fast Path: If rhs doesn't need to be sign extended, all but the top word
+  // can be compared in bulk.
   size_t i = 0;
-  for (size_t ie = val_.size()-1; i < ie; ++i) {
+  const auto n = val_.size()-1;
+  if (!rhs.is_neg_signed() && (rhs.val_.size() > n) && Simd::profitable(n*sizeof(T))) {
+    if (!Simd::equal(val_.data(), rhs.val_.data(), n*sizeof(T))) {
+      return false;
+    }
+    i = n;
+  }
+  for (size_t ie = n; i < ie; ++i) {
     const auto rval = rhs.signed_get(i);
     if (val_[i] != rval) {
       return false;
@@ -1301,7 +1445,11 @@ inline bool BitsBase<T, BT, ST>::operator==(const BitsBase& rhs) const {
   }
 
   assert(size_ == rhs.size_);
-  for (size_t i = 0, ie = val_.size(); i < ie; ++i) {
+  const auto n = val_.size();
+  if (Simd::profitable(n*sizeof(T))) {
+    return Simd::equal(val_.data(), rhs.val_.data(), n*sizeof(T));
+  }
+  for (size_t i = 0; i < n; ++i) {
     if (val_[i] != rhs.val_[i]) {
       return false;
     }
@@ -1739,6 +1887,293 @@ inline void BitsBase<T, BT, ST>::bitwise_sxr_const(const BitsBase& lhs, size_t s
   trim();
 }
 
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::mul_full(const T* a, const T* b, size_t n, T* r, T* ws) {
+  constexpr auto w = 8*sizeof(T);
+
+  // Base Case: Schoolbook multiplication. Each partial product is added in
+  // separately, so the double-width accumulator can't overflow.
+  if (n < karatsuba_threshold()) {
+    std::fill_n(r, 2*n, static_cast<T>(0));
+    for (size_t i = 0; i < n; ++i) {
+      T carry = 0;
+      for (size_t j = 0; j < n; ++j) {
+        const auto t = static_cast<BT>(a[i]) * b[j] + r[i+j] + carry;
+        r[i+j] = static_cast<T>(t);
+        carry = static_cast<T>(t >> w);
+      }
+      r[i+n] = carry;
+    }
+    return;
+  }
+
+  // Recursive Case: Split the inputs into low halves of m words and high
+  // halves of k words. The products of the low and high halves are written
+  // directly into the low and high halves of the result. 
+  const auto m = (n+1)/2;
+  const auto k = n-m;
+  auto* sa = ws;
+  auto* sb = sa + (m+1);
+  auto* z1 = sb + (m+1);
+  auto* next = z1 + 2*(m+1);
+  mul_full(a, b, m, r, next);
+  mul_full(a+m, b+m, k, r+2*m, next);
+
+  // The middle term is (a0+a1)*(b0+b1) minus the other two.
+  T ca = 0;
+  T cb = 0;
+  for (size_t i = 0; i < m; ++i) {
+    const auto ta = static_cast<BT>(a[i]) + ((i < k) ? a[m+i] : 0) + ca;
+    const auto tb = static_cast<BT>(b[i]) + ((i < k) ? b[m+i] : 0) + cb;
+    sa[i] = static_cast<T>(ta);
+    sb[i] = static_cast<T>(tb);
+    ca = static_cast<T>(ta >> w);
+    cb = static_cast<T>(tb >> w);
+  }
+  sa[m] = ca;
+  sb[m] = cb;
+  mul_full(sa, sb, m+1, z1, next);
+
+  const auto z1n = 2*(m+1);
+  for (auto sub : {std::make_pair(r, 2*m), std::make_pair(r+2*m, 2*k)}) {
+    T borrow = 0;
+    for (size_t i = 0; i < z1n; ++i) {
+      const auto t = static_cast<BT>(z1[i]) - ((i < sub.second) ? sub.first[i] : 0) - borrow;
+      z1[i] = static_cast<T>(t);
+      borrow = ((t >> w) != 0) ? 1 : 0;
+    }
+  }
+
+  // Add the middle term in at an offset of m words
+  T carry = 0;
+  for (size_t i = m, ie = 2*n; i < ie; ++i) {
+    const auto t = static_cast<BT>(r[i]) + (((i-m) < z1n) ? z1[i-m] : 0) + carry;
+    r[i] = static_cast<T>(t);
+    carry = static_cast<T>(t >> w);
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsBase<T, BT, ST>::mul_full_scratch(size_t n) {
+  if (n < karatsuba_threshold()) {
+    return 0;
+  }
+  const auto m = (n+1)/2;
+  return 4*(m+1) + mul_full_scratch(m+1);
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::mul_trunc(const T* a, const T* b, size_t n, T* r, T* ws) {
+  constexpr auto w = 8*sizeof(T);
+
+  // Base Case: Schoolbook multiplication, skipping partial products which
+  // only contribute to words above n.
+  if (n < 2*karatsuba_threshold()) {
+    std::fill_n(r, n, static_cast<T>(0));
+    for (size_t i = 0; i < n; ++i) {
+      T carry = 0;
+      for (size_t j = 0, je = n-i; j < je; ++j) {
+        const auto t = static_cast<BT>(a[i]) * b[j] + r[i+j] + carry;
+        r[i+j] = static_cast<T>(t);
+        carry = static_cast<T>(t >> w);
+      }
+    }
+    return;
+  }
+
+  // Recursive Case: Only the product of the low halves requires a full
+  // multiplication. The product of the high halves lies entirely above n
+  // words, and only the low k words of the cross terms are needed.
+  const auto m = (n+1)/2;
+  const auto k = n-m;
+  auto* z0 = ws;
+  auto* z1 = z0 + 2*m;
+  auto* next = z1 + k;
+  mul_full(a, b, m, z0, next);
+  std::copy(z0, z0+n, r);
+
+  for (auto cross : {std::make_pair(a+m, b), std::make_pair(a, b+m)}) {
+    mul_trunc(cross.first, cross.second, k, z1, next);
+    T carry = 0;
+    for (size_t i = 0; i < k; ++i) {
+      const auto t = static_cast<BT>(r[m+i]) + z1[i] + carry;
+      r[m+i] = static_cast<T>(t);
+      carry = static_cast<T>(t >> w);
+    }
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsBase<T, BT, ST>::mul_trunc_scratch(size_t n) {
+  if (n < 2*karatsuba_threshold()) {
+    return 0;
+  }
+  const auto m = (n+1)/2;
+  const auto k = n-m;
+  return 2*m + k + std::max(mul_full_scratch(m), mul_trunc_scratch(k));
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::mul_trunc(const T* a, const T* b, size_t n, T* r) {
+  if (n < 2*karatsuba_threshold()) {
+    mul_trunc(a, b, n, r, nullptr);
+  } else {
+    std::vector<T> ws(mul_trunc_scratch(n));
+    mul_trunc(a, b, n, r, ws.data());
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::div_words(const T* u, const T* v, size_t n, T* q, T* r) {
+  constexpr auto w = 8*sizeof(T);
+  constexpr auto B = static_cast<BT>(1) << w;
+
+  std::fill_n(q, n, static_cast<T>(0));
+  std::fill_n(r, n, static_cast<T>(0));
+
+  // Ignore leading zero words
+  auto vn = n;
+  while ((vn > 0) && (v[vn-1] == 0)) {
+    --vn;
+  }
+  assert(vn > 0);
+  auto un = n;
+  while ((un > 0) && (u[un-1] == 0)) {
+    --un;
+  }
+
+  // Easy Case: The divisor is larger than the dividend
+  if (un < vn) {
+    std::copy(u, u+un, r);
+    return;
+  }
+  // Easy Case: Single word divisors only require short division
+  if (vn == 1) {
+    BT rem = 0;
+    for (auto i = un; i-- > 0; ) {
+      const auto cur = (rem << w) | u[i];
+      q[i] = static_cast<T>(cur / v[0]);
+      rem = cur % v[0];
+    }
+    r[0] = static_cast<T>(rem);
+    return;
+  }
+
+  // Normalize so that the high bit of the divisor is set. This guarantees
+  // that each quotient digit estimate is off by at most two.
+  size_t s = 0;
+  for (auto top = v[vn-1]; (top & (static_cast<T>(1) << (w-1))) == 0; top <<= 1) {
+    ++s;
+  }
+  std::vector<T> nv(vn);
+  std::vector<T> nu(un+1);
+  for (size_t i = vn-1; i > 0; --i) {
+    nv[i] = (v[i] << s) | ((s == 0) ? 0 : (v[i-1] >> (w-s)));
+  }
+  nv[0] = v[0] << s;
+  nu[un] = (s == 0) ? 0 : (u[un-1] >> (w-s));
+  for (size_t i = un-1; i > 0; --i) {
+    nu[i] = (u[i] << s) | ((s == 0) ? 0 : (u[i-1] >> (w-s)));
+  }
+  nu[0] = u[0] << s;
+
+  for (auto j = un-vn+1; j-- > 0; ) {
+    // Estimate the next quotient digit from the top two words of the
+    // remainder and the top word of the divisor, and refine it using the
+    // second word of the divisor.
+    const auto num = (static_cast<BT>(nu[j+vn]) << w) | nu[j+vn-1];
+    auto qhat = num / nv[vn-1];
+    auto rhat = num % nv[vn-1];
+    while ((qhat >= B) || ((qhat * nv[vn-2]) > ((rhat << w) | nu[j+vn-2]))) {
+      --qhat;
+      rhat += nv[vn-1];
+      if (rhat >= B) {
+        break;
+      }
+    }
+
+    // Multiply and subtract
+    T carry = 0;
+    T borrow = 0;
+    for (size_t i = 0; i < vn; ++i) {
+      const auto p = qhat * nv[i] + carry;
+      carry = static_cast<T>(p >> w);
+      const auto t = static_cast<BT>(nu[i+j]) - static_cast<T>(p) - borrow;
+      nu[i+j] = static_cast<T>(t);
+      borrow = ((t >> w) != 0) ? 1 : 0;
+    }
+    const auto t = static_cast<BT>(nu[j+vn]) - carry - borrow;
+    nu[j+vn] = static_cast<T>(t);
+
+    // If the estimate was one too large, add the divisor back in
+    if ((t >> w) != 0) {
+      --qhat;
+      carry = 0;
+      for (size_t i = 0; i < vn; ++i) {
+        const auto t = static_cast<BT>(nu[i+j]) + nv[i] + carry;
+        nu[i+j] = static_cast<T>(t);
+        carry = static_cast<T>(t >> w);
+      }
+      nu[j+vn] += carry;
+    }
+    q[j] = static_cast<T>(qhat);
+  }
+
+  // Denormalize the remainder
+  for (size_t i = 0; i < vn-1; ++i) {
+    r[i] = (nu[i] >> s) | ((s == 0) ? 0 : (nu[i+1] << (w-s)));
+  }
+  r[vn-1] = nu[vn-1] >> s;
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::arithmetic_divmod(const BitsBase& lhs, const BitsBase& rhs, bool quotient) {
+  // Divide magnitudes. The quotient is negative if the operand signs differ,
+  // and the remainder takes the sign of the dividend.
+  const auto S = val_.size();
+  const auto sgn = (lhs.type_ == Type::SIGNED) && (rhs.type_ == Type::SIGNED);
+  const auto lneg = sgn && lhs.is_neg_signed();
+  const auto rneg = sgn && rhs.is_neg_signed();
+
+  const auto negate = [](std::vector<T>& x) {
+    T carry = 1;
+    for (auto& y : x) {
+      y = ~y + carry;
+      carry = ((y == 0) && (carry == 1)) ? 1 : 0;
+    }
+  };
+
+  std::vector<T> u(S);
+  std::vector<T> v(S);
+  auto zero = true;
+  for (size_t i = 0; i < S; ++i) {
+    u[i] = lneg ? lhs.signed_get(i) : lhs.val_[i];
+    v[i] = rneg ? rhs.signed_get(i) : rhs.val_[i];
+    zero = zero && (v[i] == 0);
+  }
+  // Division by zero is undefined in verilog. Like verilator, we return zero.
+  if (zero) {
+    std::fill(val_.begin(), val_.end(), static_cast<T>(0));
+    return;
+  }
+  if (lneg) {
+    negate(u);
+  }
+  if (rneg) {
+    negate(v);
+  }
+
+  std::vector<T> q(S);
+  std::vector<T> r(S);
+  div_words(u.data(), v.data(), S, q.data(), r.data());
+  auto& res = quotient ? q : r;
+  if (quotient ? (lneg != rneg) : lneg) {
+    negate(res);
+  }
+  std::copy(res.begin(), res.end(), val_.begin());
+  trim();
+}
+
 template <typename T, typename BT, typename ST>
 inline T BitsBase<T, BT, ST>::signed_get(size_t n) const {
   // Easiest Case: This is an unisgned value, so return what's in range or zero
@@ -1872,6 +2307,13 @@ inline constexpr size_t BitsBase<T, BT, ST>::bytes_per_word() const {
   return sizeof(T);
 }
 
+template <typename T, typename BT, typename ST>
+inline constexpr size_t BitsBase<T, BT, ST>::karatsuba_threshold() {
+  // Measured on 64-bit words: below about 32 words, the bookkeeping in
+  // Karatsuba costs more than the multiplications it saves.
+  return 32;
+}
+
 template <typename T, typename BT, typename ST>
 inline constexpr double BitsBase<T, BT, ST>::range() const {
   return std::pow(2, bits_per_word());
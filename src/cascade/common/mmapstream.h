@@ -0,0 +1,148 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_MMAPSTREAM_H
+#define CASCADE_SRC_COMMON_MMAPSTREAM_H
+
+#include <fcntl.h>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cascade {
+
+// A read-only stream over a memory-mapped file. Nothing is copied out of the
+// mapping until it's read, so seeking to and reading a small part of a large
+// file only pulls those pages into memory.
+
+class mmapbuf : public std::streambuf {
+  public:
+    // Typedefs:
+    typedef std::streambuf::char_type char_type;
+    typedef std::streambuf::traits_type traits_type;
+    typedef std::streambuf::int_type int_type;
+    typedef std::streambuf::pos_type pos_type;
+    typedef std::streambuf::off_type off_type;
+
+    // Constructors:
+    explicit mmapbuf(const std::string& path);
+    ~mmapbuf() override;
+
+    // Returns true if the file was mapped successfully
+    bool is_open() const;
+
+  private:
+    char_type* data_;
+    size_t size_;
+
+    // Positioning:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+};
+
+class immapstream : public std::istream {
+  public:
+    explicit immapstream(const std::string& path);
+    ~immapstream() override = default;
+
+    bool is_open() const;
+
+  private:
+    mmapbuf buf_;
+};
+
+inline mmapbuf::mmapbuf(const std::string& path) : std::streambuf() {
+  data_ = nullptr;
+  size_ = 0;
+
+  const auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return;
+  }
+  struct stat st;
+  if ((::fstat(fd, &st) == 0) && (st.st_size > 0)) {
+    auto* ptr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr != MAP_FAILED) {
+      data_ = static_cast<char_type*>(ptr);
+      size_ = st.st_size;
+      setg(data_, data_, data_+size_);
+    }
+  }
+  ::close(fd);
+}
+
+inline mmapbuf::~mmapbuf() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+}
+
+inline bool mmapbuf::is_open() const {
+  return data_ != nullptr;
+}
+
+inline mmapbuf::pos_type mmapbuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in) || (data_ == nullptr)) {
+    return pos_type(off_type(-1));
+  }
+  off_type base = 0;
+  if (dir == std::ios_base::cur) {
+    base = gptr() - eback();
+  } else if (dir == std::ios_base::end) {
+    base = size_;
+  } 
+  return seekpos(pos_type(base + off), which);
+}
+
+inline mmapbuf::pos_type mmapbuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+  const auto p = off_type(pos);
+  if (!(which & std::ios_base::in) || (data_ == nullptr) || (p < 0) || (p > off_type(size_))) {
+    return pos_type(off_type(-1));
+  }
+  setg(data_, data_+p, data_+size_);
+  return pos;
+}
+
+inline immapstream::immapstream(const std::string& path) : std::istream(&buf_), buf_(path) { 
+  if (!buf_.is_open()) {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+inline bool immapstream::is_open() const {
+  return buf_.is_open();
+}
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,116 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_MPSC_QUEUE_H
+#define CASCADE_SRC_COMMON_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace cascade {
+
+// This class is an unbounded, lock-free, multi-producer single-consumer fifo.
+// Any thread may call push(). Only one thread at a time may call empty() or
+// pop(). Producers publish elements with a single atomic exchange, and the
+// consumer never blocks. A push() which is in progress may not be visible to
+// the consumer until it completes, in which case pop() reports the queue as
+// empty.
+
+template <typename T>
+class MpscQueue {
+  public:
+    MpscQueue();
+    ~MpscQueue();
+
+    // Producer Interface:
+    void push(T t);
+
+    // Consumer Interface:
+    bool empty() const;
+    bool pop(T& t);
+
+  private:
+    struct Node {
+      std::atomic<Node*> next;
+      T val;
+    };
+
+    // Producers append to head_. The consumer reads from the node after
+    // tail_, which is always a placeholder whose value has been consumed.
+    std::atomic<Node*> head_;
+    Node* tail_;
+};
+
+template <typename T>
+inline MpscQueue<T>::MpscQueue() {
+  tail_ = new Node();
+  tail_->next.store(nullptr, std::memory_order_relaxed);
+  head_.store(tail_, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline MpscQueue<T>::~MpscQueue() {
+  for (auto* n = tail_; n != nullptr; ) {
+    auto* next = n->next.load(std::memory_order_relaxed);
+    delete n;
+    n = next;
+  }
+}
+
+template <typename T>
+inline void MpscQueue<T>::push(T t) {
+  auto* n = new Node();
+  n->next.store(nullptr, std::memory_order_relaxed);
+  n->val = std::move(t);
+  auto* prev = head_.exchange(n, std::memory_order_acq_rel);
+  prev->next.store(n, std::memory_order_release);
+}
+
+template <typename T>
+inline bool MpscQueue<T>::empty() const {
+  return tail_->next.load(std::memory_order_relaxed) == nullptr;
+}
+
+template <typename T>
+inline bool MpscQueue<T>::pop(T& t) {
+  auto* next = tail_->next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    return false;
+  }
+  t = std::move(next->val);
+  next->val = T();
+  delete tail_;
+  tail_ = next;
+  return true;
+}
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,174 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef CASCADE_SRC_COMMON_SHA256_H
+#define CASCADE_SRC_COMMON_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace cascade {
+
+// A self-contained implementation of SHA-256 (FIPS 180-4). Unlike std::hash,
+// its output is the same for every build and on every host, so it's safe to
+// use for identifying content which outlives the process that wrote it.
+
+class Sha256 {
+  public:
+    // Constructors:
+    Sha256();
+
+    // Appends data to the message:
+    Sha256& update(const char* data, size_t n);
+    Sha256& update(const std::string& s);
+
+    // Returns the 32-byte digest of the message. Further updates are
+    // undefined until the next call to reset().
+    std::string digest();
+    // Returns the digest as 64 lowercase hex digits
+    std::string hexdigest();
+    // Discards the message
+    void reset();
+
+  private:
+    uint32_t h_[8];
+    uint8_t block_[64];
+    size_t used_;
+    uint64_t length_;
+
+    void compress();
+    static uint32_t rotr(uint32_t x, size_t n);
+};
+
+inline Sha256::Sha256() {
+  reset();
+}
+
+inline Sha256& Sha256::update(const char* data, size_t n) {
+  length_ += n;
+  for (size_t i = 0; i < n; ++i) {
+    block_[used_++] = static_cast<uint8_t>(data[i]);
+    if (used_ == 64) {
+      compress();
+      used_ = 0;
+    }
+  }
+  return *this;
+}
+
+inline Sha256& Sha256::update(const std::string& s) {
+  return update(s.data(), s.length());
+}
+
+inline std::string Sha256::digest() {
+  // Pad with a one bit, zeros, and the message length in bits (big endian)
+  const auto bits = length_ * 8;
+  block_[used_++] = 0x80;
+  if (used_ > 56) {
+    while (used_ < 64) {
+      block_[used_++] = 0;
+    }
+    compress();
+    used_ = 0;
+  }
+  while (used_ < 56) {
+    block_[used_++] = 0;
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    block_[56+i] = static_cast<uint8_t>(bits >> (56 - 8*i));
+  }
+  compress();
+  used_ = 0;
+
+  std::string res(32, '\0');
+  for (size_t i = 0; i < 32; ++i) {
+    res[i] = static_cast<char>(h_[i/4] >> (24 - 8*(i%4)));
+  }
+  return res;
+}
+
+inline std::string Sha256::hexdigest() {
+  static const char* digits = "0123456789abcdef";
+  std::string res;
+  for (auto c : digest()) {
+    res += digits[static_cast<uint8_t>(c) >> 4];
+    res += digits[static_cast<uint8_t>(c) & 0xf];
+  }
+  return res;
+}
+
+inline void Sha256::reset() {
+  h_[0] = 0x6a09e667; h_[1] = 0xbb67ae85; h_[2] = 0x3c6ef372; h_[3] = 0xa54ff53a;
+  h_[4] = 0x510e527f; h_[5] = 0x9b05688c; h_[6] = 0x1f83d9ab; h_[7] = 0x5be0cd19;
+  used_ = 0;
+  length_ = 0;
+}
+
+inline void Sha256::compress() {
+  static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+  uint32_t w[64];
+  for (size_t i = 0; i < 16; ++i) {
+    w[i] = (static_cast<uint32_t>(block_[4*i]) << 24) | (static_cast<uint32_t>(block_[4*i+1]) << 16) |
+           (static_cast<uint32_t>(block_[4*i+2]) << 8) | static_cast<uint32_t>(block_[4*i+3]);
+  }
+  for (size_t i = 16; i < 64; ++i) {
+    const auto s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+    const auto s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+    w[i] = w[i-16] + s0 + w[i-7] + s1;
+  }
+
+  auto a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+  for (size_t i = 0; i < 64; ++i) {
+    const auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+    const auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  h_[0] += a; h_[1] += b; h_[2] += c; h_[3] += d;
+  h_[4] += e; h_[5] += f; h_[6] += g; h_[7] += h;
+}
+
+inline uint32_t Sha256::rotr(uint32_t x, size_t n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,404 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_SIMD_H
+#define CASCADE_SRC_COMMON_SIMD_H
+
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace cascade {
+
+// This class provides vectorized kernels for operations on wide bit strings.
+// Kernels operate on byte arrays so that they can be shared between word
+// sizes. On x86, AVX2 kernels are selected at runtime when the host supports
+// them, and SSE2 kernels are used otherwise. Everywhere else, kernels fall
+// back on scalar code.
+
+struct Simd {
+  // Returns true if arrays of n bytes are wide enough to benefit from these
+  // kernels. Narrower arrays should be handled inline by the caller.
+  static bool profitable(size_t n);
+
+  // Bitwise Operators: r = a op b
+  static void bitwise_and(void* r, const void* a, const void* b, size_t n);
+  static void bitwise_or(void* r, const void* a, const void* b, size_t n);
+  static void bitwise_xor(void* r, const void* a, const void* b, size_t n);
+  static void bitwise_xnor(void* r, const void* a, const void* b, size_t n);
+  static void bitwise_not(void* r, const void* a, size_t n);
+
+  // Reductions:
+  static bool all_ones(const void* a, size_t n);
+  static bool any(const void* a, size_t n);
+  static size_t popcount(const void* a, size_t n);
+  static bool equal(const void* a, const void* b, size_t n);
+
+  private:
+    enum class Op : uint8_t {
+      AND = 0, OR, XOR, XNOR, NOT
+    };
+
+    // Returns true if the host supports AVX2
+    static bool avx2();
+
+    template <Op op>
+    static uint8_t apply(uint8_t a, uint8_t b);
+    template <Op op>
+    static void binary(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n);
+    template <Op op>
+    static void binary_scalar(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n);
+    static size_t popcount_scalar(const uint8_t* a, size_t n);
+
+    #if defined(__SSE2__)
+    template <Op op>
+    static void binary_sse2(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n);
+    static bool all_ones_sse2(const uint8_t* a, size_t n);
+    static bool any_sse2(const uint8_t* a, size_t n);
+    static bool equal_sse2(const uint8_t* a, const uint8_t* b, size_t n);
+    #endif
+
+    #if defined(__x86_64__) || defined(__i386__)
+    template <Op op>
+    __attribute__((target("avx2"))) static void binary_avx2(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n);
+    __attribute__((target("avx2"))) static bool all_ones_avx2(const uint8_t* a, size_t n);
+    __attribute__((target("avx2"))) static bool any_avx2(const uint8_t* a, size_t n);
+    __attribute__((target("avx2"))) static size_t popcount_avx2(const uint8_t* a, size_t n);
+    __attribute__((target("avx2"))) static bool equal_avx2(const uint8_t* a, const uint8_t* b, size_t n);
+    #endif
+};
+
+inline bool Simd::profitable(size_t n) {
+  return n >= 32;
+}
+
+inline void Simd::bitwise_and(void* r, const void* a, const void* b, size_t n) {
+  binary<Op::AND>(static_cast<uint8_t*>(r), static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), n);
+}
+
+inline void Simd::bitwise_or(void* r, const void* a, const void* b, size_t n) {
+  binary<Op::OR>(static_cast<uint8_t*>(r), static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), n);
+}
+
+inline void Simd::bitwise_xor(void* r, const void* a, const void* b, size_t n) {
+  binary<Op::XOR>(static_cast<uint8_t*>(r), static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), n);
+}
+
+inline void Simd::bitwise_xnor(void* r, const void* a, const void* b, size_t n) {
+  binary<Op::XNOR>(static_cast<uint8_t*>(r), static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), n);
+}
+
+inline void Simd::bitwise_not(void* r, const void* a, size_t n) {
+  binary<Op::NOT>(static_cast<uint8_t*>(r), static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(a), n);
+}
+
+inline bool Simd::all_ones(const void* a, size_t n) {
+  const auto* pa = static_cast<const uint8_t*>(a);
+  #if defined(__x86_64__) || defined(__i386__)
+  if (avx2()) {
+    return all_ones_avx2(pa, n);
+  }
+  #endif
+  #if defined(__SSE2__)
+  return all_ones_sse2(pa, n);
+  #else
+  for (size_t i = 0; i < n; ++i) {
+    if (pa[i] != 0xff) {
+      return false;
+    }
+  }
+  return true;
+  #endif
+}
+
+inline bool Simd::any(const void* a, size_t n) {
+  const auto* pa = static_cast<const uint8_t*>(a);
+  #if defined(__x86_64__) || defined(__i386__)
+  if (avx2()) {
+    return any_avx2(pa, n);
+  }
+  #endif
+  #if defined(__SSE2__)
+  return any_sse2(pa, n);
+  #else
+  for (size_t i = 0; i < n; ++i) {
+    if (pa[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+  #endif
+}
+
+inline size_t Simd::popcount(const void* a, size_t n) {
+  const auto* pa = static_cast<const uint8_t*>(a);
+  #if defined(__x86_64__) || defined(__i386__)
+  if (avx2()) {
+    return popcount_avx2(pa, n);
+  }
+  #endif
+  return popcount_scalar(pa, n);
+}
+
+inline bool Simd::equal(const void* a, const void* b, size_t n) {
+  const auto* pa = static_cast<const uint8_t*>(a);
+  const auto* pb = static_cast<const uint8_t*>(b);
+  #if defined(__x86_64__) || defined(__i386__)
+  if (avx2()) {
+    return equal_avx2(pa, pb, n);
+  }
+  #endif
+  #if defined(__SSE2__)
+  return equal_sse2(pa, pb, n);
+  #else
+  return memcmp(pa, pb, n) == 0;
+  #endif
+}
+
+inline bool Simd::avx2() {
+  #if defined(__x86_64__) || defined(__i386__)
+  static const bool res = __builtin_cpu_supports("avx2");
+  return res;
+  #else
+  return false;
+  #endif
+}
+
+template <Simd::Op op>
+inline uint8_t Simd::apply(uint8_t a, uint8_t b) {
+  switch (op) {
+    case Op::AND:  return a & b;
+    case Op::OR:   return a | b;
+    case Op::XOR:  return a ^ b;
+    case Op::XNOR: return ~(a ^ b);
+    case Op::NOT:  return ~a;
+    default:       return 0;
+  }
+}
+
+template <Simd::Op op>
+inline void Simd::binary(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n) {
+  #if defined(__x86_64__) || defined(__i386__)
+  if (avx2()) {
+    return binary_avx2<op>(r, a, b, n);
+  }
+  #endif
+  #if defined(__SSE2__)
+  binary_sse2<op>(r, a, b, n);
+  #else
+  binary_scalar<op>(r, a, b, n);
+  #endif
+}
+
+template <Simd::Op op>
+inline void Simd::binary_scalar(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    r[i] = apply<op>(a[i], b[i]);
+  }
+}
+
+inline size_t Simd::popcount_scalar(const uint8_t* a, size_t n) {
+  size_t cnt = 0;
+  size_t i = 0;
+  for (; (i+8) <= n; i += 8) {
+    uint64_t w;
+    memcpy(&w, a+i, 8);
+    cnt += __builtin_popcountll(w);
+  }
+  for (; i < n; ++i) {
+    cnt += __builtin_popcount(a[i]);
+  }
+  return cnt;
+}
+
+#if defined(__SSE2__)
+template <Simd::Op op>
+inline void Simd::binary_sse2(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n) {
+  const auto ones = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; (i+16) <= n; i += 16) {
+    const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i));
+    const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+i));
+    __m128i z;
+    switch (op) {
+      case Op::AND:  z = _mm_and_si128(x, y); break;
+      case Op::OR:   z = _mm_or_si128(x, y); break;
+      case Op::XOR:  z = _mm_xor_si128(x, y); break;
+      case Op::XNOR: z = _mm_xor_si128(_mm_xor_si128(x, y), ones); break;
+      default:       z = _mm_xor_si128(x, ones); break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(r+i), z);
+  }
+  binary_scalar<op>(r+i, a+i, b+i, n-i);
+}
+
+inline bool Simd::all_ones_sse2(const uint8_t* a, size_t n) {
+  const auto ones = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; (i+16) <= n; i += 16) {
+    const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, ones)) != 0xffff) {
+      return false;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != 0xff) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline bool Simd::any_sse2(const uint8_t* a, size_t n) {
+  const auto zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; (i+16) <= n; i += 16) {
+    const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) != 0xffff) {
+      return true;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool Simd::equal_sse2(const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; (i+16) <= n; i += 16) {
+    const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i));
+    const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xffff) {
+      return false;
+    }
+  }
+  return memcmp(a+i, b+i, n-i) == 0;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+template <Simd::Op op>
+__attribute__((target("avx2"))) inline void Simd::binary_avx2(uint8_t* r, const uint8_t* a, const uint8_t* b, size_t n) {
+  const auto ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; (i+32) <= n; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+    __m256i z;
+    switch (op) {
+      case Op::AND:  z = _mm256_and_si256(x, y); break;
+      case Op::OR:   z = _mm256_or_si256(x, y); break;
+      case Op::XOR:  z = _mm256_xor_si256(x, y); break;
+      case Op::XNOR: z = _mm256_xor_si256(_mm256_xor_si256(x, y), ones); break;
+      default:       z = _mm256_xor_si256(x, ones); break;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r+i), z);
+  }
+  binary_scalar<op>(r+i, a+i, b+i, n-i);
+}
+
+__attribute__((target("avx2"))) inline bool Simd::all_ones_avx2(const uint8_t* a, size_t n) {
+  const auto ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; (i+32) <= n; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    if (!_mm256_testc_si256(x, ones)) {
+      return false;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != 0xff) {
+      return false;
+    }
+  }
+  return true;
+}
+
+__attribute__((target("avx2"))) inline bool Simd::any_avx2(const uint8_t* a, size_t n) {
+  size_t i = 0;
+  for (; (i+32) <= n; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    if (!_mm256_testz_si256(x, x)) {
+      return true;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+__attribute__((target("avx2"))) inline size_t Simd::popcount_avx2(const uint8_t* a, size_t n) {
+  // Counts bits a nibble at a time using a shuffle as a lookup table, and
+  // then sums byte counts into 64-bit lanes.
+  const auto lut = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+  );
+  const auto low = _mm256_set1_epi8(0x0f);
+  auto acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; (i+32) <= n; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    const auto lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, low));
+    const auto hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + popcount_scalar(a+i, n-i);
+}
+
+__attribute__((target("avx2"))) inline bool Simd::equal_avx2(const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; (i+32) <= n; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+    const auto z = _mm256_xor_si256(x, y);
+    if (!_mm256_testz_si256(z, z)) {
+      return false;
+    }
+  }
+  return memcmp(a+i, b+i, n-i) == 0;
+}
+#endif
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,365 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_SMALL_VECTOR_H
+#define CASCADE_SRC_COMMON_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace cascade {
+
+// This class is a variant of Vector which stores up to N elements inline, and
+// only allocates storage on the heap when its size exceeds N. The inline
+// buffer shares space with the heap pointer, so choosing N such that
+// N*sizeof(T) <= sizeof(T*) provides inline storage for free. Like Vector, it
+// assumes no more than 2^16 elements, and is restricted to trivially copyable
+// types, which allows storage to be moved with a bitwise copy.
+
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(N > 0, "SmallVector requires a non-empty inline buffer");
+  static_assert(std::is_trivially_copyable<T>::value, "SmallVector requires a trivially copyable type");
+
+  public:
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* iterator;
+    typedef const T* const_iterator; 
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T value_type;
+
+    SmallVector();
+    SmallVector(size_type n, const value_type& v = value_type());
+    SmallVector(const SmallVector& rhs);
+    SmallVector(SmallVector&& rhs);
+    SmallVector& operator=(const SmallVector& rhs);
+    SmallVector& operator=(SmallVector&& rhs);
+    ~SmallVector();
+
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+
+    size_type size() const;
+    void resize(size_type n, const value_type& v = value_type());
+    size_type capacity() const;
+    bool empty() const;
+    void reserve(size_type n);
+
+    reference operator[](size_t idx);
+    const_reference operator[](size_t idx) const;
+
+    reference front();
+    const_reference front() const;
+    reference back();
+    const_reference back() const;
+    pointer data();
+    const_pointer data() const;
+
+    void push_back(const value_type& v);
+    void pop_back();
+
+    iterator insert(iterator itr, const value_type& v);
+    iterator insert(iterator itr, size_type n, const value_type& v);
+    template <typename Itr>
+    iterator insert(iterator itr, Itr rb, Itr re);
+
+    iterator erase(iterator itr);
+
+    void swap(SmallVector& rhs);
+    void clear();
+
+  private:
+    union Storage {
+      T* ts_;
+      T buf_[N];
+    };
+    Storage s_;
+    uint16_t size_;
+    uint16_t capacity_;
+
+    // Returns true if elements are stored inline
+    bool is_inline() const;
+};
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector() {
+  s_.ts_ = nullptr;
+  size_ = 0;
+  capacity_ = N;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(size_type n, const value_type& val) : SmallVector() {
+  insert(end(), n, val);
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(const SmallVector& rhs) : SmallVector() {
+  insert(end(), rhs.begin(), rhs.end());
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::SmallVector(SmallVector&& rhs) : SmallVector() {
+  swap(rhs);
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>& SmallVector<T,N>::operator=(const SmallVector& rhs) {
+  // Reuse existing storage whenever possible. This is the common case for
+  // assignments between values of the same width.
+  if (this != &rhs) {
+    reserve(rhs.size_);
+    std::copy(rhs.begin(), rhs.end(), begin());
+    size_ = rhs.size_;
+  }
+  return *this;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>& SmallVector<T,N>::operator=(SmallVector&& rhs) {
+  swap(rhs);
+  return *this;
+}
+
+template <typename T, size_t N>
+inline SmallVector<T,N>::~SmallVector() {
+  if (!is_inline()) {
+    delete[] s_.ts_;
+  }
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::begin() {
+  return is_inline() ? s_.buf_ : s_.ts_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_iterator SmallVector<T,N>::begin() const {
+  return is_inline() ? s_.buf_ : s_.ts_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::end() {
+  return begin() + size_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_iterator SmallVector<T,N>::end() const {
+  return begin() + size_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::size_type SmallVector<T,N>::size() const {
+  return size_;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::resize(size_type n, const value_type& v) {
+  assert(n <= static_cast<size_t>(0xffffu));
+  if (n <= size_) {
+    size_ = n;
+  } else {
+    insert(end(), n - size_, v);
+  }
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::size_type SmallVector<T,N>::capacity() const {
+  return capacity_;
+}
+
+template <typename T, size_t N>
+inline bool SmallVector<T,N>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::reserve(size_type n) {
+  assert(n <= static_cast<size_t>(0xffffu));
+  if (capacity_ >= n) {
+    return;
+  }
+  auto new_ts = new T[n];
+  std::copy(begin(), end(), new_ts);
+  if (!is_inline()) {
+    delete[] s_.ts_;
+  }
+  s_.ts_ = new_ts; 
+  capacity_ = n;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::operator[](size_t idx) {
+  assert(idx < size_);
+  return begin()[idx];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::operator[](size_t idx) const {
+  assert(idx < size_);
+  return begin()[idx];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::front() {
+  assert(size_ > 0);
+  return begin()[0];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::front() const {
+  assert(size_ > 0);
+  return begin()[0];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::reference SmallVector<T,N>::back() {
+  assert(size_ > 0);
+  return begin()[size_ - 1];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_reference SmallVector<T,N>::back() const {
+  assert(size_ > 0);
+  return begin()[size_ - 1];
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::pointer SmallVector<T,N>::data() {
+  return begin();
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::const_pointer SmallVector<T,N>::data() const {
+  return begin();
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::push_back(const value_type& v) {
+  if (size_ < capacity_) {
+    begin()[size_++] = v;
+  } else {
+    insert(end(), v);
+  }
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::pop_back() {
+  assert(size_ > 0);
+  --size_;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::insert(iterator itr, const value_type& v) {
+  return insert(itr, 1, v);
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::insert(iterator itr, size_type n, const value_type& v) {
+  assert(itr >= begin());
+  assert(itr <= end());
+
+  // Copy v before reserving, in case it refers to an element of this vector
+  const auto val = v;
+  const auto delta = itr - begin();
+  reserve(size_ + n);
+  itr = begin() + delta;
+
+  std::copy_backward(itr, end(), end()+n);
+  std::fill_n(itr, n, val);
+  size_ += n;
+
+  return itr + n;
+}
+
+template <typename T, size_t N>
+template <typename Itr>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::insert(iterator itr, Itr rb, Itr re) {
+  assert(itr >= begin());
+  assert(itr <= end());
+  assert(re >= rb);
+
+  const size_type n = re-rb;
+  if (n == 0) {
+    return itr;
+  }
+
+  const auto delta = itr - begin();
+  reserve(size_ + n);
+  itr = begin() + delta;
+
+  std::copy_backward(itr, end(), end()+n);
+  std::copy(rb, re, itr);
+  size_ += n;
+
+  return itr + n;
+}
+
+template <typename T, size_t N>
+inline typename SmallVector<T,N>::iterator SmallVector<T,N>::erase(iterator itr) {
+  assert(itr >= begin());
+  assert(itr < end());
+
+  std::copy(itr + 1, end(), itr);
+  --size_; 
+  return itr;
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::swap(SmallVector& rhs) {
+  // Storage is either a pointer or a buffer of trivially copyable elements,
+  // so either way it can be exchanged with a bitwise copy.
+  std::swap(s_, rhs.s_);
+  std::swap(size_, rhs.size_);
+  std::swap(capacity_, rhs.capacity_);
+}
+
+template <typename T, size_t N>
+inline void SmallVector<T,N>::clear() {
+  size_ = 0;
+}
+
+template <typename T, size_t N>
+inline bool SmallVector<T,N>::is_inline() const {
+  return capacity_ <= N;
+}
+
+} // namespace cascade
+
+#endif
@@ -33,6 +33,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <csignal>
 #include <cstdlib>
 #include <string>
 #include <sys/wait.h>
@@ -55,6 +56,9 @@ struct System {
 
   // Invokes the execute() command and returns its exit value
   static int execute(const std::string& cmd);
+  // Invokes cmd, stores its standard output in output, and returns its exit
+  // value. Returns -1 if cmd couldn't be started.
+  static int capture(const std::string& cmd, std::string* output);
   // Forks a process and returns its pid, setting verbose to false will
   // redirect all output to /dev/null. Unlike execute(), this method will not
   // prevent sigint and sigkill from reaching the main thread
@@ -64,10 +68,17 @@ struct System {
   // Convenience method, invokes no_block_begin_execute and then blocks on
   // the result.
   static int no_block_execute(const std::string& cmd, bool verbose);
+  // Kills pid along with all of its descendants. Descendants are stopped
+  // before we look for their children so that they can't spawn new ones
+  // behind our back. Pid itself is left running until the end, since that
+  // would wake up a call to no_block_wait_finish().
+  static void kill_tree(pid_t pid);
 
   // Returns constants which were defined when cmake was invoked
   static std::string c_compiler();
   static std::string cxx_compiler();
+  static std::string install_prefix();
+  static std::string source_dir();
 };
 
 #ifdef __APPLE__
@@ -100,6 +111,19 @@ inline int System::execute(const std::string& cmd) {
   return std::system(cmd.c_str());
 }
 
+inline int System::capture(const std::string& cmd, std::string* output) {
+  output->clear();
+  auto* p = popen(cmd.c_str(), "r");
+  if (p == nullptr) {
+    return -1;
+  }
+  char buffer[1024];
+  for (size_t n = 0; (n = fread(buffer, 1, 1024, p)) > 0; ) {
+    output->append(buffer, n);
+  }
+  return pclose(p);
+}
+
 inline pid_t System::no_block_begin_execute(const std::string& cmd, bool verbose) {
   const auto pid = fork();
   if (pid == 0) {
@@ -131,6 +155,17 @@ inline int System::no_block_execute(const std::string& cmd, bool verbose) {
   return no_block_wait_finish(no_block_begin_execute(cmd, verbose));
 }
 
+inline void System::kill_tree(pid_t pid) {
+  std::string children;
+  capture("pgrep -P " + std::to_string(pid), &children);
+  for (size_t i = 0, ie = children.find('\n'); ie != std::string::npos; i = ie+1, ie = children.find('\n', i)) {
+    const auto c = static_cast<pid_t>(std::stol(children.substr(i, ie-i)));
+    kill(c, SIGSTOP);
+    kill_tree(c);
+  }
+  kill(pid, SIGKILL);
+}
+
 inline std::string System::c_compiler() {
   return CMAKE_C_COMPILER;
 }
@@ -139,6 +174,14 @@ inline std::string System::cxx_compiler() {
   return CMAKE_CXX_COMPILER;
 }
 
+inline std::string System::install_prefix() {
+  return CMAKE_INSTALL_PREFIX;
+}
+
+inline std::string System::source_dir() {
+  return CMAKE_SOURCE_DIR;
+}
+
 } // namespace cascade
 
 #endif
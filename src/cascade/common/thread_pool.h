@@ -31,11 +31,14 @@
 #ifndef CASCADE_SRC_COMMON_THREAD_POOL_H
 #define CASCADE_SRC_COMMON_THREAD_POOL_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <stack>
 #include <thread>
 #include <vector>
 #include "common/thread.h"
@@ -45,21 +48,40 @@ namespace cascade {
 // This class represents an abstract pool of compute. It is provided so that
 // objects can schedule Jobs (ie: methods returning void which can be handled
 // asynchronously) and block on their completion.
+//
+// Each worker owns a set of deques, one per priority class. Jobs scheduled
+// by a worker are placed on its own deques, and all other jobs are dealt out
+// round robin. Workers always run the highest priority job available, taking
+// the newest job from their own deques first and stealing the oldest job from
+// someone else's otherwise. Pushing and popping only ever takes the lock of
+// the deques being operated on. The pool-wide lock is only taken by workers
+// which have run out of jobs and are about to go to sleep, and by producers
+// which need to wake them up.
 
 class ThreadPool : public Thread {
   public:
     // Job Typedef:
     typedef std::function<void()> Job;
 
+    // Priority Classes:
+    enum class Priority : uint8_t {
+      HIGH = 0,
+      NORMAL,
+      LOW
+    };
+
     // Constructors:
     ThreadPool();
     ~ThreadPool() override = default;
 
     // Parameter Interface:
+    //
+    // This method should only be invoked while the pool is stopped.
     ThreadPool& set_num_threads(size_t n);
 
-    // Schedule a new job. Ignores jobs scheduled between stop() and start().
-    void insert(Job job);
+    // Schedule a new job. Jobs scheduled while the pool is stopped run when
+    // it is next started.
+    void insert(Job job, Priority p = Priority::NORMAL);
 
   protected:
     // Start a new pool of num_threads_ threads.
@@ -68,68 +90,142 @@ class ThreadPool : public Thread {
     void stop_logic() override;
   
   private:
+    struct Queue {
+      std::mutex lock;
+      std::deque<Job> jobs[3];
+    };
+
     std::mutex lock_;
     std::condition_variable cv_;
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> sleeping_;
+    std::atomic<size_t> next_;
 
     size_t num_threads_;
     std::vector<std::thread> threads_;
-    std::stack<Job> jobs_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    // The pool and index of the worker running on this thread, if any
+    static thread_local ThreadPool* pool_;
+    static thread_local size_t index_;
 
-    std::pair<bool, Job> get();
+    bool get(size_t i, Job& job);
+    bool reserve();
+    bool take(size_t i, Job& job);
 };
 
+inline thread_local ThreadPool* ThreadPool::pool_ = nullptr;
+inline thread_local size_t ThreadPool::index_ = 0;
+
 inline ThreadPool::ThreadPool() : Thread() {
+  pending_ = 0;
+  sleeping_ = 0;
+  next_ = 0;
   set_num_threads(1);
 }
 
 inline ThreadPool& ThreadPool::set_num_threads(size_t n) {
   num_threads_ = n;
+  // Keep at least one set of deques around so that jobs can be scheduled
+  // even when there aren't any workers to run them.
+  for (auto i = queues_.size(), ie = std::max(n, static_cast<size_t>(1)); i < ie; ++i) {
+    queues_.emplace_back(new Queue());
+  }
   return *this;
 }
 
-inline void ThreadPool::insert(Job job) {
-  {
-    std::lock_guard<std::mutex> lg(lock_);
-    jobs_.push(job);
+inline void ThreadPool::insert(Job job, Priority p) {
+  const auto i = (pool_ == this) ? index_ : (next_++ % queues_.size());
+  auto* q = queues_[i].get();
+  { std::lock_guard<std::mutex> lg(q->lock);
+    q->jobs[static_cast<size_t>(p)].push_back(std::move(job));
+  }
+  // The job is published before it's counted, so every count corresponds to
+  // a job which can be taken. Workers announce themselves before going to
+  // sleep and check the count afterwards, so either they'll see this job or
+  // we'll see them and wake one up.
+  ++pending_;
+  if (sleeping_ > 0) {
+    { std::lock_guard<std::mutex> lg(lock_);
+    }
+    cv_.notify_one();
   }
-  cv_.notify_one();
 }
 
 inline void ThreadPool::run_logic() {
   for (size_t i = 0; i < num_threads_; ++i) {
-    threads_.push_back(std::thread([this]{
-      while (true) {
-        auto job = get();
-        if (job.first) {
-          job.second();
-        } else {
-          return;
-        }
+    threads_.push_back(std::thread([this, i]{
+      pool_ = this;
+      index_ = i;
+      for (Job job; get(i, job); ) {
+        job();
+        job = nullptr;
       }
     }));
   }  
 }
 
 inline void ThreadPool::stop_logic() {
+  { std::lock_guard<std::mutex> lg(lock_);
+  }
   cv_.notify_all();
   for (auto& t : threads_) {
     t.join(); 
   }
-  assert(jobs_.empty());
+  assert(pending_ == 0);
   threads_.clear();
 }
 
-inline std::pair<bool, ThreadPool::Job> ThreadPool::get() {
-  std::unique_lock<std::mutex> ul(lock_);
-  while (jobs_.empty() && !stop_requested()) {
-    cv_.wait(ul);
+inline bool ThreadPool::get(size_t i, Job& job) {
+  // Reserve a job before looking for one. Every reservation corresponds to a
+  // job which hasn't been taken yet, so the search below always succeeds.
+  // Sleep if there's nothing to reserve, and give up once a stop has been
+  // requested and every job has run.
+  while (!reserve()) {
+    std::unique_lock<std::mutex> ul(lock_);
+    ++sleeping_;
+    cv_.wait(ul, [this]{ return (pending_ > 0) || stop_requested(); });
+    --sleeping_;
+    if (pending_ == 0) {
+      return false;
+    }
   }
-  if (!jobs_.empty()) {
-    auto res = jobs_.top();
-    jobs_.pop();
-    return std::make_pair(true, res);
+  while (!take(i, job)) {
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+inline bool ThreadPool::reserve() {
+  for (auto n = pending_.load(); n > 0; ) {
+    if (pending_.compare_exchange_weak(n, n-1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool ThreadPool::take(size_t i, Job& job) {
+  const auto n = queues_.size();
+  for (size_t p = 0; p < 3; ++p) {
+    for (size_t k = 0; k < n; ++k) {
+      auto* q = queues_[(i+k) % n].get();
+      std::lock_guard<std::mutex> lg(q->lock);
+      auto& jobs = q->jobs[p];
+      if (jobs.empty()) {
+        continue;
+      }
+      if (k == 0) {
+        job = std::move(jobs.back());
+        jobs.pop_back();
+      } else {
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      return true;
+    }
   }
-  return std::make_pair(false, Job());
+  return false;
 }
 
 } // namespace cascade
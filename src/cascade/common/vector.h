@@ -40,7 +40,9 @@ namespace cascade {
 
 // This class a space-optimized implementation of std::vector. It assumes no
 // more than 2^16 elements, and won't over-provision when a call to resize
-// exceeds capacity.
+// exceeds capacity. A vector can also be pointed at storage which it does not
+// own (see borrow()). It will continue to use that storage until it needs to
+// grow beyond its capacity.
 
 template <typename T>
 class Vector {
@@ -96,10 +98,16 @@ class Vector {
     void swap(Vector& rhs);
     void clear();
 
+    // Copies the contents of this vector into ts, which must have room for at
+    // least size() elements, and continues to use ts as storage. The caller
+    // is responsible for ensuring that ts outlives this vector.
+    void borrow(pointer ts);
+
   private:
     T* ts_;
     uint16_t size_;
     uint16_t capacity_;    
+    bool owns_;
 };
 
 template <typename T>
@@ -107,6 +115,7 @@ inline Vector<T>::Vector() {
   ts_ = nullptr; 
   size_ = 0;
   capacity_ = 0;
+  owns_ = true;
 }
 
 template <typename T>
@@ -132,7 +141,7 @@ inline Vector<T>& Vector<T>::operator=(Vector rhs) {
 
 template <typename T>
 inline Vector<T>::~Vector() {
-  if (ts_ != nullptr) {
+  if (owns_ && (ts_ != nullptr)) {
     delete[] ts_;
   }
 }
@@ -191,10 +200,13 @@ inline void Vector<T>::reserve(size_type n) {
   auto new_ts = new T[n];
   if (ts_ != nullptr) {
     std::copy(ts_, ts_ + size_, new_ts);
-    delete[] ts_;
+    if (owns_) {
+      delete[] ts_;
+    }
   }
   ts_ = new_ts; 
   capacity_ = n;
+  owns_ = true;
 }
 
 template <typename T>
@@ -349,6 +361,7 @@ inline void Vector<T>::swap(Vector& rhs) {
   std::swap(ts_, rhs.ts_);
   std::swap(size_, rhs.size_);
   std::swap(capacity_, rhs.capacity_);
+  std::swap(owns_, rhs.owns_);
 }
 
 template <typename T>
@@ -356,6 +369,18 @@ inline void Vector<T>::clear() {
   size_ = 0;
 }
 
+template <typename T>
+inline void Vector<T>::borrow(pointer ts) {
+  assert(ts != nullptr);
+  std::copy(ts_, ts_ + size_, ts);
+  if (owns_ && (ts_ != nullptr)) {
+    delete[] ts_;
+  }
+  ts_ = ts;
+  capacity_ = size_;
+  owns_ = false;
+}
+
 } // namespace cascade
 
 #endif
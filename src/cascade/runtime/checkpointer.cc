@@ -0,0 +1,248 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "runtime/checkpointer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sstream>
+#include <tuple>
+#include <unistd.h>
+#include "common/sha256.h"
+#include "target/input.h"
+#include "target/state.h"
+
+using namespace std;
+
+namespace cascade {
+
+Checkpointer::Checkpointer(const string& path) : Thread() {
+  path_ = path;
+  size_ = 0;
+  live_ = 0;
+  seq_ = 0;
+  back_ = nullptr;
+}
+
+Checkpointer::~Checkpointer() {
+  // Stop the writer thread before tearing down the state it depends on. Any
+  // snapshot which is still pending is written before it returns.
+  stop_now();
+  release(back_);
+}
+
+bool Checkpointer::ready() {
+  lock_guard<mutex> lg(lock_);
+  return back_ == nullptr;
+}
+
+void Checkpointer::write(Module::Snapshot* s) {
+  { lock_guard<mutex> lg(lock_);
+    release(back_);
+    back_ = s;
+  }
+  notify();
+}
+
+void Checkpointer::run_logic() {
+  while (!stop_requested()) {
+    auto* s = swap();
+    if (s == nullptr) {
+      wait_for(100);
+      continue;
+    }
+    flush(*s);
+    release(s);
+  }
+  // Don't lose the most recent snapshot on shutdown
+  if (auto* s = swap()) {
+    flush(*s);
+    release(s);
+  }
+}
+
+Module::Snapshot* Checkpointer::swap() {
+  lock_guard<mutex> lg(lock_);
+  auto* res = back_;
+  back_ = nullptr;
+  return res;
+}
+
+void Checkpointer::flush(const Module::Snapshot& s) {
+  // Serialize each module. This is the expensive part, and the reason we're
+  // running on this thread rather than the runtime's.
+  map<MId, string> payloads;
+  for (const auto& m : s) {
+    stringstream ss;
+    get<1>(m)->serialize(ss);
+    get<2>(m)->serialize(ss);
+    payloads[get<0>(m)] = ss.str();
+  }
+
+  // Incremental updates are only possible if the set of modules is the same
+  // as in the file on disk. 
+  auto same = (index_.size() == payloads.size()) && (size_ > 0);
+  auto j = payloads.begin();
+  for (auto i = index_.begin(); same && (i != index_.end()); ++i, ++j) {
+    same = (i->first == j->first);
+  }
+  if (same && ((size_ - live_) <= live_) && flush_incremental(payloads)) {
+    return;
+  }
+  if (!flush_full(payloads)) {
+    index_.clear();
+    size_ = 0;
+    live_ = 0;
+    seq_ = 0;
+  }
+}
+
+bool Checkpointer::flush_full(const map<MId, string>& payloads) {
+  // Write to a temporary file and then move it into place. This way there's
+  // always a complete checkpoint on disk, even if we crash midway through.
+  const auto tmp = path_ + ".tmp";
+  const auto fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    return false;
+  }
+
+  const uint32_t n = payloads.size();
+  index_.clear();
+  uint64_t offset = 16 + 2 * Module::checkpoint_slot_size(n);
+  for (const auto& p : payloads) {
+    auto& e = index_[p.first];
+    e.offset = offset;
+    e.length = p.second.length();
+    e.digest = Sha256().update(p.second).digest();
+    offset += e.length;
+  }
+
+  stringstream ss;
+  ss.write(Module::checkpoint_magic_, 8);
+  ss.write(reinterpret_cast<const char*>(&Module::checkpoint_version_), 4);
+  ss.write(reinterpret_cast<const char*>(&n), 4);
+  ss << Module::checkpoint_slot(1, index());
+  ss << string(Module::checkpoint_slot_size(n), '\0');
+
+  auto ok = write_at(fd, ss.str(), 0);
+  for (const auto& p : payloads) {
+    ok = ok && write_at(fd, p.second, index_[p.first].offset);
+  }
+  ok = ok && (fsync(fd) == 0);
+  ok = (close(fd) == 0) && ok;
+  if (!ok || (rename(tmp.c_str(), path_.c_str()) != 0)) {
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  size_ = offset;
+  live_ = offset;
+  seq_ = 1;
+  return true;
+}
+
+bool Checkpointer::flush_incremental(const map<MId, string>& payloads) {
+  const auto fd = ::open(path_.c_str(), O_WRONLY);
+  if (fd == -1) {
+    return false;
+  }
+
+  // Append the modules which have changed to the end of the file. Nothing in
+  // the index refers to this part of the file yet, so a crash here is harmless.
+  auto ok = true;
+  auto changed = false;
+  for (const auto& p : payloads) {
+    auto& e = index_[p.first];
+    auto d = Sha256().update(p.second).digest();
+    if ((e.length == p.second.length()) && (e.digest == d)) {
+      continue;
+    }
+    changed = true;
+    live_ = live_ - e.length + p.second.length();
+    e.offset = size_;
+    e.length = p.second.length();
+    e.digest = std::move(d);
+    ok = ok && write_at(fd, p.second, e.offset);
+    size_ += e.length;
+  }
+  if (!changed) {
+    close(fd);
+    return true;
+  }
+
+  // Point the older copy of the index at the new data, making sure that the
+  // data reaches the disk first. If we crash while the index is being
+  // written, its check won't match and restart falls back on the other copy.
+  const auto slot = 16 + (seq_ % 2) * Module::checkpoint_slot_size(index_.size());
+  ok = ok && (fsync(fd) == 0);
+  ok = ok && write_at(fd, Module::checkpoint_slot(seq_+1, index()), slot);
+  ok = ok && (fsync(fd) == 0);
+  ok = (close(fd) == 0) && ok;
+  if (ok) {
+    ++seq_;
+  }
+  return ok;
+}
+
+Module::CheckpointIndex Checkpointer::index() const {
+  Module::CheckpointIndex res;
+  for (const auto& e : index_) {
+    res.push_back(make_tuple(e.first, e.second.offset, e.second.length, e.second.digest));
+  }
+  return res;
+}
+
+bool Checkpointer::write_at(int fd, const string& s, uint64_t offset) {
+  for (size_t i = 0; i < s.length(); ) {
+    const auto res = pwrite(fd, s.data() + i, s.length() - i, offset + i);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    i += res;
+  }
+  return true;
+}
+
+void Checkpointer::release(Module::Snapshot* s) {
+  if (s == nullptr) {
+    return;
+  }
+  for (auto& m : *s) {
+    delete get<1>(m);
+    delete get<2>(m);
+  }
+  delete s;
+}
+
+} // namespace cascade
@@ -0,0 +1,101 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_RUNTIME_CHECKPOINTER_H
+#define CASCADE_SRC_RUNTIME_CHECKPOINTER_H
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include "common/thread.h"
+#include "runtime/ids.h"
+#include "runtime/module.h"
+
+namespace cascade {
+
+// Writes snapshots of a running program to disk in the format produced by
+// Module::save(). Snapshots are captured by the runtime thread and serialized
+// by this thread, so the simulation only pauses for as long as it takes to
+// copy state out of its engines. The first snapshot is written in full.
+// Subsequent snapshots append only those modules whose state has changed and
+// then overwrite the older of the file's two copies of the index. Both steps
+// are synced to disk in order, so a crash leaves at least one complete
+// checkpoint behind. The file is rewritten in full whenever the module
+// hierarchy changes or stale data begins to outweigh live data.
+
+class Checkpointer : public Thread {
+  public:
+    // Constructors:
+    explicit Checkpointer(const std::string& path);
+    ~Checkpointer() override;
+
+    // Returns true if a call to write() would be serviced immediately rather
+    // than replacing a snapshot which hasn't been written yet.
+    bool ready();
+    // Hands off a snapshot to be written. This method takes ownership of s
+    // and returns immediately.
+    void write(Module::Snapshot* s);
+
+  private:
+    // Index Entries:
+    struct Entry {
+      uint64_t offset;
+      uint64_t length;
+      std::string digest;
+    };
+
+    // Output State:
+    std::string path_;
+    std::map<MId, Entry> index_;
+    uint64_t size_;
+    uint64_t live_;
+    uint64_t seq_;
+
+    // Double Buffering:
+    std::mutex lock_;
+    Module::Snapshot* back_;
+
+    // Thread Interface:
+    void run_logic() override;
+
+    // Write Helpers:
+    Module::Snapshot* swap();
+    void flush(const Module::Snapshot& s);
+    bool flush_full(const std::map<MId, std::string>& payloads);
+    bool flush_incremental(const std::map<MId, std::string>& payloads);
+    Module::CheckpointIndex index() const;
+    static bool write_at(int fd, const std::string& s, uint64_t offset);
+    static void release(Module::Snapshot* s);
+};
+
+} // namespace cascade
+
+#endif
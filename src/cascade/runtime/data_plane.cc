@@ -37,8 +37,25 @@
 
 using namespace std;
 
+namespace {
+
+// The word type that Bits uses internally. Values which fit in a single word
+// can be compared and copied without going through the general purpose
+// (sign-extending, type-converting) paths in Bits.
+#ifdef __LP64__
+using Word = uint64_t;
+#else
+using Word = uint32_t;
+#endif
+
+} // namespace
+
 namespace cascade {
 
+DataPlane::DataPlane() {
+  stale_ = false;
+}
+
 void DataPlane::register_id(const VId id) {
   if (id >= readers_.size()) {
     readers_.resize(id+1);
@@ -49,12 +66,18 @@ void DataPlane::register_id(const VId id) {
   if (id >= write_buf_.size()) {
     write_buf_.resize(id+1); 
   }
+  stale_ = true;
+}
+
+size_t DataPlane::size_ids() const {
+  return readers_.size();
 }
 
 void DataPlane::register_reader(Engine* e, VId id) {
   assert(id < readers_.size());
   if (reader_find(e, id) == reader_end(id)) {
     readers_[id].push_back(e);
+    stale_ = true;
   }
 }
 
@@ -62,6 +85,7 @@ void DataPlane::unregister_reader(Engine* e, VId id) {
   assert(id < readers_.size());
   if (reader_find(e, id) != reader_end(id)) {
     readers_[id].erase(reader_find(e, id));
+    stale_ = true;
   }
 }
 
@@ -109,35 +133,73 @@ DataPlane::writer_iterator DataPlane::writer_end(VId id) const {
   return writers_[id].end();
 }
 
+void DataPlane::compact() {
+  if (!stale_) {
+    return;
+  }
+  offsets_.clear();
+  fanout_.clear();
+  offsets_.reserve(readers_.size()+1);
+  for (const auto& rs : readers_) {
+    offsets_.push_back(fanout_.size());
+    fanout_.insert(fanout_.end(), rs.begin(), rs.end());
+  }
+  offsets_.push_back(fanout_.size());
+  stale_ = false;
+}
+
 void DataPlane::write(VId id, const Bits* bits) {
-  assert(id < readers_.size());
   assert(id < write_buf_.size());
-
-  // We want to check two things here:
-  // 1. Are the sizes the same (we're inserting things into the dataplane with
-  //    default constructed values).
-  // 2. Assuming the sizes are the same, meaning something was written here, is
-  //    the value the same?
-  if ((write_buf_[id].size() == bits->size()) && (write_buf_[id] == *bits)) {
+  if (!changed(id, bits)) {
     return;
   } 
   write_buf_[id] = *bits;
-  for (auto* e : readers_[id]) {
-    e->read(id, &write_buf_[id]);
-  } 
+  broadcast(id);
 }
 
 void DataPlane::write(VId id, bool b) {
-  assert(id < readers_.size());
   assert(id < write_buf_.size());
-
   if (write_buf_[id].to_bool() == b) {
     return;
   } 
   write_buf_[id].flip(0);
-  for (auto* e : readers_[id]) {
-    e->read(id, &write_buf_[id]);
-  } 
+  broadcast(id);
+}
+
+void DataPlane::write_changed(VId id, const Bits* bits) {
+  assert(id < write_buf_.size());
+  write_buf_[id] = *bits;
+  broadcast(id);
+}
+
+bool DataPlane::changed(VId id, const Bits* bits) const {
+  // We want to check two things here:
+  // 1. Are the sizes the same (we're inserting things into the dataplane with
+  //    default constructed values).
+  // 2. Assuming the sizes are the same, meaning something was written here, is
+  //    the value the same?
+  const auto& buf = write_buf_[id];
+  if (buf.size() != bits->size()) {
+    return true;
+  }
+  // Fast Path: Single word values of the same type can be compared directly.
+  // Bits doesn't keep the unused high order bits of a word clear, so we mask
+  // them off before comparing.
+  const auto n = bits->size();
+  if ((n <= 8*sizeof(Word)) && (buf.get_type() == bits->get_type())) {
+    const auto mask = (n == 8*sizeof(Word)) ? ~static_cast<Word>(0) : ((static_cast<Word>(1) << n) - 1);
+    return ((buf.read_word<Word>(0) ^ bits->read_word<Word>(0)) & mask) != 0;
+  }
+  return !(buf == *bits);
+}
+
+void DataPlane::broadcast(VId id) {
+  compact();
+  assert(id+1 < offsets_.size());
+  const auto& b = write_buf_[id];
+  for (auto i = offsets_[id], ie = offsets_[id+1]; i < ie; ++i) {
+    fanout_[i]->read(id, &b);
+  }
 }
 
 } // namespace cascade
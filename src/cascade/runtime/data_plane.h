@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_DATA_PLANE_H
 #define CASCADE_SRC_RUNTIME_DATA_PLANE_H
 
+#include <stdint.h>
 #include <vector>
 #include "common/bits.h"
 #include "runtime/ids.h"
@@ -46,12 +47,17 @@ class Engine;
 
 class DataPlane {
   public:
+    // Constructors:
+    DataPlane();
+
     // Iterators:
     typedef std::vector<Engine*>::const_iterator reader_iterator;
     typedef std::vector<Engine*>::const_iterator writer_iterator;
 
     // Id Interface:
     void register_id(VId id);
+    // Returns one more than the largest id which has been registered.
+    size_t size_ids() const;
 
     // Reader Interface:
     void register_reader(Engine* e, VId id);
@@ -67,16 +73,35 @@ class DataPlane {
     writer_iterator writer_begin(VId id) const;
     writer_iterator writer_end(VId id) const;
 
+    // Rebuilds the flattened reader table if the registries have changed
+    // since the last call. This is invoked lazily by write(), but should be
+    // called explicitly before engines are allowed to write concurrently.
+    void compact();
+
     // Communication Interface:
     void write(VId id, const Bits* bits);
     void write(VId id, bool b);
+    // Identical to write(), but skips change detection. Callers should only
+    // use this when they know that bits differs from the last value they
+    // wrote to id. If that's wrong, readers see a redundant (but harmless)
+    // read.
+    void write_changed(VId id, const Bits* bits);
 
   private:
     // Registries:
     std::vector<std::vector<Engine*>> readers_;
     std::vector<std::vector<Engine*>> writers_;
+    // Flattened Reader Table: The readers of id are stored contiguously in 
+    // fanout_[offsets_[id]] through fanout_[offsets_[id+1]-1].
+    std::vector<uint32_t> offsets_;
+    std::vector<Engine*> fanout_;
+    bool stale_;
     // Buffers:
     std::vector<Bits> write_buf_;
+
+    // Write Helpers:
+    bool changed(VId id, const Bits* bits) const;
+    void broadcast(VId id);
 };
 
 } // namespace cascade
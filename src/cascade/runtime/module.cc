@@ -30,17 +30,24 @@
 
 #include "runtime/module.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include "common/sha256.h"
 #include "runtime/data_plane.h"
 #include "runtime/isolate.h"
 #include "runtime/runtime.h"
 #include "target/compiler.h"
 #include "target/engine.h"
+#include "target/input.h"
 #include "target/state.h"
 #include "verilog/analyze/module_info.h"
 #include "verilog/analyze/resolve.h"
@@ -48,6 +55,7 @@
 #include "verilog/print/print.h"
 #include "verilog/program/elaborate.h"
 #include "verilog/program/inline.h"
+#include "verilog/program/program.h"
 #include "verilog/transform/assign_unpack.h"
 #include "verilog/transform/block_flatten.h"
 #include "verilog/transform/constant_prop.h"
@@ -74,6 +82,10 @@ mutex alt_lock_;
 
 namespace cascade {
 
+const char Module::checkpoint_magic_[8] = {'C', 'A', 'S', 'C', 'A', 'D', 'E', '\x01'};
+const uint32_t Module::checkpoint_version_ = 3;
+const size_t Module::checkpoint_entry_ = 52;
+
 Module* Module::iterator::operator*() const {
   return path_.front();
 }
@@ -122,6 +134,8 @@ Module::Module(const ModuleDeclaration* psrc, Runtime* rt, Module* parent) {
 
   engine_ = rt_->get_compiler()->compile_stub(rt_->get_next_id(), psrc);
   version_ = 0;
+  num_reads_ = 0;
+  num_writes_ = 0;
 }
 
 Module::~Module() {
@@ -158,11 +172,19 @@ void Module::synchronize(size_t n) {
   for (auto i = psrc_->begin_items()+idx, ie = psrc_->end_items(); i != ie; ++i) {
     (*i)->accept(&inst);
   }
-  // Recompile everything 
+  // Recompile whatever was affected by the new code: this module (which is
+  // where new items are added), modules which were just instantiated, and
+  // modules whose interface was changed by a new hierarchical reference.
+  // Everything else keeps its current engine along with any jit compilations
+  // which are still in flight.
+  vector<pair<Module*, size_t>> ms;
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
-    const auto ignore = (*i == this) ? (psrc_->size_items() - n) : 0;
-    (*i)->compile_and_replace(ignore);
+    if ((*i == this) || (*i)->is_stale()) {
+      const auto ignore = (*i == this) ? (psrc_->size_items() - n) : 0;
+      ms.push_back(make_pair(*i, ignore));
+    }
   }
+  compile_and_replace(ms);
   // Synchronize subscriptions with the dataplane. Note that we do this *after*
   // recompilation.  This guarantees that the variable names used by
   // Isolate::isolate() are deterministic.
@@ -184,15 +206,42 @@ void Module::rebuild() {
   // This method should only be called in a state where all modules are in sync
   // with the user's program. However(!) we do still need to regenerate source.
   // Recall that compilation takes over ownership of a module's source code.
+  vector<pair<Module*, size_t>> ms;
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
-    const auto ignore = (*i)->psrc_->size_items();
-    (*i)->compile_and_replace(ignore);
+    ms.push_back(make_pair(*i, (*i)->psrc_->size_items()));
   }
+  compile_and_replace(ms);
 }
 
 void Module::save(ostream& os) {
-  os << size() << endl;
-
+  // Checkpoint Format:
+  //
+  // magic[8] version:u32 n:u32
+  // 2 x (seq:u64 n x (id:u32 offset:u64 length:u64 digest[32]) check:u64)
+  // n x (Input State)
+  //
+  // Offsets are relative to the beginning of the checkpoint. Each digest is
+  // the SHA-256 of the Input and State that its entry points to. The index is
+  // written last, once we know where everything landed. Integers are written
+  // in host byte order (bit vectors are always least significant byte first),
+  // so checkpoints can only be restarted on hosts with the same byte order.
+  // Restart detects the mismatch by way of the version field.
+  //
+  // The index is stored in two slots so that the checkpointer can update one
+  // in place while the other still describes a complete checkpoint. A slot is
+  // valid if its seq is non-zero and check matches the rest of its contents,
+  // and restart uses whichever valid slot has the larger seq. We only write
+  // the first slot here.
+  const auto begin = os.tellp();
+  const uint32_t n = size();
+  os.write(checkpoint_magic_, 8);
+  os.write(reinterpret_cast<const char*>(&checkpoint_version_), 4);
+  os.write(reinterpret_cast<const char*>(&n), 4);
+  const auto index = os.tellp();
+  const vector<char> blank(2 * checkpoint_slot_size(n), 0);
+  os.write(blank.data(), blank.size());
+
+  CheckpointIndex entries;
   for (auto i = iterator(this), ie = end(); i != ie; ++i) {
     const auto* p = (*i)->psrc_->get_parent();
     assert(p != nullptr);
@@ -201,22 +250,193 @@ void Module::save(ostream& os) {
     const auto fid = Resolve().get_readable_full_id(static_cast<const ModuleInstantiation*>(p)->get_iid());
     ostream(rt_->rdbuf(Runtime::stdinfo_)) << "<save> " << fid << endl;
 
-    os << "MODULE:" << endl;
-    os << rt_->get_isolate()->isolate(static_cast<const ModuleInstantiation*>(p)) << endl;
-    
-    os << "INPUT:" << endl;
+    const auto id = rt_->get_isolate()->isolate(static_cast<const ModuleInstantiation*>(p));
+    const uint64_t offset = os.tellp() - begin;
+    stringstream ss;
+
     auto* input = (*i)->engine_->get_input();
-    input->write(os, 16);
+    input->serialize(ss);
     delete input;
 
-    os << "STATE:" << endl;
     auto* state = (*i)->engine_->get_state();
-    state->write(os, 16);
+    state->serialize(ss);
     delete state;
+
+    const auto payload = ss.str();
+    os.write(payload.data(), payload.length());
+    entries.push_back(make_tuple(id, offset, payload.length(), Sha256().update(payload).digest()));
+  }
+
+  const auto end = os.tellp();
+  const auto slot = checkpoint_slot(1, entries);
+  os.seekp(index);
+  os.write(slot.data(), slot.length());
+  os.seekp(end);
+}
+
+size_t Module::checkpoint_slot_size(size_t n) {
+  return 16 + n * checkpoint_entry_;
+}
+
+string Module::checkpoint_slot(uint64_t seq, const CheckpointIndex& index) {
+  stringstream ss;
+  ss.write(reinterpret_cast<const char*>(&seq), 8);
+  for (const auto& e : index) {
+    ss.write(reinterpret_cast<const char*>(&get<0>(e)), 4);
+    ss.write(reinterpret_cast<const char*>(&get<1>(e)), 8);
+    ss.write(reinterpret_cast<const char*>(&get<2>(e)), 8);
+    ss.write(get<3>(e).data(), 32);
   }
+  auto res = ss.str();
+  res += Sha256().update(res).digest().substr(0, 8);
+  return res;
 }
 
-void Module::restart(std::istream& is) {
+void Module::snapshot(Snapshot* s) {
+  for (auto i = iterator(this), ie = end(); i != ie; ++i) {
+    const auto* p = (*i)->psrc_->get_parent();
+    assert(p != nullptr);
+    assert(p->is(Node::Tag::module_instantiation));
+
+    const auto id = rt_->get_isolate()->isolate(static_cast<const ModuleInstantiation*>(p));
+    s->push_back(make_tuple(id, (*i)->engine_->get_input(), (*i)->engine_->get_state()));
+  }
+}
+
+bool Module::restart(std::istream& is, std::string* error) {
+  // Read the checkpoint header. Fall back on the text format used by older
+  // versions of cascade if this doesn't look like a binary checkpoint.
+  const auto begin = is.tellg();
+  char magic[8];
+  is.read(magic, 8);
+  if (!is.good() || !equal(magic, magic+8, checkpoint_magic_)) {
+    is.clear();
+    is.seekg(begin);
+    restart_text(is);
+    return true;
+  }
+  uint32_t version = 0;
+  is.read(reinterpret_cast<char*>(&version), 4);
+  if (!is.good()) {
+    *error = "Checkpoint header is truncated";
+    return false;
+  }
+  if (version != checkpoint_version_) {
+    if (version == __builtin_bswap32(checkpoint_version_)) {
+      *error = "Checkpoint was written on a host with a different byte order";
+    } else {
+      *error = "Unsupported checkpoint version " + to_string(version);
+    }
+    return false;
+  }
+
+  // Read both copies of the index and keep the most recent one which is
+  // intact. Then check every entry against the size of the file. We don't
+  // touch module contents until we know that we need them; this way
+  // restarting a subset of a large design only reads what it uses.
+  is.seekg(0, ios::end);
+  const uint64_t size = is.tellg() - begin;
+  is.seekg(begin + static_cast<streamoff>(12));
+  uint32_t n = 0;
+  is.read(reinterpret_cast<char*>(&n), 4);
+  const uint64_t data = 16 + 2 * static_cast<uint64_t>(checkpoint_slot_size(n));
+  if (!is.good() || (data > size)) {
+    *error = "Checkpoint index is truncated";
+    return false;
+  }
+  uint64_t seq = 0;
+  CheckpointIndex entries;
+  for (size_t i = 0; i < 2; ++i) {
+    string slot(checkpoint_slot_size(n), '\0');
+    is.read(&slot[0], slot.length());
+    if (!is.good()) {
+      *error = "Checkpoint index is truncated";
+      return false;
+    }
+    stringstream ss(slot);
+    uint64_t s = 0;
+    ss.read(reinterpret_cast<char*>(&s), 8);
+    CheckpointIndex es;
+    for (size_t j = 0; j < n; ++j) {
+      MId id = 0;
+      uint64_t offset = 0;
+      uint64_t length = 0;
+      string digest(32, '\0');
+      ss.read(reinterpret_cast<char*>(&id), 4);
+      ss.read(reinterpret_cast<char*>(&offset), 8);
+      ss.read(reinterpret_cast<char*>(&length), 8);
+      ss.read(&digest[0], 32);
+      es.push_back(make_tuple(id, offset, length, digest));
+    }
+    if ((s > seq) && (checkpoint_slot(s, es) == slot)) {
+      seq = s;
+      entries = es;
+    }
+  }
+  if (seq == 0) {
+    *error = "Checkpoint index is corrupt";
+    return false;
+  }
+  unordered_map<MId, CheckpointIndex::value_type> index;
+  for (const auto& e : entries) {
+    const auto id = get<0>(e);
+    const auto offset = get<1>(e);
+    const auto length = get<2>(e);
+    if ((offset < data) || (offset > size) || (length > size - offset)) {
+      *error = "Checkpoint index entry for module " + to_string(id) + " lies outside of the file";
+      return false;
+    }
+    index[id] = e;
+  }
+
+  // Read everything that we need before updating any modules, so that a
+  // malformed checkpoint leaves the program as it was. Each entry must match
+  // its digest before we deserialize it, and must then be consumed exactly.
+  vector<pair<Module*, pair<Input, State>>> contents;
+  for (auto i = iterator(this), ie = end(); i != ie; ++i) {
+    const auto* p = (*i)->psrc_->get_parent();
+    assert(p != nullptr);
+    assert(p->is(Node::Tag::module_instantiation));
+
+    const auto id = rt_->get_isolate()->isolate(static_cast<const ModuleInstantiation*>(p));
+    const auto itr = index.find(id);
+    if (itr == index.end()) {
+      continue;
+    }
+
+    const auto fid = Resolve().get_readable_full_id(static_cast<const ModuleInstantiation*>(p)->get_iid());
+    string payload(get<2>(itr->second), '\0');
+    is.seekg(begin + static_cast<streamoff>(get<1>(itr->second)));
+    is.read(&payload[0], payload.length());
+    if (!is.good() || (Sha256().update(payload).digest() != get<3>(itr->second))) {
+      *error = "Checkpoint entry for " + fid + " is corrupt";
+      return false;
+    }
+
+    stringstream ss(payload);
+    contents.emplace_back();
+    contents.back().first = *i;
+    auto length = contents.back().second.first.deserialize(ss);
+    length += contents.back().second.second.deserialize(ss);
+    if (!ss.good() || (length != payload.length())) {
+      *error = "Checkpoint entry for " + fid + " is corrupt";
+      return false;
+    }
+  }
+
+  // Update module hierarchy
+  for (auto& c : contents) {
+    const auto* p = c.first->psrc_->get_parent();
+    const auto fid = Resolve().get_readable_full_id(static_cast<const ModuleInstantiation*>(p)->get_iid());
+    ostream(rt_->rdbuf(Runtime::stdinfo_)) << "<restart> " << fid << endl;
+
+    c.first->engine_->set_input(&c.second.first);
+    c.first->engine_->set_state(&c.second.second);
+  }
+  return true;
+}
+
+void Module::restart_text(std::istream& is) {
   // Read save file
   size_t n = 0;
   is >> n;
@@ -310,8 +530,132 @@ void Module::Instantiator::visit(const ModuleInstantiation* mi) {
 
 
 
-ModuleDeclaration* Module::regenerate_ir_source(size_t ignore) {
-  auto* md = rt_->get_isolate()->isolate(psrc_, ignore);
+void Module::speculate(const Program* march, vector<ModuleDeclaration*>* mds) {
+  for (auto i = iterator(this), ie = end(); i != ie; ++i) {
+    const auto* std1 = (*i)->psrc_->get_attrs()->get<String>("__std");
+    if (!std1->eq("logic")) {
+      continue;
+    }
+    // As with $retarget(), annotations are inherited from the declaration in
+    // the march file with the same standard type. Isolation copies the
+    // annotations of the source, so it's enough to replace them afterwards.
+    for (auto j = march->elab_begin(), je = march->elab_end(); j != je; ++j) {
+      const auto* std2 = j->second->get_attrs()->get<String>("__std");
+      if ((std2 != nullptr) && (std1->get_readable_val() == std2->get_readable_val())) {
+        auto* md = rt_->get_isolate()->isolate((*i)->psrc_, (*i)->psrc_->size_items());
+        md->replace_attrs(j->second->get_attrs()->clone());
+        mds->push_back(md);
+        break;
+      }
+    }
+  }
+}
+
+void Module::jit_passes(ModuleDeclaration* md, vector<ModuleDeclaration*>* passes) {
+  transform_ir_source(md);
+
+  // Peel off one target at a time, just as compile() does for each pass
+  for (auto* src = md; ; ) {
+    const auto* t = src->get_attrs()->get<String>("__target");
+    const auto* l = src->get_attrs()->get<String>("__loc");
+    const auto tsep = t->get_readable_val().find_first_of(';');
+    const auto lsep = l->get_readable_val().find_first_of(';');
+    if ((tsep == string::npos) && (lsep == string::npos)) {
+      break;
+    }
+    auto* next = src->clone();
+    if (tsep != string::npos) {
+      next->get_attrs()->set_or_replace("__target", new String(t->get_readable_val().substr(tsep+1)));
+    }
+    if (lsep != string::npos) {
+      next->get_attrs()->set_or_replace("__loc", new String(l->get_readable_val().substr(lsep+1)));
+    }
+    DeleteInitial().run(next);
+    passes->push_back(next);
+    src = next;
+  }
+  delete md;
+}
+
+bool Module::is_stale() const {
+  // Modules only ever gain reads and writes, so comparing the sizes of these
+  // sets against what we saw at the last compilation is sufficient.
+  if (version_ == 0) {
+    return true;
+  }
+  ModuleInfo info(psrc_);
+  return (info.reads().size() != num_reads_) || (info.writes().size() != num_writes_);
+}
+
+void Module::compile_and_replace(const vector<pair<Module*, size_t>>& ms) {
+  // Isolation reads the (lazily decorated) program source and assigns global
+  // variable ids, so it has to take place serially and in a fixed order. We
+  // bump the sequence number for each module while we're at it.
+  vector<Compilation> cs(ms.size());
+  for (size_t i = 0, ie = ms.size(); i < ie; ++i) {
+    auto* m = ms[i].first;
+    auto& c = cs[i];
+    c.md = rt_->get_isolate()->isolate(m->psrc_, ms[i].second);
+    c.version = ++m->version_;
+    c.pass = 1;
+    m->num_reads_ = ModuleInfo(m->psrc_).reads().size();
+    m->num_writes_ = ModuleInfo(m->psrc_).writes().size();
+
+    // Record human readable name for this module
+    const auto* iid = static_cast<const ModuleInstantiation*>(m->psrc_->get_parent())->get_iid();
+    c.id = Resolve().get_readable_full_id(iid);
+  }
+
+  // Everything else operates on private copies of the source, so it can run
+  // concurrently. The runtime thread claims work along with the thread pool.
+  // This way we make progress even if the pool is busy with jit compilations.
+  // The shared state outlives this method in case a pool job starts late.
+  struct Work {
+    atomic<size_t> next;
+    size_t done;
+    mutex lock;
+    condition_variable cv;
+  };
+  auto work = make_shared<Work>();
+  work->next = 0;
+  work->done = 0;
+  const auto n = cs.size();
+  auto run = [work, n, &ms, &cs]{
+    for (auto i = work->next++; i < n; i = work->next++) {
+      transform_ir_source(cs[i].md);
+      ms[i].first->compile(&cs[i]);
+      lock_guard<mutex> lg(work->lock);
+      if (++work->done == n) {
+        work->cv.notify_one();
+      }
+    }
+  };
+  const auto helpers = min<size_t>(n, thread::hardware_concurrency());
+  for (size_t i = 1; i < helpers; ++i) {
+    rt_->schedule_asynchronous(Runtime::Asynchronous(run), ThreadPool::Priority::HIGH);
+  }
+  run();
+  unique_lock<mutex> ul(work->lock);
+  work->cv.wait(ul, [work, n]{ return work->done == n; });
+  ul.unlock();
+
+  // Install the results in deterministic order and schedule jit passes
+  for (size_t i = 0, ie = ms.size(); i < ie; ++i) {
+    ms[i].first->replace(&cs[i]);
+  }
+}
+
+void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const string& id, size_t pass) {
+  Compilation c;
+  c.md = md;
+  c.version = version;
+  c.id = id;
+  c.pass = pass;
+  compile(&c);
+  replace(&c);
+}
+
+void Module::transform_ir_source(ModuleDeclaration* md) {
   const auto* std = md->get_attrs()->get<String>("__std");
   const auto is_logic = (std != nullptr) && (std->get_readable_val() == "logic");
   if (is_logic) {
@@ -326,23 +670,15 @@ ModuleDeclaration* Module::regenerate_ir_source(size_t ignore) {
     DeadCodeEliminate().run(md);
     BlockFlatten().run(md);
   }
-  return md;
 }
 
-void Module::compile_and_replace(size_t ignore) {
-  // Generate new code and bump the sequence number for this module
-  auto* md = regenerate_ir_source(ignore); 
-  const auto this_version = ++version_;
-
-  // Record human readable name for this module
-  const auto* iid = static_cast<const ModuleInstantiation*>(psrc_->get_parent())->get_iid();
-  const auto fid = Resolve().get_readable_full_id(iid);
-
-  // Invoke compilations until all jit passes are scheduled
-  compile_and_replace(md, this_version, fid, 1);
-}
+void Module::compile(Compilation* c) {
+  auto* md = c->md;
+  c->md = nullptr;
+  c->next = nullptr;
+  c->engine = nullptr;
+  c->ok = false;
 
-void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const string& id, size_t pass) {
   // Lookup annotations 
   const auto* std = md->get_attrs()->get<String>("__std");
   const auto* t = md->get_attrs()->get<String>("__target");
@@ -351,42 +687,56 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
   // Check: Is jit compilation required?  
   const auto tsep = t->get_readable_val().find_first_of(';');
   const auto lsep = l->get_readable_val().find_first_of(';');
-  const auto jit = std->eq("logic") && ((tsep != string::npos) || (lsep != string::npos));
+  c->jit = std->eq("logic") && ((tsep != string::npos) || (lsep != string::npos));
 
   // If we're jit compiling, we'll need a second copy of the source.
-  ModuleDeclaration* md2 = nullptr;
-  if (jit) {
-    md2 = md->clone();
+  if (c->jit) {
+    c->next = md->clone();
     if (tsep != string::npos) {
-      md2->get_attrs()->set_or_replace("__target", new String(t->get_readable_val().substr(tsep+1)));
+      c->next->get_attrs()->set_or_replace("__target", new String(t->get_readable_val().substr(tsep+1)));
       md->get_attrs()->set_or_replace("__target", new String(t->get_readable_val().substr(0, tsep)));
     }
     if (lsep != string::npos) {
-      md2->get_attrs()->set_or_replace("__loc", new String(l->get_readable_val().substr(lsep+1)));
+      c->next->get_attrs()->set_or_replace("__loc", new String(l->get_readable_val().substr(lsep+1)));
       md->get_attrs()->set_or_replace("__loc", new String(l->get_readable_val().substr(0, lsep)));
     }
     md->get_attrs()->erase("__delay");
     md->get_attrs()->erase("__state_safe_int");
-  } else {
-    md2 = new ModuleDeclaration(new Attributes(), new Identifier("null"));
-  }
+  } 
   // Invariant: Initial blocks are removed from pass n compilations
-  if (pass > 1) {
+  if (c->pass > 1) {
     DeleteInitial().run(md);
   }
   // Invariant: First pass for logic must be sw
-  if (std->eq("logic") && (pass == 1) && !md->get_attrs()->get<String>("__target")->eq("sw")) {
+  if (std->eq("logic") && (c->pass == 1) && !md->get_attrs()->get<String>("__target")->eq("sw")) {
     rt_->get_compiler()->fatal("Pass 1 compilation for logic must target software!");
     delete md;
-    delete md2;
+    if (c->next != nullptr) {
+      delete c->next;
+      c->next = nullptr;
+    }
     return;
   }
 
   // Compile code
   stringstream ss;
-  ss << "pass " << pass << " compilation of " << id << " with attributes " << md->get_attrs();
-  const auto info = ss.str();
-  auto* e = rt_->get_compiler()->compile(engine_->get_id(), md);
+  ss << "pass " << c->pass << " compilation of " << c->id << " with attributes " << md->get_attrs();
+  c->info = ss.str();
+  c->engine = rt_->get_compiler()->compile(engine_->get_id(), md);
+  c->ok = true;
+}
+
+void Module::replace(Compilation* c) {
+  // Nothing to do if we never made it as far as compiling code
+  if (!c->ok) {
+    return;
+  }
+  const auto version = c->version;
+  const auto pass = c->pass;
+  const auto& id = c->id;
+  const auto& info = c->info;
+  auto* e = c->engine;
+  auto* md2 = c->next;
 
   // Special handling for pass 1 compilation, which isn't run asynchronously
   // and has strict reqiurements on successful completion.
@@ -422,12 +772,13 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
     });
   }
 
-  // Run jit compilation asynchronously
-  if (jit && !engine_->is_stub() && (e != nullptr)) {
+  // Run jit compilation asynchronously. These passes are speculative, so
+  // they yield to any other work which is waiting for the pool.
+  if (c->jit && !engine_->is_stub() && (e != nullptr)) {
     rt_->schedule_asynchronous(Runtime::Asynchronous([this, md2, version, id, pass, info]{
       compile_and_replace(md2, version, id, pass+1);
-    }));
-  } else {
+    }), ThreadPool::Priority::LOW);
+  } else if (md2 != nullptr) {
     delete md2;
   }
 }
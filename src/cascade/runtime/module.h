@@ -34,14 +34,22 @@
 #include <forward_list>
 #include <iosfwd>
 #include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
+#include "runtime/ids.h"
 #include "verilog/ast/visitors/editor.h"
 #include "verilog/ast/visitors/visitor.h"
 
 namespace cascade {
 
 class Engine;
+class Input;
+class Program;
 class Runtime;
+class State;
 
 class Module {
   public:
@@ -59,6 +67,20 @@ class Module {
         explicit iterator(Module* m);
     };
 
+    // Checkpoint Format:
+    static const char checkpoint_magic_[8];
+    static const uint32_t checkpoint_version_;
+    static const size_t checkpoint_entry_;
+    // The (id, offset, length, digest) of each module in a checkpoint
+    typedef std::vector<std::tuple<MId, uint64_t, uint64_t, std::string>> CheckpointIndex;
+    // Returns the size of one copy of the index for a hierarchy of n modules
+    static size_t checkpoint_slot_size(size_t n);
+    // Returns one copy of the index, ending in the check which marks it valid
+    static std::string checkpoint_slot(uint64_t seq, const CheckpointIndex& index);
+
+    // A copy of the input and state of each module in a hierarchy
+    typedef std::vector<std::tuple<MId, Input*, State*>> Snapshot;
+
     // Constructors:
     Module(const ModuleDeclaration* psrc, Runtime* rt, Module* parent = nullptr);
     ~Module();
@@ -75,13 +97,34 @@ class Module {
     // Synchronizes the module hierarchy with changes which have been made to
     // the ast since the previous invocation of synchronize. n is the number of
     // items which have been added to the top-level module in the interim.
+    // Only those modules which were affected by these items are recompiled.
     void synchronize(size_t n);
     // Forces a recompilation of the entire module hierarchy.
     void rebuild();
-    // Dumps the state of the module hierarchy to an ostream. 
+    // Dumps the state of the module hierarchy to an ostream in a versioned
+    // binary format. The stream must support seeking.
     void save(std::ostream& os);
-    // Reads the state of the module hierarchy from an istream. 
-    void restart(std::istream& is);
+    // Appends a copy of the input and state of each module in the hierarchy
+    // to s. The caller takes ownership of these copies.
+    void snapshot(Snapshot* s);
+    // Reads the state of the module hierarchy from an istream. The stream must
+    // support seeking. Only the modules which appear in the hierarchy are read.
+    // Also accepts the text format produced by older versions of cascade.
+    // Returns false without modifying any module if the checkpoint is
+    // malformed, in which case error describes the problem.
+    bool restart(std::istream& is, std::string* error);
+
+    // Speculation Interface:
+    //
+    // Appends to mds a copy of the source of each logic module in the
+    // hierarchy, as it would be compiled after a $retarget() to march (a
+    // program read from a march file). The caller takes ownership of mds.
+    void speculate(const Program* march, std::vector<ModuleDeclaration*>* mds);
+    // Prepares md in the same way that compilation would, and appends to
+    // passes the source that each pass n > 1 would hand to the compiler. This
+    // method takes ownership of md, and the caller takes ownership of passes.
+    // It does not touch the runtime, and is safe to invoke from any thread.
+    static void jit_passes(ModuleDeclaration* md, std::vector<ModuleDeclaration*>* passes);
 
   private:
     // Instantiate modules based on source code
@@ -109,11 +152,38 @@ class Module {
     // Engine State:
     Engine* engine_;
     size_t version_;
+    // The number of reads and writes this module had at its last compilation
+    size_t num_reads_;
+    size_t num_writes_;
+
+    // Compilation State:
+    struct Compilation {
+      // Input: The source to compile, and where it came from
+      ModuleDeclaration* md;
+      size_t version;
+      std::string id;
+      size_t pass;
+      // Output: The result of compilation and the source for the next pass
+      bool ok;
+      bool jit;
+      Engine* engine;
+      ModuleDeclaration* next;
+      std::string info;
+    };
 
     // Helper Methods:
-    ModuleDeclaration* regenerate_ir_source(size_t ignore);
-    void compile_and_replace(size_t ignore);
+    bool is_stale() const;
+    void restart_text(std::istream& is);
+    // Recompiles each module in ms with the corresponding number of items
+    // ignored. Pass 1 compilations run concurrently, but engines are
+    // installed in the order that they appear in ms.
+    void compile_and_replace(const std::vector<std::pair<Module*, size_t>>& ms);
     void compile_and_replace(ModuleDeclaration* md, size_t version, const std::string& id, size_t pass);
+    static void transform_ir_source(ModuleDeclaration* md);
+    // Compilation is split into a thread-safe phase which produces an engine
+    // and a phase which installs it. 
+    void compile(Compilation* c);
+    void replace(Compilation* c);
 };
 
 } // namespace cascade
@@ -30,19 +30,27 @@
 
 #include "runtime/runtime.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include "common/incstream.h"
 #include "common/indstream.h"
+#include "common/mmapstream.h"
 #include "common/system.h"
+#include "runtime/checkpointer.h"
 #include "runtime/data_plane.h"
 #include "runtime/isolate.h"
 #include "runtime/module.h"
 #include "runtime/nullbuf.h"
+#include "runtime/speculator.h"
 #include "target/compiler/local_compiler.h"
 #include "target/engine.h"
 #include "verilog/analyze/evaluate.h"
@@ -65,12 +73,19 @@ Runtime::Runtime() : Thread() {
   disable_inlining_ = false;
   enable_open_loop_ = false;
   open_loop_itrs_ = 2;
-  open_loop_target_ = 1;
+  open_loop_target_ = 0.01;
+  open_loop_rate_ = 0;
   profile_interval_ = 0;
+  eval_threads_ = 1;
+  checkpoint_path_ = "";
+  checkpoint_interval_ = 0;
+  speculation_ = "";
 
   pool_.set_num_threads(4);
   pool_.run();
 
+  checkpointer_ = nullptr;
+  speculator_ = nullptr;
   log_ = new Log();
   parser_ = new Parser(log_);
   parser_->set_include_dirs(include_dirs_);
@@ -84,6 +99,7 @@ Runtime::Runtime() : Thread() {
 
   finished_ = false;
   item_evals_ = 0;
+  producers_ = 0;
 
   schedule_all_ = false;
   clock_ = nullptr;
@@ -91,6 +107,7 @@ Runtime::Runtime() : Thread() {
 
   begin_time_ = ::time(nullptr);
   last_time_ = ::time(nullptr);
+  last_checkpoint_ = ::time(nullptr);
   logical_time_ = 0;
 
   for (size_t i = 0; i < 6; ++i) {
@@ -114,10 +131,15 @@ Runtime::~Runtime() {
   // new asyncrhonous threads have been started (the only place this happens is
   // inside interrupts). Stop any outstanding compilations and wait for them to
   // return. When that's done, stop any asynchronous jobs associated with
-  // compilers.
+  // compilers. Speculative compilations go first, so that they don't restart
+  // anything.
 
+  if (speculator_ != nullptr) {
+    delete speculator_;
+  }
   compiler_->stop_compile();
   pool_.stop_now();
+  eval_pool_.stop_now();
   compiler_->stop_async();
 
   // INVARIANT: All outstanding asynchronous threads have finished executing,
@@ -125,10 +147,17 @@ Runtime::~Runtime() {
   // their alternate callbacks executed. It's now safe to tear down the
   // runtime.
   
+  // Flush whatever checkpoint is still pending before tearing down
+  if (checkpointer_ != nullptr) {
+    delete checkpointer_;
+  }
   delete program_;
   if (root_ != nullptr) {
     delete root_;
   }
+  for (auto* m : marches_) {
+    delete m;
+  }
 
   delete log_;
   delete parser_;
@@ -154,7 +183,7 @@ Runtime& Runtime::set_include_dirs(const string& s) {
   return *this;
 }
 
-Runtime& Runtime::set_open_loop_target(size_t olt) {
+Runtime& Runtime::set_open_loop_target(double olt) {
   open_loop_target_ = olt;
   return *this;
 }
@@ -170,6 +199,30 @@ Runtime& Runtime::set_profile_interval(size_t n) {
   return *this;
 }
 
+Runtime& Runtime::set_eval_threads(size_t n) {
+  // The runtime thread participates in evaluation, so the pool only needs to
+  // provide n-1 additional threads.
+  eval_threads_ = (n == 0) ? 1 : n;
+  eval_pool_.stop_now();
+  if (eval_threads_ > 1) {
+    eval_pool_.set_num_threads(eval_threads_-1);
+    eval_pool_.run();
+  }
+  return *this;
+}
+
+Runtime& Runtime::set_checkpoint(const string& path, size_t n) {
+  checkpoint_path_ = path;
+  checkpoint_interval_ = n;
+  last_checkpoint_ = ::time(nullptr);
+  return *this;
+}
+
+Runtime& Runtime::set_speculation(const string& s) {
+  speculation_ = s;
+  return *this;
+}
+
 DataPlane* Runtime::get_data_plane() {
   return dp_;
 }
@@ -220,46 +273,36 @@ pair<bool, bool> Runtime::eval_all(istream& is) {
 }
 
 bool Runtime::schedule_interrupt(Interrupt int_) {
-  lock_guard<recursive_mutex> lg(int_lock_);
-  if (finished_) {
-    return false;
-  }
-  ints_.push_back([this, int_]{
-    if (!finished_) {
-      int_();
-    }    
-  });
-  return true;
+  return push_interrupt(int_, []{});
 }
 
 bool Runtime::schedule_interrupt(Interrupt int_, Interrupt alt) {
-  lock_guard<recursive_mutex> lg(int_lock_);
-  if (finished_) {
+  if (!push_interrupt(int_, alt)) {
     alt();
     return false;
   }
-  ints_.push_back([this, int_, alt]{
-    if (!finished_) {
-      int_();
-    } else {
-      alt();  
-    }
-  });
   return true;
 }
 
 void Runtime::schedule_blocking_interrupt(Interrupt int_) {
-  unique_lock<mutex> lg(block_lock_);
-  if (schedule_interrupt(int_)) {
-    block_cv_.wait(lg);
-  }
+  schedule_blocking_interrupt(int_, []{});
 }
 
 void Runtime::schedule_blocking_interrupt(Interrupt int_, Interrupt alt) {
-  unique_lock<mutex> lg(block_lock_);
-  if (schedule_interrupt(int_, alt)) {
-    block_cv_.wait(lg);
+  // Block until the end of the drain which runs or fizzles this interrupt.
+  // Waiting on a flag rather than a bare notification means that it doesn't
+  // matter whether that happens before or after we start waiting.
+  auto done = false;
+  const auto release = [this, &done]{
+    lock_guard<mutex> lg(block_lock_);
+    blocked_.push_back(&done);
+  };
+  if (!push_interrupt([int_, release]{ int_(); release(); }, [alt, release]{ alt(); release(); })) {
+    alt();
+    return;
   }
+  unique_lock<mutex> ul(block_lock_);
+  block_cv_.wait(ul, [&done]{ return done; });
 }
 
 void Runtime::schedule_state_safe_interrupt(Interrupt int__) {
@@ -273,14 +316,17 @@ void Runtime::schedule_state_safe_interrupt(Interrupt int__) {
       stringstream ss;
       root_->save(ss);
       int__();
-      root_->restart(ss);
+      string error;
+      const auto res = root_->restart(ss, &error);
+      assert(res);
+      (void) res;
     },
     int__
   );
 }
 
-void Runtime::schedule_asynchronous(Asynchronous async) {
-  pool_.insert(async); 
+void Runtime::schedule_asynchronous(Asynchronous async, ThreadPool::Priority p) {
+  pool_.insert(async, p); 
 }
 
 bool Runtime::is_finished() const {
@@ -290,6 +336,7 @@ bool Runtime::is_finished() const {
 void Runtime::reset_open_loop_itrs() {
   schedule_interrupt([this]{
     open_loop_itrs_ = 2;
+    open_loop_rate_ = 0;
   });
 }
 
@@ -324,6 +371,7 @@ void Runtime::debug(uint32_t action, const string& arg) {
 }
 
 void Runtime::finish(uint32_t arg) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   if (arg > 0) {
     ostream(rdbuf(stdout_)) 
       << "Simulation Time: " << logical_time_ << "\n"
@@ -341,13 +389,19 @@ void Runtime::restart(const string& path) {
     if (item_evals_ > 0) {
       return restart(path);
     }
-    ifstream ifs(path);
-    if (!ifs.is_open()) {
+    // Save files are mapped rather than read, so that we only pull in the
+    // parts of the file that we need.
+    immapstream ims(path);
+    if (!ims.is_open()) {
       ostream(rdbuf(stderr_)) << "Unable to open save file '" << path << "'\"!" << endl;
       finish(0);
       return;
     }
-    root_->restart(ifs);
+    string error;
+    if (!root_->restart(ims, &error)) {
+      ostream(rdbuf(stderr_)) << "Unable to restart from save file '" << path << "': " << error << "!" << endl;
+      finish(0);
+    }
   });
 }   
 
@@ -362,34 +416,13 @@ void Runtime::retarget(const string& s) {
       return retarget(s);
     }
     // Give up if we can't open the march file which was requested
-    ifstream ifs(System::src_root() + "share/cascade/march/" + s + ".v");
-    if (!ifs.is_open()) {
+    auto* march = read_march(s);
+    if (march == nullptr) {
       ostream(rdbuf(stderr_)) << "Unrecognized march option '" << s << "'!" << endl;
       finish(0);
       return;
     }
 
-    // Temporarily relocate program_ and root_ so that we can scan the contents
-    // of this file using the eval_stream() infrastructure.  Also relocate the
-    // parser, as it will skip include guards that it's already seen.
-    auto* march = program_;
-    program_ = new Program();
-    auto* backup_root = root_;
-    root_ = nullptr;
-    auto* backup_parser = parser_;
-    parser_ = new Parser(log_);
-
-    // Read the march file
-    eval_stream(ifs);
-    assert(!log_->error());
-
-    // Wap everything back into place and restore original state
-    std::swap(march, program_);
-    std::swap(backup_root, root_);
-    std::swap(backup_parser, parser_);
-    delete backup_parser;
-    item_evals_ = 0;
-
     // Replace attribute annotations for every elaborated module (this includes the
     // root, which is where logic inherits its annotations from).
     for (auto i = program_->elab_begin(), ie = program_->elab_end(); i != ie; ++i) {
@@ -409,16 +442,18 @@ void Runtime::retarget(const string& s) {
       }
       if (!found) {
         delete march;
-        delete backup_root;
         ostream(rdbuf(stderr_)) << "New target does not support modules with standard type " << std1->get_readable_val() << "!" << endl;
         finish(0);
         return;
       }
     }
 
-    // Delete temporaries and rebuild the program
+    // Delete temporaries and rebuild the program. Whatever we were
+    // speculating on is out of date now.
     delete march;
-    delete backup_root;
+    if (speculator_ != nullptr) {
+      speculator_->preempt();
+    }
     root_->rebuild();
   });
 }
@@ -430,7 +465,7 @@ void Runtime::save(const string& path) {
     if (item_evals_ > 0) {
       return save(path);
     }
-    ofstream ofs(path);
+    ofstream ofs(path, ios::binary);
     root_->save(ofs);
   });
 }
@@ -462,6 +497,7 @@ streambuf* Runtime::rdbuf(FId id) const {
 }
 
 FId Runtime::fopen(const std::string& path, uint8_t mode) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   incstream is(fopen_dirs_);
   const auto full_path = is.find(path);
   const auto target = full_path == "" ? path : full_path;
@@ -482,10 +518,12 @@ FId Runtime::fopen(const std::string& path, uint8_t mode) {
 }
 
 int32_t Runtime::in_avail(FId id) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   return rdbuf(id)->in_avail();
 }
 
 uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   auto d = ios_base::cur;
   switch (way) {
     case 1: d = ios_base::beg; break;
@@ -503,6 +541,7 @@ uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
 }
 
 uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   auto o = ios_base::openmode();
   switch (which) {
     case 1: o = ios_base::in; break;
@@ -514,27 +553,33 @@ uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
 }
 
 int32_t Runtime::pubsync(FId id) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   return rdbuf(id)->pubsync();
 }
 
 int32_t Runtime::sbumpc(FId id) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   return rdbuf(id)->sbumpc();
 }
 
 int32_t Runtime::sgetc(FId id) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   return rdbuf(id)->sgetc();
 }
 
 uint32_t Runtime::sgetn(FId id, char* c, uint32_t n) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   return rdbuf(id)->sgetn(c, n);
 }
 
 int32_t Runtime::sputc(FId id, char c) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputc(c) : c;
 }
 
 uint32_t Runtime::sputn(FId id, const char* c, uint32_t n) {
+  lock_guard<recursive_mutex> lg(io_lock_);
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputn(c, n) : n;
 }
@@ -553,6 +598,23 @@ void Runtime::run_logic() {
   if (finished_) {
     return;
   }
+  if ((checkpointer_ == nullptr) && (checkpoint_interval_ > 0)) {
+    checkpointer_ = new Checkpointer(checkpoint_path_);
+    checkpointer_->run();
+  }
+  if ((speculator_ == nullptr) && !speculation_.empty()) {
+    stringstream ss(speculation_);
+    for (string s; getline(ss, s, ':'); ) {
+      auto* march = read_march(s);
+      if (march == nullptr) {
+        ostream(rdbuf(stdwarn_)) << "Unrecognized march option '" << s << "', ignoring it for speculation" << endl;
+        continue;
+      }
+      marches_.push_back(march);
+    }
+    speculator_ = new Speculator(compiler_, [this]{ schedule_interrupt([this]{ speculate(); }); });
+    speculator_->run();
+  }
   while (!stop_requested() && !finished_) {
     if (enable_open_loop_ && !schedule_all_) {
       open_loop_scheduler();
@@ -560,6 +622,7 @@ void Runtime::run_logic() {
       reference_scheduler();
     }
     log_freq();
+    checkpoint();
   }
   if (finished_) {
     done_simulation();
@@ -651,8 +714,12 @@ void Runtime::resync() {
     return;
   } 
 
-  // Inline as much as we can and compile whatever is new. Reset the
-  // item_evals_ counter as soon as we're done.
+  // Real work takes precedence over speculative work. Inline as much as we
+  // can and compile whatever is new. Reset the item_evals_ counter as soon as
+  // we're done.
+  if (speculator_ != nullptr) {
+    speculator_->preempt();
+  }
   program_->inline_all();
   root_->synchronize(item_evals_);
   item_evals_ = 0;
@@ -685,9 +752,120 @@ void Runtime::resync() {
 
   // Determine whether we can reenter open loop in this state. 
   enable_open_loop_ = (logic_.size() == 2) && (clock_ != nullptr) && (inlined_logic_ != nullptr);
+  // Flatten the data plane before any engines are allowed to write to it
+  dp_->compact();
+  // Determine which modules can be evaluated concurrently
+  partition_logic();
+}
+
+void Runtime::partition_logic() {
+  batches_.clear();
+  if ((eval_threads_ <= 1) || enable_open_loop_) {
+    return;
+  }
+
+  // Two modules conflict if one reads a variable which the other writes, if
+  // they write the same variable, or if they write variables which are read
+  // by a third module. In any of these cases, evaluating them concurrently
+  // would race on the state of the module doing the writing or reading.
+  unordered_map<const Engine*, size_t> index;
+  for (size_t i = 0, ie = logic_.size(); i < ie; ++i) {
+    index[logic_[i]->engine()] = i;
+  }
+  const auto n = logic_.size();
+  vector<vector<bool>> conflict(n, vector<bool>(n, false));
+  vector<unordered_set<size_t>> sources(n);
+  for (VId id = 0, ide = dp_->size_ids(); id < ide; ++id) {
+    vector<size_t> ws;
+    for (auto w = dp_->writer_begin(id), we = dp_->writer_end(id); w != we; ++w) {
+      const auto itr = index.find(*w);
+      if (itr != index.end()) {
+        ws.push_back(itr->second);
+      }
+    }
+    for (auto r = dp_->reader_begin(id), re = dp_->reader_end(id); r != re; ++r) {
+      const auto itr = index.find(*r);
+      if (itr == index.end()) {
+        continue;
+      }
+      for (auto w : ws) {
+        conflict[w][itr->second] = conflict[itr->second][w] = true;
+        sources[itr->second].insert(w);
+      }
+    }
+    for (auto w1 : ws) {
+      for (auto w2 : ws) {
+        conflict[w1][w2] = true;
+      }
+    }
+  }
+  for (const auto& ss : sources) {
+    for (auto w1 : ss) {
+      for (auto w2 : ss) {
+        conflict[w1][w2] = true;
+      }
+    }
+  }
+  // Cores which aren't thread safe may share a device or a bus (ie: every
+  // engine produced by an avmm compiler talks to the same avalon master), so
+  // they conflict with each other regardless of what they read and write.
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      if (!logic_[i]->engine()->is_thread_safe() && !logic_[j]->engine()->is_thread_safe()) {
+        conflict[i][j] = true;
+      }
+    }
+  }
+
+  // Greedily color the conflict graph. Each color is a batch of modules which
+  // can be evaluated concurrently.
+  vector<size_t> color(n);
+  for (size_t i = 0; i < n; ++i) {
+    vector<bool> used(batches_.size(), false);
+    for (size_t j = 0; j < i; ++j) {
+      if (conflict[i][j]) {
+        used[color[j]] = true;
+      }
+    }
+    color[i] = find(used.begin(), used.end(), false) - used.begin();
+    if (color[i] == batches_.size()) {
+      batches_.emplace_back();
+    }
+    batches_[color[i]].push_back(logic_[i]);
+  }
+
+  // There's nothing to gain if every module conflicts with every other
+  if (batches_.size() == n) {
+    batches_.clear();
+  }
 }
 
 void Runtime::drain_active() {
+  // Parallel Case: Evaluate batches of non-conflicting modules concurrently.
+  // Each batch runs to completion before the next begins.
+  if (!batches_.empty()) {
+    for (auto done = false; !done; ) {
+      done = true;
+      for (const auto& b : batches_) {
+        ready_.clear();
+        for (auto* m : b) {
+          if (schedule_all_ || m->engine()->there_are_reads()) {
+            ready_.push_back(m);
+          }
+        }
+        if (!ready_.empty()) {
+          concurrent(ready_, [](Engine* e) {
+            e->evaluate();
+            return true;
+          });
+          done = false;
+        }
+      }
+      schedule_all_ = false;
+    }
+    return;
+  }
+
   for (auto done = false; !done; ) {
     done = true;
     for (auto* m : logic_) {
@@ -701,6 +879,26 @@ void Runtime::drain_active() {
 }
 
 bool Runtime::drain_updates() {
+  // Parallel Case: Same as below, but batch by batch
+  if (!batches_.empty()) {
+    auto performed_update = false;
+    for (const auto& b : batches_) {
+      if (concurrent(b, [](Engine* e) { return e->conditional_update(); })) {
+        performed_update = true;
+      }
+    }
+    if (!performed_update) {
+      return false;
+    }
+    auto performed_evaluate = false;
+    for (const auto& b : batches_) {
+      if (concurrent(b, [](Engine* e) { return e->conditional_evaluate(); })) {
+        performed_evaluate = true;
+      }
+    }
+    return performed_evaluate;
+  }
+
   auto performed_update = false;
   for (auto* m : logic_) {
     if (m->engine()->conditional_update()) {
@@ -719,6 +917,49 @@ bool Runtime::drain_updates() {
   return performed_evaluate;
 }
 
+bool Runtime::concurrent(const vector<Module*>& ms, bool (*f)(Engine*)) {
+  assert(!ms.empty());
+  if (ms.size() == 1) {
+    return f(ms[0]->engine());
+  }
+
+  // Hand all but the first module off to the pool and run the first one
+  // here. Block until the pool has finished the rest. Jobs capture only a
+  // pointer to this frame and an index, which is small enough for Job to
+  // store inline rather than allocating on every call.
+  struct Frame {
+    const vector<Module*>* ms;
+    bool (*f)(Engine*);
+    atomic<bool> res;
+    size_t remaining;
+    mutex lock;
+    condition_variable cv;
+  } frame;
+  frame.ms = &ms;
+  frame.f = f;
+  frame.res = false;
+  frame.remaining = ms.size() - 1;
+
+  for (size_t i = 1, ie = ms.size(); i < ie; ++i) {
+    auto* fp = &frame;
+    eval_pool_.insert([fp, i]{
+      if (fp->f((*fp->ms)[i]->engine())) {
+        fp->res = true;
+      }
+      lock_guard<mutex> lg(fp->lock);
+      if (--fp->remaining == 0) {
+        fp->cv.notify_one();
+      }
+    });
+  }
+  if (f(ms[0]->engine())) {
+    frame.res = true;
+  }
+  unique_lock<mutex> ul(frame.lock);
+  frame.cv.wait(ul, [&frame]{ return frame.remaining == 0; });
+  return frame.res;
+}
+
 void Runtime::done_step() {
   for (auto* m : done_logic_) {
     m->engine()->done_step();
@@ -732,34 +973,71 @@ void Runtime::done_simulation() {
 }
 
 void Runtime::drain_interrupts() {
-  lock_guard<recursive_mutex> lg(int_lock_);
-
-  // Fast Path: No interrupts
+  // Fast Path: No interrupts. This is a single relaxed load.
   if (ints_.empty()) {
     return;
   }
 
   // Slow Path: 
   // We have at least one interrupt, which could be an eval event or a jit
-  // handoff.  Schedule an interrupt at the end of the queue to handle these.
-  schedule_interrupt([this]{
-    resync();
-  });
-  for (size_t i = 0; i < ints_.size(); ++i) {
-    ints_[i]();
+  // handoff. Run the interrupts which are in the queue now, and then resync to
+  // handle these. Anything that they schedule (including interrupts like
+  // save() which reschedule themselves until there are no unhandled evals)
+  // runs on the far side of the resync, in the next pass. Interrupts can also
+  // arrive from other threads while we're doing this, so repeat until the
+  // queue is empty. Once the runtime has finished, wait for any pushes which
+  // are still in flight so that they can be fizzled.
+  do {
+    for (Interrupt int_; ints_.pop(int_); ) {
+      pending_ints_.push_back(move(int_));
+    }
+    for (auto& int_ : pending_ints_) {
+      int_();
+    }
+    pending_ints_.clear();
+    if (!finished_) {
+      resync();
+    }
+  } while (!ints_.empty() || (finished_ && (producers_ > 0)));
+
+  // Release any threads which were blocked on the interrupts we just ran
+  lock_guard<mutex> lg(block_lock_);
+  for (auto* b : blocked_) {
+    *b = true;
   }
-  ints_.clear();
+  blocked_.clear();
   block_cv_.notify_all();
 }
 
+bool Runtime::push_interrupt(Interrupt int_, Interrupt alt) {
+  // Producers announce themselves before checking finished_, and the runtime
+  // sets finished_ before checking for producers. Both are sequentially
+  // consistent, so either this interrupt sees that the runtime has finished,
+  // or the runtime waits for it to be pushed and then fizzles it.
+  ++producers_;
+  if (finished_) {
+    --producers_;
+    return false;
+  }
+  ints_.push([this, int_, alt]{
+    if (!finished_) {
+      int_();
+    } else {
+      alt();  
+    }
+  });
+  --producers_;
+  return true;
+}
+
 void Runtime::open_loop_scheduler() {
   // Record the current time, go open loop, and then record how long we were
   // gone for.  
-  const size_t then = ::time(nullptr);
+  const auto then = chrono::steady_clock::now();
   const auto id = clock_->engine()->get_clock_id();
   const auto val = clock_->engine()->get_clock_val();
   const auto itrs = inlined_logic_->engine()->open_loop(id, val, open_loop_itrs_);
-  const size_t now = ::time(nullptr);
+  const auto now = chrono::steady_clock::now();
 
   // If we ran for an odd number of iterations, flip the clock
   if (itrs % 2) {
@@ -769,15 +1047,27 @@ void Runtime::open_loop_scheduler() {
   drain_interrupts();
   logical_time_ += itrs;
 
-  // Update open loop iterations based on our target
-  const auto delta = now - then;
-  auto next = open_loop_itrs_;
-  if ((delta < open_loop_target_) && (open_loop_itrs_ == itrs)) {
-    next <<= 1;
-  } else if (delta > open_loop_target_) {
-    next >>= 1;
+  // Update our estimate of the simulation rate. Measurements are smoothed
+  // with an exponential moving average so that a single slow iteration (a
+  // page fault, or a preempted thread) doesn't throw off the controller. 
+  const auto delta = chrono::duration<double>(now - then).count();
+  if ((itrs == 0) || (delta <= 0)) {
+    return;
+  }
+  const auto rate = itrs / delta;
+  open_loop_rate_ = (open_loop_rate_ == 0) ? rate : (0.75 * open_loop_rate_ + 0.25 * rate);
+
+  // Aim for the number of iterations which will run for our target. Growth is
+  // capped to avoid overshooting on a noisy estimate, and we only grow if we
+  // ran for as long as we were asked to. Returning early because of a system
+  // task says nothing about how long a full run would have taken.
+  auto next = static_cast<size_t>(open_loop_rate_ * open_loop_target_);
+  if (itrs < open_loop_itrs_) {
+    next = min(next, open_loop_itrs_);
+  } else {
+    next = min(next, open_loop_itrs_ << 2);
   }
-  open_loop_itrs_ = (next > 0) ? next : open_loop_itrs_;
+  open_loop_itrs_ = max(next, static_cast<size_t>(2));
 }
 
 void Runtime::reference_scheduler() {
@@ -873,7 +1163,7 @@ void Runtime::log_freq() {
   if (profile_interval_ == 0) {
     return;
   }
-  if ((::time(nullptr) - last_check_) < profile_interval_) {
+  if ((::time(nullptr) - last_check_) < static_cast<time_t>(profile_interval_)) {
     return;
   }
   auto event = [this]{
@@ -883,6 +1173,72 @@ void Runtime::log_freq() {
   schedule_interrupt(event, event);
 }
 
+void Runtime::checkpoint() {
+  if ((checkpointer_ == nullptr) || (root_ == nullptr) || (item_evals_ > 0)) {
+    return;
+  }
+  if ((::time(nullptr) - last_checkpoint_) < static_cast<time_t>(checkpoint_interval_)) {
+    return;
+  }
+  // If the previous snapshot is still waiting to be written, there's no
+  // sense in paying for another one. Try again after the next step.
+  if (!checkpointer_->ready()) {
+    return;
+  }
+  auto* s = new Module::Snapshot();
+  root_->snapshot(s);
+  checkpointer_->write(s);
+  last_checkpoint_ = ::time(nullptr);
+}
+
+Program* Runtime::read_march(const string& s) {
+  ifstream ifs(System::src_root() + "share/cascade/march/" + s + ".v");
+  if (!ifs.is_open()) {
+    return nullptr;
+  }
+
+  // Temporarily relocate program_ and root_ so that we can scan the contents
+  // of this file using the eval_stream() infrastructure.  Also relocate the
+  // parser, as it will skip include guards that it's already seen.
+  auto* march = program_;
+  program_ = new Program();
+  auto* backup_root = root_;
+  root_ = nullptr;
+  auto* backup_parser = parser_;
+  parser_ = new Parser(log_);
+  const auto item_evals = item_evals_;
+
+  // Read the march file
+  eval_stream(ifs);
+  assert(!log_->error());
+
+  // Wap everything back into place and restore original state
+  std::swap(march, program_);
+  std::swap(backup_root, root_);
+  std::swap(backup_parser, parser_);
+  delete backup_parser;
+  if (backup_root != nullptr) {
+    delete backup_root;
+  }
+  item_evals_ = item_evals;
+
+  return march;
+}
+
+void Runtime::speculate() {
+  // As with retarget(), we can't inspect the module hierarchy if there are
+  // evals which haven't been handled yet. The resync which handles them will
+  // preempt the speculator, and it'll ask again once things quiet down.
+  if ((speculator_ == nullptr) || (root_ == nullptr) || (item_evals_ > 0)) {
+    return;
+  }
+  vector<ModuleDeclaration*> mds;
+  for (auto* m : marches_) {
+    root_->speculate(m, &mds);
+  }
+  speculator_->speculate(mds);
+}
+
 const Node* Runtime::resolve(const string& arg) {
   // Create a new navigation object and point it at the root
   Navigate nav(program_->root_elab()->second);
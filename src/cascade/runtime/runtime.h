@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_RUNTIME_H
 #define CASCADE_SRC_RUNTIME_RUNTIME_H
 
+#include <atomic>
 #include <condition_variable>
 #include <ctime>
 #include <functional>
@@ -40,6 +41,7 @@
 #include <vector>
 #include "common/bits.h"
 #include "common/log.h"
+#include "common/mpsc_queue.h"
 #include "common/thread.h"
 #include "common/thread_pool.h"
 #include "runtime/ids.h"
@@ -48,6 +50,7 @@
 
 namespace cascade {
 
+class Checkpointer;
 class Compiler;
 class DataPlane;
 class Isolate;
@@ -55,6 +58,7 @@ class Log;
 class Module;
 class Parser;
 class Program;
+class Speculator;
 
 class Runtime : public Thread {
   public:
@@ -80,9 +84,17 @@ class Runtime : public Thread {
     // thread. Invoking these methods afterwards is undefined.
     Runtime& set_fopen_dirs(const std::string& s);
     Runtime& set_include_dirs(const std::string& s);
-    Runtime& set_open_loop_target(size_t olt);
+    Runtime& set_open_loop_target(double olt);
     Runtime& set_disable_inlining(bool di);
     Runtime& set_profile_interval(size_t n);
+    Runtime& set_eval_threads(size_t n);
+    // Periodically writes a checkpoint of the running program to path, at
+    // most once every n seconds. A value of 0 for n disables checkpointing.
+    Runtime& set_checkpoint(const std::string& path, size_t n);
+    // Speculatively compiles the program for each of a colon separated list
+    // of march files while the runtime is idle, so that a later $retarget()
+    // can reuse the work. An empty list disables speculation.
+    Runtime& set_speculation(const std::string& s);
 
     // Major Component Accessors and Helpers:
     //
@@ -128,8 +140,9 @@ class Runtime : public Thread {
     // Schedules an asynchronous task. Asynchronous tasks begin execution out
     // of phase with the logic time and may begin and end mid-step. If an
     // asynchronous task invokes any of the schedule_xxx_interrupt methods, it
-    // must use the two-argument form.
-    void schedule_asynchronous(Asynchronous async);
+    // must use the two-argument form. Tasks with higher priority are started
+    // first.
+    void schedule_asynchronous(Asynchronous async, ThreadPool::Priority p = ThreadPool::Priority::NORMAL);
     // Returns true if the runtime has executed a finish statement.
     bool is_finished() const;
     // Resets the open loop iteration counter
@@ -176,13 +189,21 @@ class Runtime : public Thread {
     bool disable_inlining_;
     bool enable_open_loop_;
     size_t open_loop_itrs_;
-    size_t open_loop_target_;
+    double open_loop_target_;
+    double open_loop_rate_;
     size_t profile_interval_;
+    size_t eval_threads_;
+    std::string checkpoint_path_;
+    size_t checkpoint_interval_;
+    std::string speculation_;
 
-    // Thread Pool:
+    // Thread Pools:
     ThreadPool pool_;
+    ThreadPool eval_pool_;
 
     // Major Components:
+    Checkpointer* checkpointer_;
+    Speculator* speculator_;
     Log* log_;
     Parser* parser_;
     Compiler* compiler_;
@@ -193,20 +214,29 @@ class Runtime : public Thread {
     Program* program_;
     Module* root_;
     Engine::Id next_id_;
+    std::vector<Program*> marches_;
 
     // Interrupt Queue:
-    bool finished_;
+    std::atomic<bool> finished_;
     size_t item_evals_;
-    std::vector<Interrupt> ints_;
-    std::recursive_mutex int_lock_;
+    MpscQueue<Interrupt> ints_;
+    std::vector<Interrupt> pending_ints_;
+    std::atomic<size_t> producers_;
     std::mutex block_lock_;
     std::condition_variable block_cv_;
+    std::vector<bool*> blocked_;
 
     // Generic Scheduling State:
     std::vector<Module*> logic_;
     std::vector<Module*> done_logic_;
     bool schedule_all_;
 
+    // Parallel Scheduling State:
+    // Groups of modules which don't share any wires and can be evaluated
+    // concurrently. Empty when the scheduler is running serially.
+    std::vector<std::vector<Module*>> batches_;
+    std::vector<Module*> ready_;
+
     // Optimized Scheduling State:
     Module* clock_;
     Module* inlined_logic_;
@@ -215,6 +245,7 @@ class Runtime : public Thread {
     time_t begin_time_;
     time_t last_time_;
     time_t last_check_;
+    time_t last_checkpoint_;
     uint64_t last_logical_time_;
     uint64_t logical_time_;
 
@@ -222,6 +253,9 @@ class Runtime : public Thread {
     // Tracks streambufs and whether they are owned by the runtime (and can be
     // destroyed on teardown)
     std::vector<std::pair<std::streambuf*, bool>> streambufs_;
+    // Serializes system tasks and stream i/o which originate from modules
+    // that are being evaluated concurrently
+    std::recursive_mutex io_lock_;
 
     // Implements the semantics of the Verilog Simulation Reference Model and
     // services interrupts between logical simulation steps.
@@ -247,6 +281,10 @@ class Runtime : public Thread {
     // 
     // Called whenever an interrupt is queued to handle evals or jit handoffs.
     void resync();
+    // Partitions logic_ into batches of modules which can be evaluated
+    // concurrently based on the reader and writer registrations in the
+    // dataplane.
+    void partition_logic();
 
     // Verilog Simulation Loop Scheduling Helpers:
     //
@@ -255,12 +293,18 @@ class Runtime : public Thread {
     // Drains update events for all modules with updates. Return true if doing
     // so resulted in new active events.
     bool drain_updates();
+    // Invokes f on each of the modules in ms concurrently and blocks until
+    // they have all completed. Returns true if any invocation returned true.
+    bool concurrent(const std::vector<Module*>& ms, bool (*f)(Engine*));
     // Invokes done_step on every module, completing the logical simulation step
     void done_step();
     // Invokes done_simulation on every module, completing the simulation
     void done_simulation();
     // Drains the interrupt queue
     void drain_interrupts();
+    // Enqueues int_, which fizzles by running alt. Returns false without
+    // enqueuing anything if the runtime has already finished.
+    bool push_interrupt(Interrupt int_, Interrupt alt);
 
     // Runs in open loop until timeout or a system task is triggered
     void open_loop_scheduler();
@@ -282,6 +326,25 @@ class Runtime : public Thread {
     // Dumps the current virtual clock frequency to stdlog
     void log_freq();
 
+    // Checkpoint Helpers:
+    //
+    // Captures a snapshot of the program and hands it off to the checkpointer
+    // if enough time has passed since the last one. Must be invoked between
+    // logical simulation steps.
+    void checkpoint();
+
+    // Speculation Helpers:
+    //
+    // Reads a march file into a new program without disturbing the state of
+    // the running program. Returns nullptr if the file doesn't exist. Must be
+    // invoked in a state where it would be safe to invoke $retarget().
+    Program* read_march(const std::string& s);
+    // Hands the speculator a fresh set of work based on the current state of
+    // the program. The speculator asks for this by scheduling an interrupt
+    // once it's ready to run, so that we only pay for copying the program when
+    // the work will actually be used.
+    void speculate();
+
     // Debug Helpers:
     //
     // Resolves an id in the program. Returns nullptr on failure.
@@ -0,0 +1,155 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "runtime/speculator.h"
+
+#include "runtime/module.h"
+#include "target/compiler.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace {
+
+// How long the runtime has to be quiet before we begin, and how long to back
+// off for when a compiler asks us to try again later.
+constexpr auto idle_ = chrono::milliseconds(1000);
+
+} // namespace
+
+namespace cascade {
+
+Speculator::Speculator(Compiler* compiler, const function<void()>& request) : Thread() {
+  compiler_ = compiler;
+  request_ = request;
+  quiet_ = chrono::steady_clock::now() + idle_;
+  generation_ = 0;
+  stale_ = true;
+}
+
+Speculator::~Speculator() {
+  preempt();
+  stop_now();
+  release();
+}
+
+void Speculator::speculate(vector<ModuleDeclaration*>& mds) {
+  lock_guard<mutex> lg(lock_);
+  ++generation_;
+  release();
+  sources_ = mds;
+  mds.clear();
+  stale_ = false;
+}
+
+void Speculator::preempt() {
+  { lock_guard<mutex> lg(lock_);
+    ++generation_;
+    release();
+    quiet_ = chrono::steady_clock::now() + idle_;
+    stale_ = true;
+  }
+  compiler_->stop_precompile();
+}
+
+void Speculator::run_logic() {
+  while (!stop_requested()) {
+    // Grab the next piece of work, preferring passes which are ready to go
+    ModuleDeclaration* md = nullptr;
+    auto ready = false;
+    auto request = false;
+    size_t generation = 0;
+    { lock_guard<mutex> lg(lock_);
+      if (chrono::steady_clock::now() >= quiet_) {
+        if (!passes_.empty()) {
+          md = passes_.front();
+          passes_.pop_front();
+          ready = true;
+        } else if (!sources_.empty()) {
+          md = sources_.back();
+          sources_.pop_back();
+        } else if (stale_) {
+          request = true;
+          stale_ = false;
+        }
+      }
+      generation = generation_;
+    }
+    // Ask the runtime for fresh work if there's nothing left to do. If it
+    // doesn't have any, we'll wait until the next time we're preempted.
+    if (request) {
+      request_();
+    }
+    if (md == nullptr) {
+      wait_for(100);
+      continue;
+    }
+
+    // Split sources into passes. This is the expensive part of the work that
+    // takes place in the runtime, so we're careful to only do it once.
+    if (!ready) {
+      vector<ModuleDeclaration*> passes;
+      Module::jit_passes(md, &passes);
+      lock_guard<mutex> lg(lock_);
+      for (auto* p : passes) {
+        if (generation == generation_) {
+          passes_.push_back(p);
+        } else {
+          delete p;
+        }
+      }
+      continue;
+    }
+
+    // Hand passes to the compiler. If it's busy, put them back and try again
+    // once it's had a chance to finish.
+    const auto done = compiler_->precompile(md);
+    lock_guard<mutex> lg(lock_);
+    if (!done && (generation == generation_)) {
+      passes_.push_front(md);
+      quiet_ = chrono::steady_clock::now() + idle_;
+    } else {
+      delete md;
+    }
+  }
+}
+
+void Speculator::release() {
+  for (auto* s : sources_) {
+    delete s;
+  }
+  sources_.clear();
+  for (auto* p : passes_) {
+    delete p;
+  }
+  passes_.clear();
+}
+
+} // namespace cascade
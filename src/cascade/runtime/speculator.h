@@ -0,0 +1,97 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_RUNTIME_SPECULATOR_H
+#define CASCADE_SRC_RUNTIME_SPECULATOR_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+#include "common/thread.h"
+#include "verilog/ast/ast_fwd.h"
+
+namespace cascade {
+
+class Compiler;
+
+// Runs speculative compilations on behalf of the runtime: sources which the
+// program is likely to need next, such as the current design retargeted to
+// another march. Work only begins once the runtime has been quiet for a
+// moment and is abandoned as soon as real work arrives. Compilers use this
+// work to populate their caches, so that the real compilation, if it ever
+// happens, finishes sooner. Copying the program isn't free, so the runtime
+// only does so when this thread asks for it.
+
+class Speculator : public Thread {
+  public:
+    // Constructors:
+    //
+    // Request is invoked on this thread whenever the runtime has been quiet
+    // for long enough and the work we have is out of date. It should arrange
+    // for speculate() to be invoked with fresh work, and return immediately.
+    Speculator(Compiler* compiler, const std::function<void()>& request);
+    ~Speculator() override;
+
+    // Replaces any pending work with mds. This method takes ownership of the
+    // elements of mds and returns immediately.
+    void speculate(std::vector<ModuleDeclaration*>& mds);
+    // Abandons pending and in-flight work, marks it as out of date, and
+    // restarts the idle timer. This method returns immediately.
+    void preempt();
+
+  private:
+    // Runtime Handles:
+    Compiler* compiler_;
+    std::function<void()> request_;
+
+    // Pending Work:
+    // Sources which haven't been split into passes yet, and passes which are
+    // ready to be handed to the compiler. Work from an older generation is
+    // discarded rather than being returned to these queues.
+    std::mutex lock_;
+    std::vector<ModuleDeclaration*> sources_;
+    std::deque<ModuleDeclaration*> passes_;
+    std::chrono::steady_clock::time_point quiet_;
+    size_t generation_;
+    bool stale_;
+
+    // Thread Interface:
+    void run_logic() override;
+
+    // Helpers:
+    void release();
+};
+
+} // namespace cascade
+
+#endif
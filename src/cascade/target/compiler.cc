@@ -94,7 +94,9 @@ Engine* Compiler::compile(Engine::Id id, ModuleDeclaration* md) {
     return nullptr;
   }
 
-  ids_.insert(id);
+  { lock_guard<mutex> lg(lock_);
+    ids_.insert(id);
+  }
   auto* c = cc->compile(id, md, i);
   if (c == nullptr) {
     delete i;
@@ -116,9 +118,30 @@ void Compiler::stop_async() {
   }
 }
 
+bool Compiler::precompile(const ModuleDeclaration* md) {
+  // Remote compilations and stubs never make it as far as a core compiler
+  const auto loc = md->get_attrs()->get<String>("__loc")->get_readable_val();
+  if (((loc != "remote") && (loc != "local")) || StubCheck().check(md)) {
+    return true;
+  }
+  const auto target = md->get_attrs()->get<String>("__target")->get_readable_val();
+  auto* cc = get(target);
+  return (cc == nullptr) || cc->precompile(md);
+}
+
+void Compiler::stop_precompile() {
+  for (auto& cc : ccs_) {
+    cc.second->stop_precompile();
+  }
+}
+
 void Compiler::stop_compile() {
+  unordered_set<Engine::Id> ids;
+  { lock_guard<mutex> lg(lock_);
+    ids = ids_;
+  }
   for (auto& cc : ccs_) {
-    for (auto id : ids_) {
+    for (auto id : ids) {
       cc.second->stop_compile(id);
     }
   }
@@ -81,6 +81,18 @@ class Compiler {
     // Invokes stop_async() on all registered compilers.
     void stop_async();
 
+    // Speculation Interface:
+    //
+    // These methods are thread-safe.
+    //
+    // Invokes precompile() on the core compiler specified by the __target
+    // annotation. This method does not take ownership of md, and blocks until
+    // the work is done, abandoned, or deferred. Returns false only in the
+    // last case. Errors are not reported.
+    bool precompile(const ModuleDeclaration* md);
+    // Invokes stop_precompile() on all registered compilers.
+    void stop_precompile();
+
     // Error Reporting Interface:
     //
     // These methods are all thread safe and report errors if any in-flight
@@ -44,6 +44,7 @@ class LocalInterface : public Interface {
 
     void write(VId id, const Bits* b) override;
     void write(VId id, bool b) override;
+    void write_changed(VId id, const Bits* b) override;
 
     void debug(uint32_t action, const std::string& arg) override;
     void finish(uint32_t arg) override;
@@ -78,6 +79,10 @@ inline void LocalInterface::write(VId id, bool b) {
   rt_->get_data_plane()->write(id, b);
 }
 
+inline void LocalInterface::write_changed(VId id, const Bits* b) {
+  rt_->get_data_plane()->write_changed(id, b);
+}
+
 inline void LocalInterface::debug(uint32_t action, const std::string& arg) {
   rt_->debug(action, arg);
 }
@@ -81,6 +81,11 @@ class Core {
     // arbitrary logic at the end of the simulation. The default implementation
     // does nothing.
     virtual void done_simulation();
+    // Overriding this method to return true will allow the runtime to evaluate
+    // this core concurrently with other cores. This is only safe for cores
+    // which don't share a device, bus, or channel with any other core. The
+    // default implementation returns false.
+    virtual bool is_thread_safe() const;
 
     // This method is invoked whenever new values are presented on this
     // module's input ports. It is required to perform whatever internal logic
@@ -206,6 +211,10 @@ inline void Core::done_simulation() {
   // Does nothing.
 }
 
+inline bool Core::is_thread_safe() const {
+  return false;
+}
+
 inline bool Core::conditional_update() {
   if (there_are_updates()) {
     update();
@@ -57,8 +57,17 @@ class AvmmCompiler : public CoreCompiler {
     AvmmCompiler();
     ~AvmmCompiler() override = default;
 
+    // Configuration Interface:
+    //
+    // When enabled, compilations are requested through compile_slots() rather
+    // than compile(), giving targets the opportunity to build each slot
+    // separately and reuse the work for slots which haven't changed.
+    AvmmCompiler& set_slot_compilation(bool enable);
+
     // Core Compiler Interface:
     void stop_compile(Engine::Id id) override;
+    bool precompile(const ModuleDeclaration* md) override;
+    void stop_precompile() override;
 
   protected:
     // Avalon Memory Mapped Compiler Interface
@@ -74,9 +83,27 @@ class AvmmCompiler : public CoreCompiler {
     // return true on success, and false on failure, say if stop_compile
     // interrupted a compilation.
     virtual bool compile(const std::string& text, std::mutex& lock) = 0;
+    // This method is invoked in place of compile() when slot compilation is
+    // enabled. Slots maps the index of each occupied slot to the text of its
+    // M<n> module. Semantics are otherwise identical. The default
+    // implementation concatenates the slots and invokes compile().
+    virtual bool compile_slots(const std::map<MId, std::string>& slots, std::mutex& lock);
     // This method should perform whatever target-specific logic is necessary
     // to stop the execution of any invocations of compile().
     virtual void stop_compile() = 0;
+    // These methods are invoked by precompile() with the text that compile()
+    // or compile_slots() would be asked to build if md were compiled into
+    // slot next. Implementations should prepare whatever they can, say by
+    // populating a cache, but must not touch the device. They are called in
+    // the same context as compile(), and should return promptly once
+    // stop_compile() is invoked. The default implementations do nothing.
+    virtual void speculate(const std::string& text, std::mutex& lock);
+    virtual void speculate_slots(const std::map<MId, std::string>& slots, MId slot, std::mutex& lock);
+
+    // Codegen Helpers:
+    //
+    // Returns the text of a program_logic module containing slots.
+    std::string get_text(const std::map<MId, std::string>& slots) const;
 
   private:
     // Compilation States:
@@ -94,6 +121,10 @@ class AvmmCompiler : public CoreCompiler {
       std::string text;
     };
 
+    // Configuration State:
+    bool slot_compilation_;
+    bool speculating_;
+
     // Program Management:
     std::mutex lock_;
     std::condition_variable cv_;
@@ -102,19 +133,31 @@ class AvmmCompiler : public CoreCompiler {
     // Core Compiler Interface:
     AvmmLogic<V,A,T>* compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
 
+    // Compilation Helpers:
+    bool check(ModuleInfo& info, bool report);
+    void index(AvmmLogic<V,A,T>* al, ModuleInfo& info);
+
     // Slot Management Helpers:
+    bool is_busy() const;
     int get_free() const;
     void release(size_t slot);
     void update();
-
-    // Codegen Helpers:
-    std::string get_text();
+    std::map<MId, std::string> get_slots() const;
 };
 
 template <size_t M, size_t V, typename A, typename T>
 inline AvmmCompiler<M,V,A,T>::AvmmCompiler() : CoreCompiler() {
   const auto num_slots = T(1) << M;
   slots_.resize(num_slots, {0, State::FREE, ""});
+  slot_compilation_ = false;
+  speculating_ = false;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline AvmmCompiler<M,V,A,T>& AvmmCompiler<M,V,A,T>::set_slot_compilation(bool enable) {
+  std::lock_guard<std::mutex> lg(lock_);
+  slot_compilation_ = enable;
+  return *this;
 }
 
 template <size_t M, size_t V, typename A, typename T>
@@ -165,18 +208,7 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
   ModuleInfo info(md);
 
   // Check for unsupported language features
-  auto unsupported = false;
-  if (info.uses_mixed_triggers()) {
-    get_compiler()->error("Avmm backends do not currently support code with mixed triggers!");
-    unsupported = true;
-  } else if (!info.implied_latches().empty()) {
-    get_compiler()->error("Avmm backends do not currently support the use of implied latches!");
-    unsupported = true;
-  } else if (info.uses_multiple_clocks()) {
-    get_compiler()->error("Avmm backends do not currently support the use of multiple clocks!");
-    unsupported = true;
-  }
-  if (unsupported) {
+  if (!check(info, true)) {
     delete md;
     return nullptr;
   }
@@ -189,33 +221,9 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
     return nullptr;
   }
   
-  // Register inputs, state, and outputs. Invoke these methods
-  // lexicographically to ensure a deterministic variable table ordering. The
-  // final invocation of index_tasks is lexicographic by construction, as it's
-  // based on a recursive descent of the AST.
+  // Register inputs, state, and outputs.
   auto* al = build(interface, md, slot);
-  std::map<VId, const Identifier*> is;
-  for (auto* i : info.inputs()) {
-    is.insert(std::make_pair(to_vid(i), i));
-  }
-  for (const auto& i : is) {
-    al->set_input(i.second, i.first);
-  }
-  std::map<VId, const Identifier*> ss;
-  for (auto* s : info.stateful()) {
-    ss.insert(std::make_pair(to_vid(s), s));
-  }
-  for (const auto& s : ss) {
-    al->set_state(s.second, s.first);
-  }
-  std::map<VId, const Identifier*> os;
-  for (auto* o : info.outputs()) {
-    os.insert(std::make_pair(to_vid(o), o));
-  }
-  for (const auto& o : os) {
-    al->set_output(o.second, o.first);
-  }
-  al->index_tasks();
+  index(al, info);
   // Check table and index sizes. If this program uses too much state, we won't
   // be able to uniquely name its elements using our current addressing scheme.
 
@@ -247,7 +255,7 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
   while (true) {
     switch (slots_[slot].state) {
       case State::COMPILING:
-        if (compile(get_text(), lock_)) {
+        if (slot_compilation_ ? compile_slots(get_slots(), lock_) : compile(get_text(get_slots()), lock_)) {
           update();
         }
         break;
@@ -269,6 +277,135 @@ inline AvmmLogic<V,A,T>* AvmmCompiler<M,V,A,T>::compile_logic(Engine::Id id, Mod
   }
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline bool AvmmCompiler<M,V,A,T>::precompile(const ModuleDeclaration* md) {
+  if (!md->get_attrs()->get<String>("__std")->eq("logic")) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lg(lock_);
+
+  // Don't compete with real compilations. Whatever we would produce here would
+  // likely be out of date by the time they finished anyway.
+  if (is_busy()) {
+    return false;
+  }
+  const auto slot = get_free();
+  if (slot == -1) {
+    return true;
+  }
+
+  // Generate the text for the slot this module would be assigned to, exactly
+  // as compile_logic() would. The logic core is only used to build a
+  // variable table, and never touches the device.
+  auto* md2 = md->clone();
+  ModuleInfo info(md2);
+  AvmmLogic<V,A,T> al(nullptr, md2, slot);
+  if (!check(info, false)) {
+    return true;
+  }
+  index(&al, info);
+  if (al.get_table()->size() >= (T(1) << V)) {
+    return true;
+  }
+  auto slots = get_slots();
+  slots[slot] = Rewrite<M,V,A,T>().run(md2, slot, al.get_table(), al.open_loop_clock());
+
+  speculating_ = true;
+  if (slot_compilation_) {
+    speculate_slots(slots, slot, lock_);
+  } else {
+    speculate(get_text(slots), lock_);
+  }
+  speculating_ = false;
+
+  return true;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void AvmmCompiler<M,V,A,T>::stop_precompile() {
+  // Only interrupt speculative work. If a real compilation has started in
+  // the meantime, it's already taken care of stopping us.
+  std::lock_guard<std::mutex> lg(lock_);
+  if (speculating_ && !is_busy()) {
+    stop_compile();
+  }
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool AvmmCompiler<M,V,A,T>::compile_slots(const std::map<MId, std::string>& slots, std::mutex& lock) {
+  return compile(get_text(slots), lock);
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void AvmmCompiler<M,V,A,T>::speculate(const std::string& text, std::mutex& lock) {
+  // Does nothing.
+  (void) text;
+  (void) lock;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void AvmmCompiler<M,V,A,T>::speculate_slots(const std::map<MId, std::string>& slots, MId slot, std::mutex& lock) {
+  // Does nothing.
+  (void) slots;
+  (void) slot;
+  (void) lock;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool AvmmCompiler<M,V,A,T>::check(ModuleInfo& info, bool report) {
+  std::string what = "";
+  if (info.uses_mixed_triggers()) {
+    what = "Avmm backends do not currently support code with mixed triggers!";
+  } else if (!info.implied_latches().empty()) {
+    what = "Avmm backends do not currently support the use of implied latches!";
+  } else if (info.uses_multiple_clocks()) {
+    what = "Avmm backends do not currently support the use of multiple clocks!";
+  }
+  if (report && !what.empty()) {
+    get_compiler()->error(what);
+  }
+  return what.empty();
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void AvmmCompiler<M,V,A,T>::index(AvmmLogic<V,A,T>* al, ModuleInfo& info) {
+  // Invoke these methods lexicographically to ensure a deterministic variable
+  // table ordering. The final invocation of index_tasks is lexicographic by
+  // construction, as it's based on a recursive descent of the AST.
+  std::map<VId, const Identifier*> is;
+  for (auto* i : info.inputs()) {
+    is.insert(std::make_pair(to_vid(i), i));
+  }
+  for (const auto& i : is) {
+    al->set_input(i.second, i.first);
+  }
+  std::map<VId, const Identifier*> ss;
+  for (auto* s : info.stateful()) {
+    ss.insert(std::make_pair(to_vid(s), s));
+  }
+  for (const auto& s : ss) {
+    al->set_state(s.second, s.first);
+  }
+  std::map<VId, const Identifier*> os;
+  for (auto* o : info.outputs()) {
+    os.insert(std::make_pair(to_vid(o), o));
+  }
+  for (const auto& o : os) {
+    al->set_output(o.second, o.first);
+  }
+  al->index_tasks();
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool AvmmCompiler<M,V,A,T>::is_busy() const {
+  for (const auto& s : slots_) {
+    if ((s.state == State::COMPILING) || (s.state == State::WAITING)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline int AvmmCompiler<M,V,A,T>::get_free() const {
   for (size_t i = 0, ie = slots_.size(); i < ie; ++i) {
@@ -301,20 +438,23 @@ inline void AvmmCompiler<M,V,A,T>::update() {
 }
 
 template <size_t M, size_t V, typename A, typename T>
-inline std::string AvmmCompiler<M,V,A,T>::get_text() {
-  std::stringstream ss;
-  indstream os(ss);
-
-  // Generate code for modules
+inline std::map<MId, std::string> AvmmCompiler<M,V,A,T>::get_slots() const {
   std::map<MId, std::string> text;
   for (size_t i = 0, ie = slots_.size(); i < ie; ++i) {
     if (slots_[i].state != State::FREE) {
       text.insert(std::make_pair(i, slots_[i].text));
     }
   }
+  return text;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string AvmmCompiler<M,V,A,T>::get_text(const std::map<MId, std::string>& slots) const {
+  std::stringstream ss;
+  indstream os(ss);
 
   // Module Declarations
-  for (const auto& s : text) {
+  for (const auto& s : slots) {
     os << s.second << std::endl;
     os << std::endl;
   }
@@ -342,7 +482,7 @@ inline std::string AvmmCompiler<M,V,A,T>::get_text() {
   os << "wire[" << (V-1) << ":0] __vid = s0_address[" << (V-1) << ":0];" << std::endl;
 
   os << "// Module Instantiations:" << std::endl;
-  for (const auto& s : text) {
+  for (const auto& s : slots) {
     os << "wire[" << (std::numeric_limits<T>::digits-1) << ":0] m" << s.first << "_out;" << std::endl;
     os << "wire m" << s.first << "_wait;" << std::endl;
     os << "M" << s.first << " m" << s.first << "(" << std::endl;
@@ -365,7 +505,7 @@ inline std::string AvmmCompiler<M,V,A,T>::get_text() {
   os.tab();
   os << "case (__mid)" << std::endl;
   os.tab();
-  for (const auto& s : text) {
+  for (const auto& s : slots) {
     os << s.first << ": begin rd = m" << s.first << "_out; wr = m" << s.first << "_wait; end" << std::endl;
   }
   os << "default: begin rd = 0; wr = 0; end" << std::endl;
@@ -30,9 +30,17 @@
 
 #include "target/core/avmm/de10/quartus_server.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
+#include <functional>
 #include <sstream>
+#include <sys/file.h>
+#include <unistd.h>
+#include <vector>
 #include "common/sockserver.h"
 #include "common/sockstream.h"
 #include "common/system.h"
@@ -43,6 +51,7 @@ namespace cascade::avmm {
 
 QuartusServer::QuartusServer() : Thread() { 
   set_cache_path("/tmp/quartus_cache/");
+  set_cache_size(0);
   set_quartus_path("");
   set_quartus_tunnel_command("");
   set_port(9900);
@@ -55,6 +64,11 @@ QuartusServer& QuartusServer::set_cache_path(const string& path) {
   return *this;
 }
 
+QuartusServer& QuartusServer::set_cache_size(size_t bytes) {
+  cache_size_ = bytes;
+  return *this;
+}
+
 QuartusServer& QuartusServer::set_quartus_path(const string& path) {
   quartus_path_ = path;
   return *this;
@@ -147,23 +161,17 @@ void QuartusServer::run_logic() {
       pool_.insert([this, sock]{
         string text = "";
         getline(*sock, text, '\0'); 
-        const auto res = compile(text);
+        string rbf = "";
+        const auto res = compile(text, &rbf);
         sock->put(static_cast<uint8_t>(res ? Rpc::OKAY : Rpc::ERROR));
         sock->flush();
 
         if (res) {
           sock->get();
           
-          const auto itr = cache_.find(text);
-          assert(itr != cache_.end());
-          ifstream ifs(cache_path_ + "/" + itr->second, ios::binary);
-          
-          stringstream rbf;
-          rbf << ifs.rdbuf();
-          uint32_t len = rbf.str().length();
-
+          uint32_t len = rbf.length();
           sock->write(reinterpret_cast<const char*>(&len), sizeof(len));
-          sock->write(rbf.str().c_str(), len);
+          sock->write(rbf.c_str(), len);
           sock->flush();    
 
           sock->get();
@@ -195,37 +203,50 @@ void QuartusServer::init_pool() {
 void QuartusServer::init_cache() {
   // Create the cache if it doesn't already exist
   System::execute("mkdir -p " + cache_path_);
-  System::execute("touch " + cache_path_ + "/index.txt");
 
-  // Read cache into memory
+  // Older versions of the cache kept an index of full program texts. Move
+  // any entries that we find there into the digest-indexed format.
   ifstream ifs(cache_path_ + "/index.txt");
-  cache_.clear();
+  if (!ifs.is_open()) {
+    return;
+  }
+  const auto fd = lock_cache();
   while (true) {
     string text;
     getline(ifs, text, '\0');
     if (ifs.eof()) {
       break;
     } 
-
     string path;
     getline(ifs, path, '\0');
-    cache_.insert(make_pair(text, path));
+
+    ifstream ifs2(cache_path_ + "/" + path, ios::binary);
+    if (ifs2.is_open()) {
+      stringstream rbf;
+      rbf << ifs2.rdbuf();
+      cache_insert(digest(text), text, rbf.str(), 0);
+    }
+    remove((cache_path_ + "/" + path).c_str());
   } 
+  remove((cache_path_ + "/index.txt").c_str());
+  cache_evict();
+  unlock_cache(fd);
 }
-
 void QuartusServer::kill_all() {
   // Note that we don't kill anything downstream of place and route as these
   // passess all run to completion in short order.
   System::execute(R"(pkill -9 -P `ps -ax | grep build_de10.sh | awk '{print $1}' | head -n1`)");
 }
 
-bool QuartusServer::compile(const std::string& text) {
+bool QuartusServer::compile(const string& text, string* rbf) {
   // Nothing to do if this code is already in the cache. 
-  if (cache_.find(text) != cache_.end()) {
+  const auto key = digest(text);
+  if (cache_find(key, text, rbf)) {
     return true;
   }
 
   // Otherwise, compile the code and add a new entry to the cache
+  const auto begin = time(nullptr);
   System::execute("mkdir -p /tmp/de10/");
   char path[] = "/tmp/de10/program_logic_XXXXXX.v";
   const auto fd = mkstemps(path, 2);
@@ -247,18 +268,142 @@ bool QuartusServer::compile(const std::string& text) {
   }
   System::no_block_execute("cd " + dir + " && ./assemble_de10.sh \"" + quartus_tunnel_command_ + " " + quartus_path_ + "\"", true);
 
+  ifstream ifs(dir + "/output_files/DE10_NANO_SoC_GHRD.rbf", ios::binary);
+  if (!ifs.is_open()) {
+    return false;
+  }
   stringstream ss;
-  ss << "bitstream_" << cache_.size() << ".rbf";
-  const auto file = ss.str();
-  System::execute("cp " + dir + "/output_files/DE10_NANO_SoC_GHRD.rbf " + cache_path_ + "/" + file);
-
-  ofstream ofs2(cache_path_ + "/index.txt", ios::app);
-  ofs2 << text << '\0' << file << '\0';
-  ofs2.flush();
+  ss << ifs.rdbuf();
+  *rbf = ss.str();
 
-  cache_[text] = file;
+  const auto lfd = lock_cache();
+  cache_insert(key, text, *rbf, time(nullptr) - begin);
+  cache_evict();
+  unlock_cache(lfd);
 
   return true;
 }
 
+string QuartusServer::digest(const string& text) const {
+  // Collisions are harmless: entries store their text and are only used on
+  // an exact match.
+  stringstream ss;
+  ss << hex << hash<string>()(text);
+  return ss.str();
+}
+
+int QuartusServer::lock_cache() const {
+  const auto fd = open((cache_path_ + "/lock").c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd != -1) {
+    flock(fd, LOCK_EX);
+  }
+  return fd;
+}
+
+void QuartusServer::unlock_cache(int fd) const {
+  if (fd != -1) {
+    flock(fd, LOCK_UN);
+    close(fd);
+  }
+}
+
+bool QuartusServer::cache_find(const string& key, const string& text, string* rbf) const {
+  const auto fd = lock_cache();
+
+  Meta meta;
+  auto res = read_meta(key, &meta);
+  if (res) {
+    ifstream ifs(cache_path_ + "/" + key + ".v", ios::binary);
+    stringstream ss;
+    ss << ifs.rdbuf();
+    res = ifs.is_open() && (ss.str() == text);
+  }
+  if (res) {
+    ifstream ifs(cache_path_ + "/" + key + ".rbf", ios::binary);
+    stringstream ss;
+    ss << ifs.rdbuf();
+    *rbf = ss.str();
+    res = ifs.is_open() && (rbf->length() == meta.size);
+  }
+  if (res) {
+    ++meta.hits;
+    meta.last_used = time(nullptr);
+    write_meta(key, meta);
+  }
+
+  unlock_cache(fd);
+  return res;
+}
+
+void QuartusServer::cache_insert(const string& key, const string& text, const string& rbf, time_t compile_time) const {
+  // The metadata file is written last; entries without one are ignored.
+  write_file(cache_path_ + "/" + key + ".rbf", rbf);
+  write_file(cache_path_ + "/" + key + ".v", text);
+  write_meta(key, {compile_time, rbf.length(), 0, time(nullptr)});
+}
+
+void QuartusServer::cache_evict() const {
+  if (cache_size_ == 0) {
+    return;
+  }
+
+  // Collect the metadata for every entry in the cache
+  vector<pair<string, Meta>> entries;
+  size_t total = 0;
+  auto* dir = opendir(cache_path_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  for (auto* de = readdir(dir); de != nullptr; de = readdir(dir)) {
+    const string name = de->d_name;
+    if ((name.length() <= 5) || (name.substr(name.length()-5) != ".meta")) {
+      continue;
+    }
+    const auto key = name.substr(0, name.length()-5);
+    Meta meta;
+    if (read_meta(key, &meta)) {
+      entries.push_back(make_pair(key, meta));
+      total += meta.size;
+    }
+  }
+  closedir(dir);
+
+  // Remove least recently used entries until we're under the bound. Always
+  // leave at least one entry, even if it exceeds the bound by itself.
+  sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+    return a.second.last_used < b.second.last_used;
+  });
+  for (size_t i = 0; (total > cache_size_) && (i+1 < entries.size()); ++i) {
+    const auto& e = entries[i];
+    remove((cache_path_ + "/" + e.first + ".meta").c_str());
+    remove((cache_path_ + "/" + e.first + ".rbf").c_str());
+    remove((cache_path_ + "/" + e.first + ".v").c_str());
+    total -= e.second.size;
+  }
+}
+
+bool QuartusServer::read_meta(const string& key, Meta* meta) const {
+  ifstream ifs(cache_path_ + "/" + key + ".meta");
+  ifs >> meta->compile_time >> meta->size >> meta->hits >> meta->last_used;
+  return !ifs.fail();
+}
+
+void QuartusServer::write_meta(const string& key, const Meta& meta) const {
+  stringstream ss;
+  ss << meta.compile_time << " " << meta.size << " " << meta.hits << " " << meta.last_used << endl;
+  write_file(cache_path_ + "/" + key + ".meta", ss.str());
+}
+
+void QuartusServer::write_file(const string& file, const string& contents) const {
+  // Write to a temporary and rename it into place so that readers never
+  // observe a partially written file.
+  stringstream ss;
+  ss << file << ".tmp" << getpid();
+  const auto tmp = ss.str();
+  ofstream ofs(tmp, ios::binary);
+  ofs.write(contents.c_str(), contents.length());
+  ofs.close();
+  rename(tmp.c_str(), file.c_str());
+}
+
 } // namespace cascade::avmm
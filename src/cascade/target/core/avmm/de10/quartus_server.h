@@ -31,7 +31,7 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_DE10_QUARTUS_SERVER_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_DE10_QUARTUS_SERVER_H
 
-#include <unordered_map>
+#include <ctime>
 #include <string>
 #include "common/thread.h"
 #include "common/thread_pool.h"
@@ -57,6 +57,10 @@ class QuartusServer : public Thread {
     ~QuartusServer() override = default;
 
     QuartusServer& set_cache_path(const std::string& path);
+    // Sets an upper bound on the total size of the bitstreams in the cache.
+    // Least recently used entries are evicted to stay under this bound. A
+    // value of 0 means unbounded.
+    QuartusServer& set_cache_size(size_t bytes);
     QuartusServer& set_quartus_path(const std::string& path);
     QuartusServer& set_quartus_tunnel_command(const std::string& tunnel_command);
     QuartusServer& set_port(uint32_t port);
@@ -66,15 +70,23 @@ class QuartusServer : public Thread {
   private:
     // Condiguration State:
     std::string cache_path_;
+    size_t cache_size_;
     std::string quartus_path_;
     std::string quartus_tunnel_command_;
     uint32_t port_;
 
     // Comoilation State:
     ThreadPool pool_;
-    std::unordered_map<std::string, std::string> cache_;
     bool busy_;
 
+    // Cache Entry Metadata:
+    struct Meta {
+      time_t compile_time;
+      size_t size;
+      size_t hits;
+      time_t last_used;
+    };
+
     // Thread Interface:
     void run_logic() override;
 
@@ -82,7 +94,26 @@ class QuartusServer : public Thread {
     void init_pool();
     void init_cache();
     void kill_all();
-    bool compile(const std::string& text);
+    // Compiles text, or finds it in the cache, and reads the resulting
+    // bitstream into rbf.
+    bool compile(const std::string& text, std::string* rbf);
+
+    // Cache Helpers:
+    //
+    // The cache is a directory of entries named by the digest of the text
+    // they were compiled from: the text itself (.v), a bitstream (.rbf), and
+    // metadata (.meta). Files are written to temporaries and renamed into
+    // place, and every other modification is made while holding an exclusive
+    // lock on the cache directory, so several servers may share one cache.
+    std::string digest(const std::string& text) const;
+    int lock_cache() const;
+    void unlock_cache(int fd) const;
+    bool cache_find(const std::string& key, const std::string& text, std::string* rbf) const;
+    void cache_insert(const std::string& key, const std::string& text, const std::string& rbf, time_t compile_time) const;
+    void cache_evict() const;
+    bool read_meta(const std::string& key, Meta* meta) const;
+    void write_meta(const std::string& key, const Meta& meta) const;
+    void write_file(const std::string& file, const std::string& contents) const;
 };
 
 } // namespace avmm
@@ -34,8 +34,17 @@
 #include <cstdlib>
 #include <dlfcn.h>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <type_traits>
+#include "common/indstream.h"
+#include "common/sha256.h"
 #include "common/system.h"
 #include "target/core/avmm/avmm_compiler.h"
 #include "target/core/avmm/verilator/verilator_logic.h"
@@ -52,7 +61,47 @@ class VerilatorCompiler : public AvmmCompiler<M,V,A,T> {
     // Avmm Compiler Interface:
     VerilatorLogic<V,A,T>* build(Interface* interface, ModuleDeclaration* md, size_t slot) override;
     bool compile(const std::string& text, std::mutex& lock) override;
+    bool compile_slots(const std::map<MId, std::string>& slots, std::mutex& lock) override;
     void stop_compile() override;
+    void speculate(const std::string& text, std::mutex& lock) override;
+    void speculate_slots(const std::map<MId, std::string>& slots, MId slot, std::mutex& lock) override;
+
+    // Make Helpers:
+    //
+    // Runs script (with args) in a fresh directory containing text, and
+    // harness if provided, and moves the result into the cache entry at dir.
+    // The lock is released while the script runs, and must be held when
+    // invoking stop_compile(). Returns true if dir holds a successful build of
+    // text afterwards.
+    bool make(const std::string& dir, const std::string& text, const std::string& artifact, const std::string& script, const std::string& args, const std::string& harness, std::mutex& lock);
+    // Returns the cache entry which holds verilated.o, building it first if
+    // necessary, or the empty string on failure.
+    std::string make_verilated(std::mutex& lock);
+    // Schedules an interrupt to swap in the shared object in dir.
+    void load(const std::string& dir);
+
+    // Cache Helpers:
+    //
+    // Returns the location of the cache entry for text.
+    std::string cache_path(const std::string& text);
+    // Returns true if the cache entry at dir was built from text and contains
+    // artifact.
+    bool cache_hit(const std::string& dir, const std::string& text, const std::string& artifact) const;
+
+    // Codegen Helpers:
+    //
+    // Returns the text of module M<slot> along with a wrapper S<slot> which
+    // can be verilated on its own.
+    std::string get_slot_text(MId slot, const std::string& text) const;
+    // Returns a harness which multiplexes requests between separately
+    // verilated slots, in place of the program_logic module.
+    std::string get_harness(const std::map<MId, std::string>& slots) const;
+
+    // Compilation Cache:
+    std::string toolchain_;
+
+    // Running Builds:
+    std::set<pid_t> builds_;
 
     // Verilator Control Thread:
     std::thread verilator_;
@@ -92,32 +141,143 @@ template <size_t M, size_t V, typename A, typename T>
 inline bool VerilatorCompiler<M,V,A,T>::compile(const std::string& text, std::mutex& lock) {
   stop_compile();
 
+  // Check the cache before doing any work. Entries are keyed on the text of
+  // the program as well as the toolchain which built them, and are only used
+  // if the text they were built from is an exact match.
+  const auto dir = cache_path(text);
+  if (!cache_hit(dir, text, "libverilator.so")) {
+    const auto script = std::is_same<T, uint32_t>::value ? "./build_verilator_32.sh" : "./build_verilator_64.sh";
+    if (!make(dir, text, "libverilator.so", script, "", "", lock)) {
+      return false;
+    }
+  }
+  load(dir);
+  return true;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool VerilatorCompiler<M,V,A,T>::compile_slots(const std::map<MId, std::string>& slots, std::mutex& lock) {
+  stop_compile();
+
+  // A linked program is interchangeable with one built from the equivalent
+  // program_logic text, so share cache entries with compile().
+  const auto text = AvmmCompiler<M,V,A,T>::get_text(slots);
+  const auto dir = cache_path(text);
+  if (!cache_hit(dir, text, "libverilator.so")) {
+    // Verilate and compile each slot on its own. Slots which haven't changed
+    // since the last time they were built are already in the cache, as is
+    // verilator's runtime library, which every program shares.
+    const auto vd = make_verilated(lock);
+    if (vd.empty()) {
+      return false;
+    }
+    std::stringstream ss;
+    ss << vd << " ";
+    for (const auto& s : slots) {
+      const auto st = get_slot_text(s.first, s.second);
+      const auto sd = cache_path(st);
+      const auto artifact = "VS" + std::to_string(s.first) + "__ALL.a";
+      if (!cache_hit(sd, st, artifact) && !make(sd, st, artifact, "./build_verilator_slot.sh", std::to_string(s.first), "", lock)) {
+        return false;
+      }
+      ss << sd << " ";
+    }
+    // Link the slots together. This is the only work that has to be redone
+    // for slots which haven't changed.
+    if (!make(dir, text, "libverilator.so", "./link_verilator.sh", ss.str(), get_harness(slots), lock)) {
+      return false;
+    }
+  }
+  load(dir);
+  return true;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void VerilatorCompiler<M,V,A,T>::speculate(const std::string& text, std::mutex& lock) {
+  // Build text into the cache, but don't load it.
+  const auto dir = cache_path(text);
+  if (!cache_hit(dir, text, "libverilator.so")) {
+    const auto script = std::is_same<T, uint32_t>::value ? "./build_verilator_32.sh" : "./build_verilator_64.sh";
+    make(dir, text, "libverilator.so", script, "", "", lock);
+  }
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void VerilatorCompiler<M,V,A,T>::speculate_slots(const std::map<MId, std::string>& slots, MId slot, std::mutex& lock) {
+  // Linking is cheap, and depends on the contents of the other slots, which
+  // may well have changed by the time we need it. Only build the new slot.
+  const auto itr = slots.find(slot);
+  assert(itr != slots.end());
+  const auto st = get_slot_text(slot, itr->second);
+  const auto sd = cache_path(st);
+  const auto artifact = "VS" + std::to_string(slot) + "__ALL.a";
+  if (!cache_hit(sd, st, artifact) && !make_verilated(lock).empty()) {
+    make(sd, st, artifact, "./build_verilator_slot.sh", std::to_string(slot), "", lock);
+  }
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool VerilatorCompiler<M,V,A,T>::make(const std::string& dir, const std::string& text, const std::string& artifact, const std::string& script, const std::string& args, const std::string& harness, std::mutex& lock) {
   System::execute("mkdir -p /tmp/verilator/");
   char path[] = "/tmp/verilator/program_logic_XXXXXX.v";
   const auto fd = mkstemps(path, 2);
-  const auto dir = std::string(path).substr(0,35);
+  const auto tmp = std::string(path).substr(0,35);
   close(fd);
 
-  System::execute("mkdir -p " + dir);
+  System::execute("mkdir -p " + tmp);
   std::ofstream ofs(path);
   ofs << text << std::endl;
   ofs.close();
+  if (!harness.empty()) {
+    std::ofstream ofs2(tmp + "/harness.cpp");
+    ofs2 << harness << std::endl;
+  }
 
-  pid_t pid = 0;
-  if constexpr (std::is_same<T, uint32_t>::value) {
-    pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_32.sh " + dir + " " + System::cxx_compiler(), false);
-  } else if constexpr (std::is_same<T, uint64_t>::value) {
-    pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && ./build_verilator_64.sh " + dir + " " + System::cxx_compiler(), false);
-  } 
-
+  const auto pid = System::no_block_begin_execute("cd " + System::src_root() + "/share/cascade/verilator/ && " + script + " " + tmp + " " + System::cxx_compiler() + " " + args, false);
+  builds_.insert(pid);
   lock.unlock();
   const auto res = System::no_block_wait_finish(pid);
   lock.lock();
+  builds_.erase(pid);
 
   if (res != 0) {
     return false;
   }
-    
+
+  // Move the result into the cache. If another instance of cascade beat us
+  // to it, theirs is just as good as ours. But if the entry that's there is
+  // stale or incomplete, say because a build was killed while it was being
+  // moved into place, move it out of the way (atomically, in case someone
+  // else is doing the same thing) and try again.
+  System::execute("mv " + std::string(path) + " " + tmp + "/program_logic.v");
+  System::execute("mkdir -p " + dir.substr(0, dir.find_last_of('/')));
+  for (auto i = 0; i < 2; ++i) {
+    if (System::execute("mv -T " + tmp + " " + dir + " 2>/dev/null") == 0) {
+      break;
+    }
+    if (cache_hit(dir, text, artifact)) {
+      break;
+    }
+    System::execute("mv -T " + dir + " " + tmp + ".stale 2>/dev/null; rm -rf " + tmp + ".stale");
+  }
+  System::execute("rm -rf " + tmp);
+  return cache_hit(dir, text, artifact);
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string VerilatorCompiler<M,V,A,T>::make_verilated(std::mutex& lock) {
+  // The library only depends on the toolchain, so its cache entry is keyed on
+  // a placeholder rather than the text of a program.
+  const std::string text = "// verilated.o";
+  const auto dir = cache_path(text);
+  if (!cache_hit(dir, text, "verilated.o") && !make(dir, text, "verilated.o", "./build_verilated.sh", "", "", lock)) {
+    return "";
+  }
+  return dir;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void VerilatorCompiler<M,V,A,T>::load(const std::string& dir) {
   AvmmCompiler<M,V,A,T>::get_compiler()->schedule_state_safe_interrupt([this, dir]{
     if (handle_ != nullptr) {
       stop_();
@@ -137,17 +297,271 @@ inline bool VerilatorCompiler<M,V,A,T>::compile(const std::string& text, std::mu
     auto start = (void (*)()) dlsym(handle_, "verilator_start");
     verilator_ = std::thread(start);
   });
-
-  return true;
 }
 
 template <size_t M, size_t V, typename A, typename T>
 inline void VerilatorCompiler<M,V,A,T>::stop_compile() {
-  if constexpr (std::is_same<T, uint32_t>::value) {
-    System::execute(R"(pkill -9 -P `ps -ax | grep build_verilator_32.sh | awk '{print $1}' | head -n1`)");
-  } else if constexpr (std::is_same<T, uint64_t>::value) {
-    System::execute(R"(pkill -9 -P `ps -ax | grep build_verilator_64.sh | awk '{print $1}' | head -n1`)");
-  } 
+  // More than one build may be running at once (say, a speculative one and a
+  // real one), and each spawns processes of its own. Kill all of them, but
+  // leave alone any builds which belong to other instances of cascade.
+  for (auto pid : builds_) {
+    System::kill_tree(pid);
+  }
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string VerilatorCompiler<M,V,A,T>::cache_path(const std::string& text) {
+  // Fingerprint the toolchain the first time we need it. Anything which could
+  // change the contents of the shared object goes into the key.
+  const auto width = std::is_same<T, uint32_t>::value ? "32" : "64";
+  if (toolchain_.empty()) {
+    System::capture("(verilator --version; " + System::cxx_compiler() + " --version; cd " + System::src_root() + "/share/cascade/verilator/ && cat build_verilator_" + width + ".sh harness_" + width + ".cpp build_verilated.sh build_verilator_slot.sh link_verilator.sh) 2>&1", &toolchain_);
+  }
+  // Entries outlive this process, so key them on a digest which doesn't
+  // depend on how cascade was built.
+  return std::string("/tmp/verilator/cache") + width + "/" + Sha256().update(toolchain_).update(text).hexdigest();
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline bool VerilatorCompiler<M,V,A,T>::cache_hit(const std::string& dir, const std::string& text, const std::string& artifact) const {
+  std::ifstream so(dir + "/" + artifact);
+  if (!so.is_open()) {
+    return false;
+  }
+  std::ifstream ifs(dir + "/program_logic.v");
+  const std::string cached((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  return cached == (text + "\n");
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string VerilatorCompiler<M,V,A,T>::get_slot_text(MId slot, const std::string& text) const {
+  std::stringstream ss;
+  indstream os(ss);
+
+  os << text << std::endl;
+  os << std::endl;
+
+  // Verilator mangles port names which contain double underscores, so wrap
+  // M<slot> in a module whose ports the harness can refer to directly. This
+  // mirrors the way program_logic instantiates M<slot>.
+  os << "module S" << slot << "(" << std::endl;
+  os.tab();
+  os << "input wire clk," << std::endl;
+  os << "input wire s0_read," << std::endl;
+  os << "input wire s0_write," << std::endl;
+  os << "input wire[" << (V-1) << ":0] s0_vid," << std::endl;
+  os << "input wire[" << (std::numeric_limits<T>::digits-1) << ":0] s0_writedata," << std::endl;
+  os << "output wire[" << (std::numeric_limits<T>::digits-1) << ":0] s0_readdata," << std::endl;
+  os << "output wire s0_waitrequest" << std::endl;
+  os.untab();
+  os << ");" << std::endl;
+  os.tab();
+  os << "M" << slot << " m" << slot << "(" << std::endl;
+  os.tab();
+  os << ".__clk(clk)," << std::endl;
+  os << ".__read(s0_write)," << std::endl;
+  os << ".__write(s0_read)," << std::endl;
+  os << ".__vid(s0_vid)," << std::endl;
+  os << ".__in(s0_writedata)," << std::endl;
+  os << ".__out(s0_readdata)," << std::endl;
+  os << ".__wait(s0_waitrequest)" << std::endl;
+  os.untab();
+  os << ");" << std::endl;
+  os.untab();
+  os << "endmodule";
+
+  return ss.str();
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline std::string VerilatorCompiler<M,V,A,T>::get_harness(const std::map<MId, std::string>& slots) const {
+  const auto a = std::is_same<A, uint16_t>::value ? "uint16_t" : "uint32_t";
+  const auto t = std::is_same<T, uint32_t>::value ? "uint32_t" : "uint64_t";
+
+  std::stringstream ss;
+  indstream os(ss);
+
+  // This is the harness in share/cascade/verilator, with the program_logic
+  // module replaced by the address decoding and output demuxing logic which
+  // it would have contained.
+  os << "#include \"verilated.h\"" << std::endl;
+  for (const auto& s : slots) {
+    os << "#include \"VS" << s.first << ".h\"" << std::endl;
+  }
+  os << std::endl;
+  os << "using namespace std;" << std::endl;
+  os << std::endl;
+  os << "namespace {" << std::endl;
+  os << std::endl;
+  os << "enum Request {" << std::endl;
+  os.tab();
+  os << "READY = 0," << std::endl;
+  os << "READ," << std::endl;
+  os << "WRITE," << std::endl;
+  os << "WAIT," << std::endl;
+  os << "DONE_1," << std::endl;
+  os << "DONE_2" << std::endl;
+  os.untab();
+  os << "};" << std::endl;
+  os << std::endl;
+  for (const auto& s : slots) {
+    os << "VS" << s.first << "* m" << s.first << "_;" << std::endl;
+  }
+  os << "bool running_;" << std::endl;
+  os << "Request req_;" << std::endl;
+  os << a << " addr_;" << std::endl;
+  os << t << " val_;" << std::endl;
+  os << std::endl;
+  os << "bool clk_;" << std::endl;
+  os << a << " s0_address_;" << std::endl;
+  os << "bool s0_read_;" << std::endl;
+  os << "bool s0_write_;" << std::endl;
+  os << t << " s0_writedata_;" << std::endl;
+  os << std::endl;
+
+  os << "unsigned mid() {" << std::endl;
+  os.tab();
+  os << "return (s0_address_ >> " << V << ") & " << ((1u << M) - 1) << ";" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "void eval() {" << std::endl;
+  os.tab();
+  os << "const auto vid = s0_address_ & " << ((1u << V) - 1) << ";" << std::endl;
+  for (const auto& s : slots) {
+    os << "m" << s.first << "_->clk = clk_;" << std::endl;
+    os << "m" << s.first << "_->s0_read = (mid() == " << s.first << ") & s0_read_;" << std::endl;
+    os << "m" << s.first << "_->s0_write = (mid() == " << s.first << ") & s0_write_;" << std::endl;
+    os << "m" << s.first << "_->s0_vid = vid;" << std::endl;
+    os << "m" << s.first << "_->s0_writedata = s0_writedata_;" << std::endl;
+    os << "m" << s.first << "_->eval();" << std::endl;
+  }
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "bool s0_waitrequest() {" << std::endl;
+  os.tab();
+  os << "if (!s0_read_ && !s0_write_) {" << std::endl;
+  os.tab();
+  os << "return true;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << "switch (mid()) {" << std::endl;
+  os.tab();
+  for (const auto& s : slots) {
+    os << "case " << s.first << ": return m" << s.first << "_->s0_waitrequest;" << std::endl;
+  }
+  os << "default: return false;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << t << " s0_readdata() {" << std::endl;
+  os.tab();
+  os << "switch (mid()) {" << std::endl;
+  os.tab();
+  for (const auto& s : slots) {
+    os << "case " << s.first << ": return m" << s.first << "_->s0_readdata;" << std::endl;
+  }
+  os << "default: return 0;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+  os << "} // namespace" << std::endl;
+  os << std::endl;
+
+  os << "extern \"C\" void verilator_init() {" << std::endl;
+  os.tab();
+  for (const auto& s : slots) {
+    os << "m" << s.first << "_ = new VS" << s.first << "();" << std::endl;
+  }
+  os << "clk_ = false;" << std::endl;
+  os << "s0_address_ = 0;" << std::endl;
+  os << "s0_read_ = false;" << std::endl;
+  os << "s0_write_ = false;" << std::endl;
+  os << "s0_writedata_ = 0;" << std::endl;
+  os << "req_ = READY;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "extern \"C\" void verilator_start() {" << std::endl;
+  os.tab();
+  os << "for (running_ = true; running_; ) {" << std::endl;
+  os.tab();
+  os << "switch (req_) {" << std::endl;
+  os.tab();
+  os << "case READY:" << std::endl;
+  os << "  break;" << std::endl;
+  os << "case READ:" << std::endl;
+  os << "  s0_address_ = addr_;" << std::endl;
+  os << "  s0_read_ = true;" << std::endl;
+  os << "  req_ = WAIT;" << std::endl;
+  os << "  break;" << std::endl;
+  os << "case WRITE:" << std::endl;
+  os << "  s0_address_ = addr_;" << std::endl;
+  os << "  s0_writedata_ = val_;" << std::endl;
+  os << "  s0_write_ = true;" << std::endl;
+  os << "  req_ = WAIT;" << std::endl;
+  os << "  break;" << std::endl;
+  os << "case WAIT:" << std::endl;
+  os << "  if (!s0_waitrequest()) {" << std::endl;
+  os << "    s0_read_ = false;" << std::endl;
+  os << "    s0_write_ = false;" << std::endl;
+  os << "    req_ = DONE_1;" << std::endl;
+  os << "  }" << std::endl;
+  os << "  break;" << std::endl;
+  os << "case DONE_1:" << std::endl;
+  os << "  req_ = DONE_2;" << std::endl;
+  os << "  break;" << std::endl;
+  os << "case DONE_2:" << std::endl;
+  os << "  req_ = READY;" << std::endl;
+  os << "  break;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << "eval();" << std::endl;
+  os << "clk_ = !clk_;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  for (const auto& s : slots) {
+    os << "m" << s.first << "_->final();" << std::endl;
+    os << "delete m" << s.first << "_;" << std::endl;
+  }
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "extern \"C\" void verilator_stop() {" << std::endl;
+  os.tab();
+  os << "running_ = false;" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "extern \"C\" void verilator_write(" << a << " addr, " << t << " val) {" << std::endl;
+  os.tab();
+  os << "addr_ = addr;" << std::endl;
+  os << "val_ = val;" << std::endl;
+  os << "for (req_ = WRITE; req_ != READY;);" << std::endl;
+  os.untab();
+  os << "}" << std::endl;
+  os << std::endl;
+
+  os << "extern \"C\" " << t << " verilator_read(" << a << " addr) {" << std::endl;
+  os.tab();
+  os << "addr_ = addr;" << std::endl;
+  os << "for (req_ = READ; req_ != READY;);" << std::endl;
+  os << "return s0_readdata();" << std::endl;
+  os.untab();
+  os << "}";
+
+  return ss.str();
 }
 
 } // namespace cascade::avmm
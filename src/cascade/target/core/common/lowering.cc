@@ -0,0 +1,264 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/common/lowering.h"
+
+#include <algorithm>
+#include <cassert>
+#include "verilog/analyze/read_set.h"
+#include "verilog/analyze/resolve.h"
+
+using namespace std;
+
+namespace cascade {
+
+const string& Lowering::get_error() const {
+  return error_;
+}
+
+Lowering::Lowering(const string& backend, Evaluate* eval) : Visitor() {
+  eval_ = eval;
+  backend_ = backend;
+}
+
+bool Lowering::index(const ModuleDeclaration* md, bool allow_initial) {
+  for (auto i = md->begin_items(), ie = md->end_items(); (i != ie) && error_.empty(); ++i) {
+    const auto* mi = *i;
+    if (mi->is(Node::Tag::port_declaration) || mi->is_subclass_of(Node::Tag::declaration)) {
+      const auto* id = mi->is(Node::Tag::port_declaration) ?
+        static_cast<const PortDeclaration*>(mi)->get_decl()->get_id() :
+        static_cast<const Declaration*>(mi)->get_id();
+      var_index_.insert(make_pair(id, var_ids_.size()));
+      var_ids_.push_back(id);
+    } else if (mi->is(Node::Tag::continuous_assign)) {
+      proc_index_.insert(make_pair(mi, procs_.size()));
+      procs_.push_back(mi);
+    } else if (mi->is(Node::Tag::initial_construct) && allow_initial) {
+      const auto* stmt = static_cast<const InitialConstruct*>(mi)->get_stmt();
+      initial_.push_back(procs_.size());
+      proc_index_.insert(make_pair(stmt, procs_.size()));
+      procs_.push_back(stmt);
+    } else if (mi->is(Node::Tag::initial_construct)) {
+      fail("initial constructs");
+    } else if (mi->is(Node::Tag::always_construct)) {
+      const auto* ac = static_cast<const AlwaysConstruct*>(mi);
+      if (!ac->get_stmt()->is(Node::Tag::timing_control_statement)) {
+        fail("always constructs without a timing control");
+        break;
+      }
+      const auto* tcs = static_cast<const TimingControlStatement*>(ac->get_stmt());
+      if (!tcs->get_ctrl()->is(Node::Tag::event_control)) {
+        fail("always constructs guarded by delay controls");
+        break;
+      }
+      const auto* ec = static_cast<const EventControl*>(tcs->get_ctrl());
+      for (auto j = ec->begin_events(), je = ec->end_events(); j != je; ++j) {
+        if (!(*j)->get_expr()->is(Node::Tag::identifier)) {
+          fail("events guarded by complex expressions");
+          break;
+        }
+        proc_index_.insert(make_pair(*j, procs_.size()));
+        procs_.push_back(*j);
+      }
+      proc_index_.insert(make_pair(tcs->get_stmt(), procs_.size()));
+      procs_.push_back(tcs->get_stmt());
+    } else if (allow_initial) {
+      fail("module items other than declarations, continuous assigns, and initial or always constructs");
+    } else {
+      fail("module items other than declarations, continuous assigns, and always constructs");
+    }
+  }
+  if (!error_.empty()) {
+    return false;
+  }
+
+  // Compute sensitivity lists. These mirror the monitors that SwLogic attaches
+  // to variables and $feof() expressions.
+  monitors_.resize(var_ids_.size());
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    const auto* n = procs_[p];
+    if (n->is(Node::Tag::continuous_assign)) {
+      for (auto* e : ReadSet(static_cast<const ContinuousAssign*>(n)->get_rhs())) {
+        if (e->is(Node::Tag::identifier)) {
+          add_monitor(static_cast<const Identifier*>(e), p);
+        } else if (e->is(Node::Tag::feof_expression)) {
+          const auto* fe = static_cast<const FeofExpression*>(e);
+          auto itr = find_if(eofs_.begin(), eofs_.end(), [fe](const auto& ef) {return ef.first == fe;});
+          if (itr == eofs_.end()) {
+            eofs_.push_back(make_pair(fe, vector<size_t>()));
+            itr = eofs_.end()-1;
+          }
+          itr->second.push_back(p);
+        } 
+      }
+    } else if (n->is(Node::Tag::event)) {
+      add_monitor(static_cast<const Identifier*>(static_cast<const Event*>(n)->get_expr()), p);
+    }
+  }
+  return error_.empty();
+}
+
+size_t Lowering::find_var(const Identifier* id) {
+  const auto* r = Resolve().get_resolution(id);
+  const auto itr = (r == nullptr) ? var_index_.end() : var_index_.find(r);
+  if (itr == var_index_.end()) {
+    fail("references to variables which are not declared locally");
+    return var_ids_.size();
+  }
+  return itr->second;
+}
+
+size_t Lowering::get_guarded(const Event* e) {
+  assert(e->get_parent()->get_parent()->is(Node::Tag::timing_control_statement));
+  const auto* tcs = static_cast<const TimingControlStatement*>(e->get_parent()->get_parent());
+  const auto itr = proc_index_.find(tcs->get_stmt());
+  assert(itr != proc_index_.end());
+  return itr->second;
+}
+
+bool Lowering::get_subscript(const Identifier* r, const Identifier* i, Subscript* s) {
+  s->terms.clear();
+  s->range = nullptr;
+
+  // Nothing to do if this is a scalar variable
+  if (r->empty_dim()) {
+    s->range = i->empty_dim() ? nullptr : i->front_dim();
+    return true;
+  }
+
+  // Otherwise, walk along subscripts. The multipliers for each dimension are
+  // known at compile time.
+  auto iitr = i->begin_dim();
+  auto mul = eval_->get_array_value(r).size();
+  for (auto ritr = r->begin_dim(), re = r->end_dim(); ritr != re; ++iitr, ++ritr) {
+    if ((iitr == i->end_dim()) || (*iitr)->is(Node::Tag::range_expression)) {
+      fail("array slicing");
+      return false;
+    }
+    const auto rval = eval_->get_range(*ritr);
+    mul /= ((rval.first-rval.second)+1);
+    s->terms.push_back(make_pair(mul, *iitr));
+  }
+  s->range = (iitr == i->end_dim()) ? nullptr : *iitr;
+  return true;
+}
+
+void Lowering::fail(const string& reason) {
+  if (error_.empty()) {
+    error_ = backend_ + " does not currently support " + reason + "!";
+  }
+}
+
+void Lowering::visit(const RangeExpression* re) {
+  // Ranges are handled by subscripts. They should never be evaluated as values.
+  (void) re;
+  fail("range expressions outside of subscripts");
+}
+
+void Lowering::visit(const ForStatement* fs) {
+  (void) fs;
+  fail("for loops");
+}
+
+void Lowering::visit(const RepeatStatement* rs) {
+  (void) rs;
+  fail("repeat loops");
+}
+
+void Lowering::visit(const ParBlock* pb) {
+  (void) pb;
+  fail("fork/join blocks");
+}
+
+void Lowering::visit(const SeqBlock* sb) {
+  if (!sb->empty_decls()) {
+    return fail("declarations inside of begin/end blocks");
+  }
+  sb->accept_stmts(this);
+}
+
+void Lowering::visit(const TimingControlStatement* tcs) {
+  (void) tcs;
+  fail("nested timing control statements");
+}
+
+void Lowering::visit(const DebugStatement* ds) {
+  task(ds);
+}
+
+void Lowering::visit(const FflushStatement* fs) {
+  task(fs);
+}
+
+void Lowering::visit(const FinishStatement* fs) {
+  task(fs);
+}
+
+void Lowering::visit(const FseekStatement* fs) {
+  task(fs);
+}
+
+void Lowering::visit(const GetStatement* gs) {
+  task(gs);
+}
+
+void Lowering::visit(const PutStatement* ps) {
+  task(ps);
+}
+
+void Lowering::visit(const RestartStatement* rs) {
+  task(rs);
+}
+
+void Lowering::visit(const RetargetStatement* rs) {
+  task(rs);
+}
+
+void Lowering::visit(const SaveStatement* ss) {
+  task(ss);
+}
+
+void Lowering::visit(const WhileStatement* ws) {
+  (void) ws;
+  fail("while loops");
+}
+
+void Lowering::add_monitor(const Identifier* id, size_t proc) {
+  const auto var = find_var(id);
+  if (var == var_ids_.size()) {
+    return;
+  }
+  auto& ms = monitors_[var];
+  if (find(ms.begin(), ms.end(), proc) == ms.end()) {
+    ms.push_back(proc);
+  }
+}
+
+} // namespace cascade
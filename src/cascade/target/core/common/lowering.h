@@ -0,0 +1,136 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_COMMON_LOWERING_H
+#define CASCADE_SRC_TARGET_CORE_COMMON_LOWERING_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade {
+
+// This class implements the front end which is shared by the backends that
+// lower the ir form of a module (the output of Module::transform_ir_source())
+// to straight-line code. It has two subclasses: Bytecode, which SwCompiler
+// uses by way of SwLogic::compile_bytecode() when bytecode is enabled, and
+// Codegen, which NativeCompiler uses by way of NativeLogic. It indexes the
+// variables and processes in a module, computes the sensitivity lists that
+// SwLogic would attach to them, resolves the subscripts of variable
+// references, and rejects the constructs which these backends don't support.
+// Subclasses supply the code for everything else.
+
+class Lowering : public Visitor {
+  public:
+    ~Lowering() override = default;
+
+    // Returns a description of the first unsupported construct encountered
+    // by a subclass, or the empty string if there wasn't one.
+    const std::string& get_error() const;
+
+  protected:
+    // A reference to a variable resolves to the sum of a sequence of runtime
+    // subscripts, each scaled by a multiplier which is known at compile time,
+    // and an optional bit range. A null range denotes a full word access.
+    struct Subscript {
+      std::vector<std::pair<size_t, const Expression*>> terms;
+      const Expression* range;
+    };
+
+    // Constructors:
+    Lowering(const std::string& backend, Evaluate* eval);
+
+    // Analysis State:
+    Evaluate* eval_;
+    std::string error_;
+
+    // Variable Index:
+    std::vector<const Identifier*> var_ids_;
+    std::unordered_map<const Identifier*, size_t> var_index_;
+    std::vector<std::vector<size_t>> monitors_;
+    std::vector<std::pair<const FeofExpression*, std::vector<size_t>>> eofs_;
+
+    // Process Index:
+    std::vector<const Node*> procs_;
+    std::unordered_map<const Node*, size_t> proc_index_;
+    std::vector<size_t> initial_;
+    std::vector<const SystemTaskEnableStatement*> tasks_;
+
+    // Indexes the declarations and processes in md and computes sensitivity
+    // lists. Processes are continuous assigns, the events which guard always
+    // blocks, the bodies of those blocks, and if allow_initial is true, the
+    // bodies of initial constructs. Returns false on failure.
+    bool index(const ModuleDeclaration* md, bool allow_initial);
+    // Returns the index of the variable that id resolves to, or var_ids_.size()
+    // if it isn't declared in this module.
+    size_t find_var(const Identifier* id);
+    // Returns the index of the process guarded by an event.
+    size_t get_guarded(const Event* e);
+    // Resolves the subscripts of i, a reference to r. Returns false if i
+    // requires a feature that isn't supported.
+    bool get_subscript(const Identifier* r, const Identifier* i, Subscript* s);
+    // Records an error. Only the first error is retained.
+    void fail(const std::string& reason);
+
+    // Lowers a system task. Implementations are responsible for appending s
+    // to tasks_.
+    virtual void task(const SystemTaskEnableStatement* s) = 0;
+
+    // Visitor Interface:
+    void visit(const RangeExpression* re) override;
+    void visit(const ForStatement* fs) override;
+    void visit(const RepeatStatement* rs) override;
+    void visit(const ParBlock* pb) override;
+    void visit(const SeqBlock* sb) override;
+    void visit(const TimingControlStatement* tcs) override;
+    void visit(const DebugStatement* ds) override;
+    void visit(const FflushStatement* fs) override;
+    void visit(const FinishStatement* fs) override;
+    void visit(const FseekStatement* fs) override;
+    void visit(const GetStatement* gs) override;
+    void visit(const PutStatement* ps) override;
+    void visit(const RestartStatement* rs) override;
+    void visit(const RetargetStatement* rs) override;
+    void visit(const SaveStatement* ss) override;
+    void visit(const WhileStatement* ws) override;
+
+  private:
+    std::string backend_;
+
+    void add_monitor(const Identifier* id, size_t proc);
+};
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,739 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/codegen.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include "common/indstream.h"
+#include "verilog/analyze/resolve.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+Codegen::Codegen() : Lowering("Native backend", &analysis_) {
+  os_ = nullptr;
+  next_name_ = 0;
+}
+
+bool Codegen::run(const ModuleDeclaration* md) {
+  // Index variables and processes. Initial constructs are removed from
+  // everything but pass 1 compilations, which always target software.
+  if (!index(md, false)) {
+    return false;
+  }
+
+  // Generate process bodies. This also populates the set of temporaries and
+  // constants that those bodies refer to.
+  stringstream procs;
+  indstream os(procs);
+  os_ = &os;
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    emit_proc(p);
+  }
+  os_ = nullptr;
+  if (!error_.empty()) {
+    return false;
+  }
+
+  // Initialize variables
+  for (size_t v = 0, ve = var_ids_.size(); v < ve; ++v) {
+    const auto& val = eval_->get_array_value(var_ids_[v]);
+    const auto uniform = all_of(val.begin(), val.end(), [&val](const Bits& b) {return b.eq(val[0]);});
+    if (val.size() == 1) {
+      const auto c = constant(val[0]);
+      init_ << "  " << var_name(v) << "[0] = " << c << ";" << endl;
+    } else if (uniform) {
+      const auto c = constant(val[0]);
+      init_ << "  for (auto& v : " << var_name(v) << ") {" << endl;
+      init_ << "    v = " << c << ";" << endl;
+      init_ << "  }" << endl;
+    } else {
+      for (size_t i = 0, ie = val.size(); i < ie; ++i) {
+        const auto c = constant(val[i]);
+        init_ << "  " << var_name(v) << "[" << i << "] = " << c << ";" << endl;
+      }
+    }
+  }
+
+  // Stitch everything together
+  stringstream ss;
+  ss << "#include \"target/core/native/native_module.h\"" << endl;
+  ss << endl;
+  ss << "using namespace cascade;" << endl;
+  ss << "using namespace cascade::native;" << endl;
+  ss << endl;
+  ss << "namespace {" << endl;
+  ss << endl;
+  ss << "class Program : public NativeBase {" << endl;
+  ss << "  public:" << endl;
+  ss << "    explicit Program(NativeHost* host);" << endl;
+  ss << "    ~Program() override = default;" << endl;
+  ss << endl;
+  ss << "    Bits* get_var(size_t var) override;" << endl;
+  ss << "    size_t get_arity(size_t var) const override;" << endl;
+  ss << "    void notify(size_t var) override;" << endl;
+  ss << "    void notify_eofs() override;" << endl;
+  ss << endl;
+  ss << "  private:" << endl;
+  for (size_t v = 0, ve = var_ids_.size(); v < ve; ++v) {
+    ss << "    Bits " << var_name(v) << "[" << eval_->get_array_value(var_ids_[v]).size() << "];" << endl;
+  }
+  ss << members_.str();
+  ss << endl;
+  ss << "    void run(size_t proc) override;" << endl;
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    ss << "    void p" << p << "();" << endl;
+  }
+  ss << "};" << endl;
+  ss << endl;
+
+  ss << "Program::Program(NativeHost* host) : NativeBase(host, " << procs_.size() << ") {" << endl;
+  ss << init_.str();
+  ss << "  silent_ = true;" << endl;
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    if (procs_[p]->is(Node::Tag::continuous_assign)) {
+      ss << "  p" << p << "();" << endl;
+    }
+  }
+  ss << "  silent_ = false;" << endl;
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << "Bits* Program::get_var(size_t var) {" << endl;
+  ss << "  switch (var) {" << endl;
+  for (size_t v = 0, ve = var_ids_.size(); v < ve; ++v) {
+    ss << "    case " << v << ": return " << var_name(v) << ";" << endl;
+  }
+  ss << "    default: return nullptr;" << endl;
+  ss << "  }" << endl;
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << "size_t Program::get_arity(size_t var) const {" << endl;
+  ss << "  switch (var) {" << endl;
+  for (size_t v = 0, ve = var_ids_.size(); v < ve; ++v) {
+    ss << "    case " << v << ": return " << eval_->get_array_value(var_ids_[v]).size() << ";" << endl;
+  }
+  ss << "    default: return 0;" << endl;
+  ss << "  }" << endl;
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << "void Program::notify(size_t var) {" << endl;
+  ss << "  switch (var) {" << endl;
+  for (size_t v = 0, ve = var_ids_.size(); v < ve; ++v) {
+    if (monitors_[v].empty()) {
+      continue;
+    }
+    ss << "    case " << v << ":" << endl;
+    for (auto p : monitors_[v]) {
+      ss << "      schedule(" << p << ");" << endl;
+    }
+    ss << "      break;" << endl;
+  }
+  ss << "    default:" << endl;
+  ss << "      break;" << endl;
+  ss << "  }" << endl;
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << "void Program::notify_eofs() {" << endl;
+  for (const auto& ef : eofs_) {
+    for (auto p : ef.second) {
+      ss << "  schedule(" << p << ");" << endl;
+    }
+  }
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << "void Program::run(size_t proc) {" << endl;
+  ss << "  switch (proc) {" << endl;
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    ss << "    case " << p << ": return p" << p << "();" << endl;
+  }
+  ss << "    default: return;" << endl;
+  ss << "  }" << endl;
+  ss << "}" << endl;
+  ss << endl;
+
+  ss << procs.str();
+  ss << "} // namespace" << endl;
+  ss << endl;
+  ss << "extern \"C\" NativeModule* native_create(NativeHost* host) {" << endl;
+  ss << "  return new Program(host);" << endl;
+  ss << "}" << endl;
+
+  text_ = ss.str();
+  return true;
+}
+
+const string& Codegen::get_text() const {
+  return text_;
+}
+
+size_t Codegen::get_var(const Identifier* id) const {
+  const auto* r = Resolve().get_resolution(id);
+  assert(r != nullptr);
+  const auto itr = var_index_.find(r);
+  assert(itr != var_index_.end());
+  return itr->second;
+}
+
+const vector<const SystemTaskEnableStatement*>& Codegen::get_tasks() const {
+  return tasks_;
+}
+
+string Codegen::fresh(const string& prefix) {
+  stringstream ss;
+  ss << prefix << next_name_++;
+  return ss.str();
+}
+
+string Codegen::var_name(size_t var) const {
+  stringstream ss;
+  ss << "v" << var << "_";
+  return ss.str();
+}
+
+string Codegen::temp(const Expression* e) {
+  const auto res = fresh("t") + "_";
+  members_ << "    Bits " << res << ";" << endl;
+  init_ << "  " << res << " = make_bits(" << eval_->get_width(e) << ", " << type_name(eval_->get_type(e)) << ");" << endl;
+  return res;
+}
+
+string Codegen::constant(const Bits& b) {
+  stringstream bytes;
+  const auto n = b.serialize(bytes);
+
+  const auto res = fresh("c") + "_";
+  members_ << "    Bits " << res << ";" << endl;
+  init_ << "  " << res << " = make_bits(\"" << hex << setfill('0');
+  for (auto c : bytes.str()) {
+    init_ << "\\x" << setw(2) << static_cast<uint32_t>(static_cast<uint8_t>(c));
+  }
+  init_ << "\", " << dec << n << ");" << endl;
+  return res;
+}
+
+string Codegen::type_name(Bits::Type t) const {
+  switch (t) {
+    case Bits::Type::SIGNED:
+      return "Bits::Type::SIGNED";
+    case Bits::Type::REAL:
+      return "Bits::Type::REAL";
+    default:
+      return "Bits::Type::UNSIGNED";
+  }
+}
+
+string Codegen::expr(const Expression* e) {
+  res_ = "";
+  e->accept(this);
+  return res_;
+}
+
+string Codegen::uint_expr(const Expression* e) {
+  // Numbers can be folded into the generated code
+  if (e->is(Node::Tag::number)) {
+    stringstream ss;
+    ss << eval_->get_value(e).to_uint() << "u";
+    return ss.str();
+  }
+  return expr(e) + ".to_uint()";
+}
+
+pair<string, string> Codegen::range(const Expression* e) {
+  if (!e->is(Node::Tag::range_expression)) {
+    const auto val = uint_expr(e);
+    const auto idx = fresh("x");
+    *os_ << "const size_t " << idx << " = " << val << ";" << endl;
+    return make_pair(idx, idx);
+  }
+
+  const auto* re = static_cast<const RangeExpression*>(e);
+  const auto uval = uint_expr(re->get_upper());
+  const auto upper = fresh("x");
+  *os_ << "const size_t " << upper << " = " << uval << ";" << endl;
+  const auto lval = uint_expr(re->get_lower());
+  const auto lower = fresh("x");
+  *os_ << "const size_t " << lower << " = " << lval << ";" << endl;
+
+  switch (re->get_type()) {
+    case RangeExpression::Type::PLUS:
+      return make_pair("(" + upper + "+" + lower + "-1)", upper);
+    case RangeExpression::Type::MINUS:
+      return make_pair(upper, "(" + upper + "-" + lower + "+1)");
+    default:
+      return make_pair(upper, lower);
+  }
+}
+
+tuple<string, string, string> Codegen::deref(const Identifier* r, const Identifier* i) {
+  Subscript sub;
+  if (!get_subscript(r, i, &sub)) {
+    return make_tuple("0", "-1", "-1");
+  }
+
+  // Scalar variables are always stored at index zero. Everything else is the
+  // sum of the subscripts, scaled by their compile time multipliers.
+  auto name = string("0");
+  if (!sub.terms.empty()) {
+    stringstream idx;
+    idx << "0";
+    for (const auto& t : sub.terms) {
+      idx << " + " << t.first << "*" << uint_expr(t.second);
+    }
+    name = fresh("i");
+    *os_ << "const size_t " << name << " = " << idx.str() << ";" << endl;
+  }
+
+  if (sub.range == nullptr) {
+    return make_tuple(name, "-1", "-1");
+  }
+  const auto rng = range(sub.range);
+  return make_tuple(name, rng.first, rng.second);
+}
+
+void Codegen::assign(const Identifier* lhs, const string& val) {
+  const auto var = find_var(lhs);
+  if (var == var_ids_.size()) {
+    return;
+  }
+  const auto* r = var_ids_[var];
+  const auto d = deref(r, lhs);
+
+  // Fast Path: Full assignments to scalars 
+  if ((get<0>(d) == "0") && (get<1>(d) == "-1")) {
+    *os_ << "if (!" << var_name(var) << "[0].eq(" << val << ")) {" << endl;
+    os_->tab();
+    *os_ << var_name(var) << "[0].assign(" << val << ");" << endl;
+    notify(var);
+    os_->untab();
+    *os_ << "}" << endl;
+    return;
+  }
+
+  const auto msb = (get<1>(d) == "-1") ? get<1>(d) : ("static_cast<int>(" + get<1>(d) + ")");
+  const auto lsb = (get<2>(d) == "-1") ? get<2>(d) : ("static_cast<int>(" + get<2>(d) + ")");
+  const auto arity = eval_->get_array_value(r).size();
+  if (monitors_[var].empty()) {
+    *os_ << "assign(" << var_name(var) << ", " << arity << ", " << get<0>(d) << ", " << msb << ", " << lsb << ", " << val << ");" << endl;
+  } else {
+    *os_ << "if (assign(" << var_name(var) << ", " << arity << ", " << get<0>(d) << ", " << msb << ", " << lsb << ", " << val << ")) {" << endl;
+    os_->tab();
+    notify(var);
+    os_->untab();
+    *os_ << "}" << endl;
+  }
+}
+
+void Codegen::notify(size_t var) {
+  for (auto p : monitors_[var]) {
+    *os_ << "schedule(" << p << ");" << endl;
+  }
+}
+
+void Codegen::task(const SystemTaskEnableStatement* s) {
+  *os_ << "if (!silent_) {" << endl;
+  os_->tab();
+  *os_ << "host_->task(" << tasks_.size() << ");" << endl;
+  os_->untab();
+  *os_ << "}" << endl;
+  tasks_.push_back(s);
+}
+
+void Codegen::emit_proc(size_t proc) {
+  *os_ << "void Program::p" << proc << "() {" << endl;
+  os_->tab();
+
+  const auto* n = procs_[proc];
+  switch (n->get_tag()) {
+    case Node::Tag::continuous_assign: {
+      const auto* ca = static_cast<const ContinuousAssign*>(n);
+      const auto val = expr(ca->get_rhs());
+      assign(ca->get_lhs(), val);
+      break;
+    }
+    case Node::Tag::event: {
+      const auto* e = static_cast<const Event*>(n);
+      const auto* id = static_cast<const Identifier*>(e->get_expr());
+      const auto v = var_name(get_var(id)) + "[0]";
+      const auto stmt = get_guarded(e);
+
+      switch (e->get_type()) {
+        case Event::Type::POSEDGE:
+          *os_ << "if (" << v << ".to_bool()) {" << endl;
+          break;
+        case Event::Type::NEGEDGE:
+          *os_ << "if (!" << v << ".to_bool()) {" << endl;
+          break;
+        default:
+          *os_ << "{" << endl;
+          break;
+      }
+      os_->tab();
+      *os_ << "schedule(" << stmt << ");" << endl;
+      os_->untab();
+      *os_ << "}" << endl;
+      break;
+    }
+    default:
+      n->accept(this);
+      break;
+  }
+
+  os_->untab();
+  *os_ << "}" << endl;
+  *os_ << endl;
+}
+
+void Codegen::visit(const BinaryExpression* be) {
+  const auto lhs = expr(be->get_lhs());
+  const auto rhs = expr(be->get_rhs());
+  const auto res = temp(be);
+
+  *os_ << res << ".";
+  switch (be->get_op()) {
+    case BinaryExpression::Op::PLUS:
+      *os_ << "arithmetic_plus";
+      break;
+    case BinaryExpression::Op::MINUS:
+      *os_ << "arithmetic_minus";
+      break;
+    case BinaryExpression::Op::TIMES:
+      *os_ << "arithmetic_multiply";
+      break;
+    case BinaryExpression::Op::DIV:
+      *os_ << "arithmetic_divide";
+      break;
+    case BinaryExpression::Op::MOD:
+      *os_ << "arithmetic_mod";
+      break;
+    // NOTE: These are equivalent because we don't support x and z
+    case BinaryExpression::Op::EEEQ:
+    case BinaryExpression::Op::EEQ:
+      *os_ << "logical_eq";
+      break;
+    // NOTE: These are equivalent because we don't support x and z
+    case BinaryExpression::Op::BEEQ:
+    case BinaryExpression::Op::BEQ:
+      *os_ << "logical_ne";
+      break;
+    case BinaryExpression::Op::AAMP:
+      *os_ << "logical_and";
+      break;
+    case BinaryExpression::Op::PPIPE:
+      *os_ << "logical_or";
+      break;
+    case BinaryExpression::Op::TTIMES:
+      *os_ << "arithmetic_pow";
+      break;
+    case BinaryExpression::Op::LT:
+      *os_ << "logical_lt";
+      break;
+    case BinaryExpression::Op::LEQ:
+      *os_ << "logical_lte";
+      break;
+    case BinaryExpression::Op::GT:
+      *os_ << "logical_gt";
+      break;
+    case BinaryExpression::Op::GEQ:
+      *os_ << "logical_gte";
+      break;
+    case BinaryExpression::Op::AMP:
+      *os_ << "bitwise_and";
+      break;
+    case BinaryExpression::Op::PIPE:
+      *os_ << "bitwise_or";
+      break;
+    case BinaryExpression::Op::CARAT:
+      *os_ << "bitwise_xor";
+      break;
+    case BinaryExpression::Op::TCARAT:
+      *os_ << "bitwise_xnor";
+      break;
+    case BinaryExpression::Op::LLT:
+      *os_ << "bitwise_sll";
+      break;
+    case BinaryExpression::Op::LLLT:
+      *os_ << "bitwise_sal";
+      break;
+    case BinaryExpression::Op::GGT:
+      *os_ << "bitwise_slr";
+      break;
+    case BinaryExpression::Op::GGGT:
+      *os_ << "bitwise_sar";
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  *os_ << "(" << lhs << ", " << rhs << ");" << endl;
+  res_ = res;
+}
+
+void Codegen::visit(const ConditionalExpression* ce) {
+  const auto cond = expr(ce->get_cond());
+  const auto res = temp(ce);
+
+  *os_ << "if (" << cond << ".to_bool()) {" << endl;
+  os_->tab();
+  const auto lhs = expr(ce->get_lhs());
+  *os_ << res << ".assign(" << lhs << ");" << endl;
+  os_->untab();
+  *os_ << "} else {" << endl;
+  os_->tab();
+  const auto rhs = expr(ce->get_rhs());
+  *os_ << res << ".assign(" << rhs << ");" << endl;
+  os_->untab();
+  *os_ << "}" << endl;
+  res_ = res;
+}
+
+void Codegen::visit(const FeofExpression* fe) {
+  const auto fd = uint_expr(fe->get_fd());
+  const auto res = temp(fe);
+  *os_ << res << ".set(0, host_->feof(" << fd << "));" << endl;
+  res_ = res;
+}
+
+void Codegen::visit(const FopenExpression* fe) {
+  // SwLogic doesn't install an fopen handler. Calls to $fopen() are resolved
+  // when a core is finalized and otherwise evaluate to zero.
+  (void) fe;
+  res_ = constant(Bits(32, static_cast<uint32_t>(0)));
+}
+
+void Codegen::visit(const Concatenation* c) {
+  vector<string> vals;
+  for (auto i = c->begin_exprs(), ie = c->end_exprs(); i != ie; ++i) {
+    vals.push_back(expr(*i));
+  }
+  const auto res = temp(c);
+  *os_ << res << ".assign(" << vals[0] << ");" << endl;
+  for (size_t i = 1, ie = vals.size(); i < ie; ++i) {
+    *os_ << res << ".concat(" << vals[i] << ");" << endl;
+  }
+  res_ = res;
+}
+
+void Codegen::visit(const Identifier* id) {
+  const auto var = find_var(id);
+  if ((var == var_ids_.size()) || (var_ids_[var] == id)) {
+    fail("references to variables which are not declared locally");
+    res_ = "";
+    return;
+  }
+  const auto* r = var_ids_[var];
+  const auto v = var_name(var);
+  const auto arity = eval_->get_array_value(r).size();
+  const auto width = eval_->get_width(r);
+
+  // Fast Path: Full reads from scalars with matching width and type can refer
+  // to variable storage directly.
+  if (r->empty_dim() && id->empty_dim() && (eval_->get_width(id) == width) && (eval_->get_type(id) == eval_->get_type(r))) {
+    res_ = v + "[0]";
+    return;
+  }
+
+  const auto d = deref(r, id);
+  const auto res = temp(id);
+  const auto checked = (get<0>(d) != "0");
+  if (checked) {
+    *os_ << "if (" << get<0>(d) << " < " << arity << ") {" << endl;
+    os_->tab();
+  }
+  if (get<1>(d) == "-1") {
+    *os_ << res << ".assign(" << v << "[" << get<0>(d) << "]);" << endl;
+  } else {
+    *os_ << res << ".assign(" << v << "[" << get<0>(d) << "], " 
+         << "std::min<size_t>(" << get<1>(d) << ", " << (width-1) << "), "
+         << "std::min<size_t>(" << get<2>(d) << ", " << (width-1) << "));" << endl;
+  }
+  if (checked) {
+    os_->untab();
+    *os_ << "}" << endl;
+  }
+  res_ = res;
+}
+
+void Codegen::visit(const MultipleConcatenation* mc) {
+  const auto n = uint_expr(mc->get_expr());
+  const auto concat = expr(mc->get_concat());
+  const auto res = temp(mc);
+  *os_ << res << ".assign(" << concat << ");" << endl;
+  *os_ << "for (size_t i = 1, ie = " << n << "; i < ie; ++i) {" << endl;
+  os_->tab();
+  *os_ << res << ".concat(" << concat << ");" << endl;
+  os_->untab();
+  *os_ << "}" << endl;
+  res_ = res;
+}
+
+void Codegen::visit(const Number* n) {
+  res_ = constant(eval_->get_value(n));
+}
+
+void Codegen::visit(const String* s) {
+  res_ = constant(eval_->get_value(s));
+}
+
+void Codegen::visit(const UnaryExpression* ue) {
+  const auto lhs = expr(ue->get_lhs());
+  const auto res = temp(ue);
+
+  *os_ << res << ".";
+  switch (ue->get_op()) {
+    case UnaryExpression::Op::PLUS:
+      *os_ << "arithmetic_plus";
+      break;
+    case UnaryExpression::Op::MINUS:
+      *os_ << "arithmetic_minus";
+      break;
+    case UnaryExpression::Op::BANG:
+      *os_ << "logical_not";
+      break;
+    case UnaryExpression::Op::TILDE:
+      *os_ << "bitwise_not";
+      break;
+    case UnaryExpression::Op::AMP:
+      *os_ << "reduce_and";
+      break;
+    case UnaryExpression::Op::TAMP:
+      *os_ << "reduce_nand";
+      break;
+    case UnaryExpression::Op::PIPE:
+      *os_ << "reduce_or";
+      break;
+    case UnaryExpression::Op::TPIPE:
+      *os_ << "reduce_nor";
+      break;
+    case UnaryExpression::Op::CARAT:
+      *os_ << "reduce_xor";
+      break;
+    case UnaryExpression::Op::TCARAT:
+      *os_ << "reduce_xnor";
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  *os_ << "(" << lhs << ");" << endl;
+  res_ = res;
+}
+
+void Codegen::visit(const BlockingAssign* ba) {
+  if (ba->is_non_null_ctrl()) {
+    return fail("timing control in blocking assignments");
+  }
+  const auto val = expr(ba->get_rhs());
+  assign(ba->get_lhs(), val);
+}
+
+void Codegen::visit(const NonblockingAssign* na) {
+  if (na->is_non_null_ctrl()) {
+    return fail("timing control in non-blocking assignments");
+  }
+  const auto var = find_var(na->get_lhs());
+  if (var == var_ids_.size()) {
+    return;
+  }
+
+  *os_ << "if (!silent_) {" << endl;
+  os_->tab();
+  const auto d = deref(var_ids_[var], na->get_lhs());
+  const auto val = expr(na->get_rhs());
+  const auto msb = (get<1>(d) == "-1") ? get<1>(d) : ("static_cast<int>(" + get<1>(d) + ")");
+  const auto lsb = (get<2>(d) == "-1") ? get<2>(d) : ("static_cast<int>(" + get<2>(d) + ")");
+  *os_ << "enqueue(" << var << ", " << get<0>(d) << ", " << msb << ", " << lsb << ", " << val << ");" << endl;
+  os_->untab();
+  *os_ << "}" << endl;
+}
+
+void Codegen::visit(const CaseStatement* cs) {
+  // Case statements are lowered to a sequence of guarded blocks inside of a
+  // loop that runs once. Matching an item breaks out of the loop.
+  *os_ << "do {" << endl;
+  os_->tab();
+  const auto cond = uint_expr(cs->get_cond());
+  const auto s = fresh("s");
+  *os_ << "const auto " << s << " = " << cond << ";" << endl;
+
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    if ((*i)->empty_exprs()) {
+      (*i)->accept_stmt(this);
+      *os_ << "break;" << endl;
+      break;
+    }
+    const auto m = fresh("m");
+    *os_ << "bool " << m << " = false;" << endl;
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      const auto first = (j == (*i)->begin_exprs());
+      if (!first) {
+        *os_ << "if (!" << m << ") {" << endl;
+        os_->tab();
+      }
+      const auto c = uint_expr(*j);
+      *os_ << m << " = (" << s << " == " << c << ");" << endl;
+      if (!first) {
+        os_->untab();
+        *os_ << "}" << endl;
+      }
+    }
+    *os_ << "if (" << m << ") {" << endl;
+    os_->tab();
+    (*i)->accept_stmt(this);
+    *os_ << "break;" << endl;
+    os_->untab();
+    *os_ << "}" << endl;
+  }
+
+  os_->untab();
+  *os_ << "} while (false);" << endl;
+}
+
+void Codegen::visit(const ConditionalStatement* cs) {
+  const auto cond = expr(cs->get_if());
+  *os_ << "if (" << cond << ".to_bool()) {" << endl;
+  os_->tab();
+  cs->accept_then(this);
+  os_->untab();
+  *os_ << "} else {" << endl;
+  os_->tab();
+  cs->accept_else(this);
+  os_->untab();
+  *os_ << "}" << endl;
+}
+
+} // namespace cascade::native
@@ -0,0 +1,145 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_CODEGEN_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_CODEGEN_H
+
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "target/core/common/lowering.h"
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+
+namespace cascade {
+
+class indstream;
+
+namespace native {
+
+// This class lowers the ir form of a module (the output of
+// Module::regenerate_ir_source()) to a c++ implementation of the NativeModule
+// interface (see native_module.h). The generated code mirrors the semantics
+// of SwLogic exactly: expressions are evaluated using the same Bits methods
+// that Evaluate uses, and processes are scheduled using the same active-queue
+// discipline. The difference is that sizes, types, subscripts, and
+// sensitivity lists are resolved at compile time rather than by walking the
+// AST at runtime.
+
+class Codegen : public Lowering {
+  public:
+    Codegen();
+    ~Codegen() override = default;
+
+    // Generates code for md. Returns false if md contains a construct which
+    // this backend doesn't support, in which case get_error() describes the
+    // problem. The generated code exports a single function, native_create(),
+    // which returns a new instance of a NativeModule.
+    bool run(const ModuleDeclaration* md);
+
+    // Returns the result of the last invocation of run().
+    const std::string& get_text() const;
+
+    // Returns the index which was assigned to the variable that id resolves
+    // to. This method is undefined for identifiers which were not declared in
+    // the module which was passed to run().
+    size_t get_var(const Identifier* id) const;
+    // Returns the system tasks in md, in the order in which they are indexed
+    // by calls to NativeHost::task().
+    const std::vector<const SystemTaskEnableStatement*>& get_tasks() const;
+
+  private:
+    // Analysis State:
+    Evaluate analysis_;
+    std::string text_;
+
+    // Code Generation State:
+    std::stringstream members_;
+    std::stringstream init_;
+    indstream* os_;
+    size_t next_name_;
+    std::string res_;
+
+    // Code Generation Helpers:
+    //
+    // Returns a fresh name with a given prefix.
+    std::string fresh(const std::string& prefix);
+    // Returns the c++ name of the storage for a variable.
+    std::string var_name(size_t var) const;
+    // Declares storage for the value of e and returns its name.
+    std::string temp(const Expression* e);
+    // Declares storage for a constant and returns its name.
+    std::string constant(const Bits& b);
+    // Returns a c++ expression for a type constant.
+    std::string type_name(Bits::Type t) const;
+    // Emits code for e and returns the name of the Bits which holds its value.
+    std::string expr(const Expression* e);
+    // Emits code for e and returns a c++ expression for its unsigned value.
+    std::string uint_expr(const Expression* e);
+    // Emits code for e and returns c++ expressions for its upper and lower
+    // values. Mirrors Evaluate::get_range().
+    std::pair<std::string, std::string> range(const Expression* e);
+    // Emits code for dereferencing i, which resolves to r. Returns c++
+    // expressions for an index and bit range. Mirrors Evaluate::dereference().
+    std::tuple<std::string, std::string, std::string> deref(const Identifier* r, const Identifier* i);
+    // Emits code for assigning val to lhs and scheduling the processes which
+    // depend on its value. Mirrors Evaluate::assign_value().
+    void assign(const Identifier* lhs, const std::string& val);
+    // Emits code for scheduling the processes which depend on a variable.
+    void notify(size_t var);
+    // Emits code for handing a system task off to the host.
+    void task(const SystemTaskEnableStatement* s) override;
+    // Emits the body of a process.
+    void emit_proc(size_t proc);
+
+    // Visitor Interface:
+    void visit(const BinaryExpression* be) override;
+    void visit(const ConditionalExpression* ce) override;
+    void visit(const FeofExpression* fe) override;
+    void visit(const FopenExpression* fe) override;
+    void visit(const Concatenation* c) override;
+    void visit(const Identifier* id) override;
+    void visit(const MultipleConcatenation* mc) override;
+    void visit(const Number* n) override;
+    void visit(const String* s) override;
+    void visit(const UnaryExpression* ue) override;
+    void visit(const BlockingAssign* ba) override;
+    void visit(const NonblockingAssign* na) override;
+    void visit(const CaseStatement* cs) override;
+    void visit(const ConditionalStatement* cs) override;
+};
+
+} // namespace native
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,154 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/native_compiler.h"
+
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "common/system.h"
+#include "target/compiler.h"
+#include "verilog/analyze/module_info.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+NativeCompiler::NativeCompiler() : CoreCompiler() { 
+  set_path("/tmp/native");
+}
+
+NativeCompiler& NativeCompiler::set_path(const string& path) {
+  path_ = path;
+  return *this;
+}
+
+void NativeCompiler::stop_compile(Engine::Id id) {
+  lock_guard<mutex> lg(lock_);
+  const auto itr = pids_.find(id);
+  if (itr != pids_.end()) {
+    System::kill_tree(itr->second);
+    pids_.erase(itr);
+  }
+}
+
+NativeLogic* NativeCompiler::compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
+  // Lower the module to c++. NativeLogic assumes ownership of md.
+  ModuleInfo info(md);
+  auto* c = new NativeLogic(interface, md);
+  if (!c->generate()) {
+    get_compiler()->error(c->get_error());
+    delete c;
+    return nullptr;
+  }
+  for (auto* i : info.inputs()) {
+    c->set_input(i, to_vid(i));
+  }
+  for (auto* s : info.stateful()) { 
+    c->set_state(s, to_vid(s));
+  }
+  for (auto* o : info.outputs()) {
+    c->set_output(o, to_vid(o));
+  }
+
+  // Write the generated code to a scratch directory
+  System::execute("mkdir -p " + path_);
+  auto path = path_ + "/program_logic_XXXXXX";
+  if (mkdtemp(&path[0]) == nullptr) {
+    get_compiler()->error("Unable to create a scratch directory for the native backend in " + path_ + "!");
+    delete c;
+    return nullptr;
+  }
+  const auto dir = path;
+  ofstream ofs(dir + "/program_logic.cc");
+  ofs << c->get_text() << endl;
+  ofs.close();
+
+  // Build it into a shared library. This can take a while, so record the pid
+  // of the build process in case we're asked to stop.
+  unique_lock<mutex> ul(lock_);
+  const auto pid = System::no_block_begin_execute(
+    "cd " + System::src_root() + "/share/cascade/native/ && ./build_native.sh " + 
+    dir + " " + System::cxx_compiler() + " " + System::source_dir() + " " + System::install_prefix() + 
+    " > " + dir + "/build.log 2>&1", false
+  );
+  pids_[id] = pid;
+  ul.unlock();
+  const auto res = System::no_block_wait_finish(pid);
+  ul.lock();
+  const auto stopped = (pids_.erase(id) == 0);
+  ul.unlock();
+
+  // Nothing to report if we were asked to stop
+  if (stopped) {
+    System::execute("rm -rf " + dir);
+    delete c;
+    return nullptr;
+  }
+
+  // Leave everything in place if the build failed, and pass along as much of
+  // the compiler's output as is reasonable.
+  if (res != 0) {
+    ifstream ifs(dir + "/build.log");
+    stringstream ss;
+    ss << "Unable to build native code for this module! Build output was left in " << dir << ":";
+    string line;
+    for (size_t i = 0; (i < 20) && getline(ifs, line); ++i) {
+      ss << "\n" << line;
+    }
+    get_compiler()->error(ss.str());
+    delete c;
+    return nullptr;
+  }
+
+  // Load the result. The library can be unlinked as soon as it's been opened.
+  auto* handle = dlopen((dir + "/libnative.so").c_str(), RTLD_NOW);
+  System::execute("rm -rf " + dir);
+  if (handle == nullptr) {
+    get_compiler()->error("Unable to load native code for this module!");
+    delete c;
+    return nullptr;
+  }
+  auto create = (NativeModule* (*)(NativeHost*)) dlsym(handle, "native_create");
+  if (create == nullptr) {
+    dlclose(handle);
+    get_compiler()->error("Unable to load native code for this module!");
+    delete c;
+    return nullptr;
+  }
+  c->set_module(handle, create(c));
+
+  return c;
+}
+
+} // namespace cascade::native
@@ -0,0 +1,73 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_COMPILER_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_COMPILER_H
+
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include "target/core/native/native_logic.h"
+#include "target/core_compiler.h"
+
+namespace cascade::native {
+
+// This compiler lowers logic cores to c++, builds the result into a shared
+// library using the host c++ compiler, and loads it back into the runtime.
+// Cores which use constructs that the code generator doesn't support are
+// rejected, and remain in whatever backend they were previously running in.
+// Builds take place in a scratch directory beneath path; the directories of
+// failed builds are left in place, along with the compiler's output.
+
+class NativeCompiler : public CoreCompiler {
+  public:
+    NativeCompiler();
+    ~NativeCompiler() override = default;
+
+    NativeCompiler& set_path(const std::string& path);
+
+    void stop_compile(Engine::Id id) override;
+
+  private:
+    // Configuration State:
+    std::string path_;
+
+    // Compilation State:
+    std::mutex lock_;
+    std::unordered_map<Engine::Id, pid_t> pids_;
+
+    // Core Compiler Interface:
+    NativeLogic* compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
+};
+
+} // namespace cascade::native
+
+#endif
@@ -0,0 +1,402 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/native/native_logic.h"
+
+#include <cassert>
+#include <dlfcn.h>
+#include <sstream>
+#include "target/core/common/interfacestream.h"
+#include "target/input.h"
+#include "target/state.h"
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+#include "verilog/print/print.h"
+
+using namespace std;
+
+namespace cascade::native {
+
+NativeLogic::NativeLogic(Interface* interface, ModuleDeclaration* md) : Logic(interface), NativeHost(), sync_(this) {
+  src_ = md;
+  handle_ = nullptr;
+  module_ = nullptr;
+  there_were_tasks_ = false;
+
+  eval_.set_feof_handler([this](Evaluate* eval, const FeofExpression* fe) {
+    (void) eval;
+    const auto fd = eval_.get_value(fe->get_fd()).to_uint();
+    return get_stream(fd)->eof();
+  });
+}
+
+NativeLogic::~NativeLogic() {
+  // The module has to be deleted before the library it was loaded from
+  if (module_ != nullptr) {
+    delete module_;
+  }
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+  delete src_;
+  for (auto& s : streams_) {
+    delete s.second;
+  }
+}
+
+bool NativeLogic::generate() {
+  return codegen_.run(src_);
+}
+
+const string& NativeLogic::get_text() const {
+  return codegen_.get_text();
+}
+
+const string& NativeLogic::get_error() const {
+  return codegen_.get_error();
+}
+
+NativeLogic& NativeLogic::set_input(const Identifier* id, VId vid) {
+  if (vid >= inputs_.size()) {
+    inputs_.resize(vid+1, nullptr);
+  }
+  inputs_[vid] = id;
+  return *this;
+}
+
+NativeLogic& NativeLogic::set_state(const Identifier* id, VId vid) {
+  state_.insert(make_pair(vid, id));
+  return *this;
+}
+
+NativeLogic& NativeLogic::set_output(const Identifier* id, VId vid) {
+  outputs_.push_back(make_pair(id, vid));
+  return *this;
+}
+
+NativeLogic& NativeLogic::set_module(void* handle, NativeModule* module) {
+  handle_ = handle;
+  module_ = module;
+
+  // Cache pointers to the storage for inputs and outputs. These are on the
+  // critical path for reads and writes.
+  input_vars_.resize(inputs_.size(), make_pair(0, nullptr));
+  for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
+    if (inputs_[v] != nullptr) {
+      const auto var = codegen_.get_var(inputs_[v]);
+      input_vars_[v] = make_pair(var, module_->get_var(var));
+    }
+  }
+  for (const auto& o : outputs_) {
+    output_vars_.push_back(make_pair(module_->get_var(codegen_.get_var(o.first)), o.second));
+  }
+  return *this;
+}
+
+State* NativeLogic::get_state() {
+  auto* s = new State();
+  for (const auto& sv : state_) {
+    const auto var = codegen_.get_var(sv.second);
+    const auto* val = module_->get_var(var);
+    Vector<Bits> vals(module_->get_arity(var));
+    for (size_t i = 0, ie = vals.size(); i < ie; ++i) {
+      vals[i] = val[i];
+    }
+    s->insert(sv.first, vals);
+  }
+  return s;
+}
+
+void NativeLogic::set_state(const State* s) {
+  for (const auto& sv : state_) {
+    const auto itr = s->find(sv.first);
+    if (itr != s->end()) {
+      const auto var = codegen_.get_var(sv.second);
+      auto* val = module_->get_var(var);
+      assert(itr->second.size() == module_->get_arity(var));
+      for (size_t i = 0, ie = itr->second.size(); i < ie; ++i) {
+        val[i].assign(itr->second[i]);
+      }
+      module_->notify(var);
+    }
+  }
+  module_->evaluate(true);
+}
+
+Input* NativeLogic::get_input() {
+  auto* i = new Input();
+  for (size_t v = 0, ve = input_vars_.size(); v < ve; ++v) {
+    if (input_vars_[v].second != nullptr) {
+      i->insert(v, *input_vars_[v].second);
+    }
+  }
+  return i;
+}
+
+void NativeLogic::set_input(const Input* i) {
+  for (size_t v = 0, ve = input_vars_.size(); v < ve; ++v) {
+    auto& iv = input_vars_[v];
+    if (iv.second == nullptr) {
+      continue;
+    }
+    const auto itr = i->find(v);
+    if ((itr != i->end()) && !iv.second->eq(itr->second)) {
+      iv.second->assign(itr->second);
+      module_->notify(iv.first);
+    }
+  }
+  module_->evaluate(true);
+}
+
+void NativeLogic::finalize() {
+  // Handle calls to fopen. Initial constructs are removed from the code that
+  // this core is compiled from, so there's nothing else to do here.
+  for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
+    if (!(*i)->is(Node::Tag::reg_declaration)) {
+      continue;
+    }
+    const auto* rd = static_cast<const RegDeclaration*>(*i);
+    if (!rd->is_non_null_val() || !rd->get_val()->is(Node::Tag::fopen_expression)) {
+      continue;
+    }
+    const auto var = codegen_.get_var(rd->get_id());
+    auto* val = module_->get_var(var);
+    if (val[0].to_uint() != 0) {
+      continue;
+    }
+    const auto* fe = static_cast<const FopenExpression*>(rd->get_val());
+    const auto path = eval_.get_value(fe->get_path()).to_string();
+    const auto type = eval_.get_value(fe->get_type()).to_string();
+    uint8_t mode = 0;
+    if (type == "r" || type == "rb") {
+      mode = 0;
+    } else if (type == "w" || type == "wb") {
+      mode = 1;
+    } else if (type == "a" || type == "ab") {
+      mode = 2;
+    } else if (type == "r+" || type == "r+b" || type == "rb+") {
+      mode = 3;
+    } else if (type == "w+" || type == "w+b" || type == "wb+") {
+      mode = 4;
+    } else if (type == "a+" || type == "a+b" || type == "ab+") {
+      mode = 5;
+    } 
+    const Bits fd(32, interface()->fopen(path, mode));
+    if (!val[0].eq(fd)) {
+      val[0].assign(fd);
+      module_->notify(var);
+    }
+  }
+}
+
+bool NativeLogic::is_thread_safe() const {
+  return true;
+}
+
+void NativeLogic::read(VId vid, const Bits* b) {
+  assert(vid < input_vars_.size());
+  auto& iv = input_vars_[vid];
+  assert(iv.second != nullptr);
+  if (!iv.second->eq(*b)) {
+    iv.second->assign(*b);
+    module_->notify(iv.first);
+  }
+}
+
+void NativeLogic::evaluate() {
+  there_were_tasks_ = false;
+  module_->evaluate(false);
+  write_outputs();
+}
+
+bool NativeLogic::there_are_updates() const {
+  return module_->there_are_updates();
+}
+
+void NativeLogic::update() {
+  there_were_tasks_ = false;
+  module_->update();
+  write_outputs();
+}
+
+bool NativeLogic::there_were_tasks() const {
+  return there_were_tasks_;
+}
+
+bool NativeLogic::feof(uint32_t fd) {
+  return get_stream(fd)->eof();
+}
+
+void NativeLogic::task(size_t idx) {
+  const auto* task = codegen_.get_tasks()[idx];
+  switch (task->get_tag()) {
+    case Node::Tag::debug_statement: {
+      const auto* ds = static_cast<const DebugStatement*>(task);
+      stringstream ss;
+      ss << ds->get_arg();
+      interface()->debug(Evaluate().get_value(ds->get_action()).to_uint(), ss.str());
+      there_were_tasks_ = true;
+      break;
+    }
+    case Node::Tag::fflush_statement: {
+      const auto* fs = static_cast<const FflushStatement*>(task);
+      fs->accept_fd(&sync_);
+      auto* is = get_stream(eval_.get_value(fs->get_fd()).to_uint());
+      is->clear();
+      is->flush();
+      module_->notify_eofs();
+      break;
+    }
+    case Node::Tag::finish_statement: {
+      const auto* fs = static_cast<const FinishStatement*>(task);
+      fs->accept_arg(&sync_);
+      interface()->finish(eval_.get_value(fs->get_arg()).to_uint());
+      there_were_tasks_ = true;
+      break;
+    }
+    case Node::Tag::fseek_statement: {
+      const auto* fs = static_cast<const FseekStatement*>(task);
+      fs->accept_fd(&sync_);
+      auto* is = get_stream(eval_.get_value(fs->get_fd()).to_uint());
+      const auto offset = eval_.get_value(fs->get_offset()).to_uint();
+      const auto op = eval_.get_value(fs->get_op()).to_uint();
+      const auto way = (op == 0) ? ios_base::beg : (op == 1) ? ios_base::cur : ios_base::end;
+      is->clear();
+      is->seekg(offset, way); 
+      is->seekp(offset, way);
+      module_->notify_eofs();
+      break;
+    }
+    case Node::Tag::get_statement: {
+      const auto* gs = static_cast<const GetStatement*>(task);
+      gs->accept_fd(&sync_);
+      auto* is = get_stream(eval_.get_value(gs->get_fd()).to_uint());
+      if (gs->is_non_null_var()) {
+        // Scanf may perform a partial write to this variable. Make sure that
+        // the rest of its value is up to date.
+        gs->get_var()->accept_dim(&sync_);
+        const auto* r = Resolve().get_resolution(gs->get_var());
+        assert(r != nullptr);
+        sync_var(r);
+        scanf_.read(*is, &eval_, gs);
+
+        const auto var = codegen_.get_var(r);
+        const auto& vals = eval_.get_array_value(r);
+        auto* val = module_->get_var(var);
+        for (size_t i = 0, ie = vals.size(); i < ie; ++i) {
+          if (!val[i].eq(vals[i])) {
+            val[i].assign(vals[i]);
+          }
+        }
+        module_->notify(var);
+      } else {
+        scanf_.read(*is, &eval_, gs);
+      }
+      module_->notify_eofs();
+      break;
+    }
+    case Node::Tag::put_statement: {
+      const auto* ps = static_cast<const PutStatement*>(task);
+      ps->accept_fd(&sync_);
+      ps->accept_expr(&sync_);
+      auto* is = get_stream(eval_.get_value(ps->get_fd()).to_uint());
+      printf_.write(*is, &eval_, ps);
+      module_->notify_eofs();
+      break;
+    }
+    case Node::Tag::restart_statement: {
+      const auto* rs = static_cast<const RestartStatement*>(task);
+      interface()->restart(rs->get_arg()->get_readable_val());
+      there_were_tasks_ = true;
+      break;
+    }
+    case Node::Tag::retarget_statement: {
+      const auto* rs = static_cast<const RetargetStatement*>(task);
+      interface()->retarget(rs->get_arg()->get_readable_val());
+      there_were_tasks_ = true;
+      break;
+    }
+    case Node::Tag::save_statement: {
+      const auto* ss = static_cast<const SaveStatement*>(task);
+      interface()->save(ss->get_arg()->get_readable_val());
+      there_were_tasks_ = true;
+      break;
+    }
+    default:
+      assert(false);
+      break;
+  }
+}
+
+NativeLogic::Sync::Sync(NativeLogic* nl) : Visitor() {
+  nl_ = nl;
+}
+
+void NativeLogic::Sync::visit(const Identifier* id) {
+  id->accept_dim(this);
+  const auto* r = Resolve().get_resolution(id);
+  assert(r != nullptr);
+  if (r->empty_dim()) {
+    nl_->sync_var(r);
+    return;
+  }
+  // Only synchronize the element of an array that this identifier refers to
+  const auto var = nl_->codegen_.get_var(r);
+  const auto idx = get<0>(nl_->eval_.dereference(r, id));
+  if (idx < nl_->module_->get_arity(var)) {
+    nl_->eval_.assign_value(r, idx, -1, -1, nl_->module_->get_var(var)[idx]);
+  }
+}
+
+interfacestream* NativeLogic::get_stream(FId fd) {
+  const auto itr = streams_.find(fd);
+  if (itr != streams_.end()) {
+    return itr->second;
+  }
+  auto* is = new interfacestream(interface(), fd);
+  streams_[fd] = is;
+  return is;
+}
+
+void NativeLogic::sync_var(const Identifier* r) {
+  const auto var = codegen_.get_var(r);
+  const auto* val = module_->get_var(var);
+  for (size_t i = 0, ie = module_->get_arity(var); i < ie; ++i) {
+    eval_.assign_value(r, i, -1, -1, val[i]);
+  }
+}
+
+void NativeLogic::write_outputs() {
+  for (const auto& o : output_vars_) {
+    interface()->write(o.second, o.first);
+  }
+}
+
+} // namespace cascade::native
@@ -0,0 +1,139 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_LOGIC_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_LOGIC_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/bits.h"
+#include "target/core.h"
+#include "target/core/common/printf.h"
+#include "target/core/common/scanf.h"
+#include "target/core/native/codegen.h"
+#include "target/core/native/native_module.h"
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade {
+
+class interfacestream;
+
+namespace native {
+
+class NativeLogic : public Logic, public NativeHost {
+  public:
+    NativeLogic(Interface* interface, ModuleDeclaration* md);
+    ~NativeLogic() override;
+
+    // Code Generation Interface:
+    //
+    // Generates a c++ implementation of this core. Returns false and sets
+    // an error message if the core can't be lowered to c++.
+    bool generate();
+    const std::string& get_text() const;
+    const std::string& get_error() const;
+
+    // Configuration Interface:
+    //
+    // These methods may only be invoked after a successful call to generate().
+    // The core assumes ownership of module and the shared library handle
+    // which it was loaded from.
+    NativeLogic& set_input(const Identifier* id, VId vid);
+    NativeLogic& set_state(const Identifier* id, VId vid);
+    NativeLogic& set_output(const Identifier* id, VId vid);
+    NativeLogic& set_module(void* handle, NativeModule* module);
+
+    // Core Interface:
+    State* get_state() override;
+    void set_state(const State* s) override;
+    Input* get_input() override;
+    void set_input(const Input* i) override;
+    void finalize() override;
+    bool is_thread_safe() const override;
+
+    void read(VId vid, const Bits* b) override;
+    void evaluate() override;
+    bool there_are_updates() const override;
+    void update() override;
+    bool there_were_tasks() const override;
+
+    // Native Host Interface:
+    bool feof(uint32_t fd) override;
+    void task(size_t idx) override;
+
+  private:
+    // Synchronizes the values of the identifiers which appear in an AST
+    // subtree with the values stored in the native module.
+    class Sync : public Visitor {
+      public:
+        explicit Sync(NativeLogic* nl);
+        ~Sync() override = default;
+      private:
+        NativeLogic* nl_;
+        void visit(const Identifier* id) override;
+    };
+
+    // Source Management:
+    ModuleDeclaration* src_;
+    Codegen codegen_;
+    std::vector<const Identifier*> inputs_;
+    std::unordered_map<VId, const Identifier*> state_;
+    std::vector<std::pair<const Identifier*, VId>> outputs_;
+
+    // Native Module State:
+    void* handle_;
+    NativeModule* module_;
+    std::vector<std::pair<size_t, Bits*>> input_vars_;
+    std::vector<std::pair<Bits*, VId>> output_vars_;
+
+    // Control State:
+    bool there_were_tasks_;
+    std::unordered_map<FId, interfacestream*> streams_;
+
+    // Evaluation Helpers:
+    Evaluate eval_;
+    Sync sync_;
+    Scanf scanf_;
+    Printf printf_;
+
+    // Control Helpers:
+    interfacestream* get_stream(FId fd);
+    void sync_var(const Identifier* r);
+    void write_outputs();
+};
+
+} // namespace native
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,243 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_MODULE_H
+#define CASCADE_SRC_TARGET_CORE_NATIVE_NATIVE_MODULE_H
+
+#include <algorithm>
+#include <sstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "common/bits.h"
+
+namespace cascade::native {
+
+// This file defines the interface between a native logic core and the shared
+// library that the native compiler generates for it. Generated code includes
+// this file and common/bits.h and nothing else, so everything below must
+// remain header-only.
+
+// Callbacks from generated code into the core which loaded it. 
+
+class NativeHost {
+  public:
+    virtual ~NativeHost() = default;
+
+    // Returns the result of evaluating $feof(fd).
+    virtual bool feof(uint32_t fd) = 0;
+    // Executes the idx'th system task in the module. Any variables which are
+    // read by this task are accessed through the NativeModule interface.
+    virtual void task(size_t idx) = 0;
+};
+
+// The interface exported by generated code. Variables are identified by the
+// indices that the native code generator assigned to their declarations.
+
+class NativeModule {
+  public:
+    virtual ~NativeModule() = default;
+
+    // Variable Interface:
+    //
+    // Returns a pointer to the storage for a variable and the number of
+    // elements in that storage.
+    virtual Bits* get_var(size_t var) = 0;
+    virtual size_t get_arity(size_t var) const = 0;
+    // Schedules everything which depends on the value of a variable. 
+    virtual void notify(size_t var) = 0;
+    // Schedules everything which depends on the value of an $feof() expression.
+    virtual void notify_eofs() = 0;
+
+    // Execution Interface:
+    //
+    // Drains the active queue. System tasks and non-blocking assignments are
+    // ignored while in silent mode.
+    virtual void evaluate(bool silent) = 0;
+    // Returns true if there are pending non-blocking assignments.
+    virtual bool there_are_updates() const = 0;
+    // Performs pending non-blocking assignments and drains the active queue.
+    virtual void update() = 0;
+};
+
+// Common functionality for generated code. Subclasses provide storage for
+// variables and an implementation of run() which dispatches control to the
+// process with a given index. Processes are continuous assigns, events, and
+// the bodies of always blocks.
+
+class NativeBase : public NativeModule {
+  public:
+    NativeBase(NativeHost* host, size_t procs);
+    ~NativeBase() override = default;
+
+    // Execution Interface:
+    void evaluate(bool silent) override;
+    bool there_are_updates() const override;
+    void update() override;
+
+  protected:
+    // Host callbacks:
+    NativeHost* host_;
+    // Control State:
+    bool silent_;
+
+    // Scheduling Interface:
+    void schedule(size_t proc);
+    virtual void run(size_t proc) = 0;
+
+    // Assignment Interface:
+    //
+    // Assigns val to the idx'th element of var, or a slice of that element if
+    // msb is not -1. Mirrors Evaluate::assign_value() and returns true if the
+    // value of var was changed.
+    static bool assign(Bits* var, size_t arity, size_t idx, int msb, int lsb, const Bits& val);
+    // Records a non-blocking assignment.
+    void enqueue(size_t var, size_t idx, int msb, int lsb, const Bits& val);
+
+    // Value Construction:
+    //
+    // Returns a zero-valued bit string of width n and type t.
+    static Bits make_bits(size_t n, Bits::Type t);
+    // Returns a bit string from its serialized form.
+    static Bits make_bits(const char* data, size_t n);
+
+  private:
+    struct Update {
+      size_t var;
+      size_t idx;
+      int msb;
+      int lsb;
+    };
+
+    std::vector<size_t> active_;
+    std::vector<bool> scheduled_;
+    std::vector<Update> updates_;
+    std::vector<Bits> update_pool_;
+};
+
+inline NativeBase::NativeBase(NativeHost* host, size_t procs) {
+  host_ = host;
+  silent_ = false;
+  active_.reserve(procs);
+  scheduled_.resize(procs, false);
+  update_pool_.resize(1);
+}
+
+inline void NativeBase::evaluate(bool silent) {
+  silent_ = silent;
+  while (!active_.empty()) {
+    const auto p = active_.back();
+    active_.pop_back();
+    scheduled_[p] = false;
+    run(p);
+  }
+  silent_ = false;
+}
+
+inline bool NativeBase::there_are_updates() const {
+  return !updates_.empty();
+}
+
+inline void NativeBase::update() {
+  // This is a for loop. Updates happen simultaneously
+  for (size_t i = 0, ie = updates_.size(); i < ie; ++i) {
+    const auto& u = updates_[i];
+    if (assign(get_var(u.var), get_arity(u.var), u.idx, u.msb, u.lsb, update_pool_[i])) {
+      notify(u.var);
+    }
+  }
+  updates_.clear();
+  evaluate(false);
+}
+
+inline void NativeBase::schedule(size_t proc) {
+  if (!scheduled_[proc]) {
+    scheduled_[proc] = true;
+    active_.push_back(proc);
+  }
+}
+
+inline bool NativeBase::assign(Bits* var, size_t arity, size_t idx, int msb, int lsb, const Bits& val) {
+  // Corner Case: Ignore writes to out of bounds indices
+  if (idx >= arity) {
+    return false;
+  }
+  // Fast Path: Full assignments are easy to check
+  if (msb == -1) {
+    if (!var[idx].eq(val)) {
+      var[idx].assign(val);
+      return true;
+    }
+    return false;
+  }
+  // Corner Case: Ignore writes to bit ranges which are completely out of bounds
+  const auto w = var[idx].size();
+  if (static_cast<size_t>(lsb) >= w) {
+    return false;
+  }
+  // Partial Case: Perform as much of the assignment as possible
+  const auto m = std::min(static_cast<size_t>(msb), w-1);
+  const auto l = std::min(static_cast<size_t>(lsb), w-1);
+  if (!var[idx].eq(m, l, val)) {
+    var[idx].assign(m, l, val);
+    return true;
+  }
+  return false;
+}
+
+inline void NativeBase::enqueue(size_t var, size_t idx, int msb, int lsb, const Bits& val) {
+  const auto i = updates_.size();
+  if (i >= update_pool_.size()) {
+    update_pool_.resize(2*update_pool_.size());
+  }
+  updates_.push_back({var, idx, msb, lsb});
+  update_pool_[i].copy(val);
+}
+
+inline Bits NativeBase::make_bits(size_t n, Bits::Type t) {
+  if (t == Bits::Type::REAL) {
+    return Bits(0.0);
+  }
+  Bits res(n, static_cast<uint32_t>(0));
+  res.reinterpret_type(t);
+  return res;
+}
+
+inline Bits NativeBase::make_bits(const char* data, size_t n) {
+  std::istringstream iss(std::string(data, n));
+  Bits res;
+  res.deserialize(iss);
+  return res;
+}
+
+} // namespace cascade::native
+
+#endif
@@ -0,0 +1,149 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_ARENA_H
+#define CASCADE_SRC_TARGET_CORE_SW_ARENA_H
+
+#include <cassert>
+#include <new>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "common/bits.h"
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+
+namespace cascade::sw {
+
+// This class owns a single, cache-line aligned block of storage for the
+// variables in a software core. Variables are laid out contiguously in the
+// order in which they are added, so that the values which are touched
+// together (ie: the stateful variables during a call to get_state or
+// set_state) are adjacent in memory. Values of 64 bits or fewer are stored
+// inline in their Bits headers and are fully contained in the arena. Wider
+// values keep their words on the heap.
+
+class Arena {
+  public:
+    Arena();
+    Arena(const Arena& rhs) = delete;
+    Arena& operator=(const Arena& rhs) = delete;
+    ~Arena();
+
+    // Adds a variable to the arena and returns the offset of its first
+    // element. Adding a variable more than once has no effect.
+    size_t push_back(Evaluate* eval, const Identifier* id);
+    // Allocates storage for all of the variables which were added by
+    // push_back and moves their values there. This method may be called at
+    // most once.
+    void allocate(Evaluate* eval);
+
+    // Returns the number of elements in the arena.
+    size_t size() const;
+    // Returns a pointer to the element at offset idx.
+    Bits* get(size_t idx);
+    // Returns the offset of b, or size() if b is not stored in the arena.
+    size_t offset(const Bits* b) const;
+
+  private:
+    static constexpr size_t line_ = 64;
+
+    std::vector<const Identifier*> ids_;
+    std::unordered_map<const Identifier*, size_t> index_;
+    size_t size_;
+    Bits* data_;
+};
+
+inline Arena::Arena() {
+  size_ = 0;
+  data_ = nullptr;
+}
+
+inline Arena::~Arena() {
+  // Identifiers which are still pointing into the arena don't own their
+  // storage, so there's no danger of a double free here.
+  for (size_t i = 0; i < size_; ++i) {
+    data_[i].~Bits();
+  }
+  if (data_ != nullptr) {
+    ::operator delete(data_, std::align_val_t(line_));
+  }
+}
+
+inline size_t Arena::push_back(Evaluate* eval, const Identifier* id) {
+  assert(data_ == nullptr);
+  const auto res = index_.insert(std::make_pair(id, size_));
+  if (!res.second) {
+    return res.first->second;
+  }
+  ids_.push_back(id);
+  size_ += eval->get_array_value(id).size();
+  return res.first->second;
+}
+
+inline void Arena::allocate(Evaluate* eval) {
+  assert(data_ == nullptr);
+  if (size_ == 0) {
+    return;
+  }
+  data_ = static_cast<Bits*>(::operator new(size_ * sizeof(Bits), std::align_val_t(line_)));
+  for (size_t i = 0; i < size_; ++i) {
+    new (data_ + i) Bits();
+  }
+  auto* itr = data_;
+  for (auto* id : ids_) {
+    const auto n = eval->get_array_value(id).size();
+    eval->relocate(id, itr);
+    itr += n;
+  }
+}
+
+inline size_t Arena::size() const {
+  return size_;
+}
+
+inline Bits* Arena::get(size_t idx) {
+  assert(idx < size_);
+  return data_ + idx;
+}
+
+inline size_t Arena::offset(const Bits* b) const {
+  // Compare addresses as integers, as b may point anywhere in memory
+  const auto base = reinterpret_cast<uintptr_t>(data_);
+  const auto addr = reinterpret_cast<uintptr_t>(b);
+  if ((addr < base) || (addr >= base + size_ * sizeof(Bits))) {
+    return size_;
+  }
+  return (addr - base) / sizeof(Bits);
+}
+
+} // namespace cascade::sw
+
+#endif
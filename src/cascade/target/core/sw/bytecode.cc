@@ -0,0 +1,919 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/sw/bytecode.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace std;
+
+namespace cascade::sw {
+
+Bytecode::Bytecode(Evaluate* eval) : Lowering("Bytecode interpreter", eval) {
+  task_ = nullptr;
+  feof_ = nullptr;
+  silent_ = false;
+  res_ = 0;
+}
+
+Bytecode& Bytecode::set_task_handler(TaskHandler h) {
+  task_ = h;
+  return *this;
+}
+
+Bytecode& Bytecode::set_feof_handler(FeofHandler h) {
+  feof_ = h;
+  return *this;
+}
+
+bool Bytecode::compile(const ModuleDeclaration* md) {
+  // Index variables and processes. Variable storage aliases the storage that
+  // Evaluate associates with declarations.
+  if (!index(md, true)) {
+    return false;
+  }
+  size_t base = 0;
+  for (auto* id : var_ids_) {
+    const auto& val = eval_->get_array_value(id);
+    vars_.push_back({id, const_cast<Bits*>(&val[0]), val.size(), eval_->get_width(id), base, false});
+    base += val.size();
+  }
+
+  // Translate process bodies
+  for (size_t p = 0, pe = procs_.size(); p < pe; ++p) {
+    entry_.push_back(code_.size());
+    emit_proc(p);
+    emit(Op::RET);
+  }
+  if (!error_.empty()) {
+    return false;
+  }
+
+  // Now that the register pool has stopped growing, it's safe to resolve
+  // pointers to its elements.
+  for (const auto& pr : pool_regs_) {
+    regs_[pr.first] = &pool_[pr.second];
+  }
+  pool_regs_.clear();
+
+  scheduled_.resize(procs_.size(), false);
+  ranks_.resize(procs_.size(), 0);
+  // Size the update buffer to hold one write from every enqueue instruction
+  // without growing.
+  const auto elems = vars_.empty() ? 0 : (vars_.back().base + vars_.back().arity);
+  const auto enqueues = count_if(code_.begin(), code_.end(), [](const Instr& i) {
+    return i.op == Op::ENQUEUE;
+  });
+  updates_.reserve(elems, enqueues);
+  return true;
+}
+
+void Bytecode::levelize(const vector<const Node*>& levels) {
+  // Ranks are offset by one so that zero can denote a dynamically scheduled
+  // process. The events which guard an always block share its rank.
+  for (auto* n : levels) {
+    const auto itr = proc_index_.find(n);
+    assert(itr != proc_index_.end());
+    levels_.push_back(itr->second);
+    ranks_[itr->second] = levels_.size();
+
+    if (n->is(Node::Tag::continuous_assign)) {
+      continue;
+    }
+    assert(n->get_parent()->is(Node::Tag::timing_control_statement));
+    const auto* tcs = static_cast<const TimingControlStatement*>(n->get_parent());
+    const auto* ec = static_cast<const EventControl*>(tcs->get_ctrl());
+    for (auto i = ec->begin_events(), ie = ec->end_events(); i != ie; ++i) {
+      ranks_[proc_index_[*i]] = levels_.size();
+    }
+  }
+}
+
+void Bytecode::notify(const Identifier* id) {
+  const auto itr = var_index_.find(id);
+  if (itr == var_index_.end()) {
+    return;
+  }
+  for (auto p : monitors_[itr->second]) {
+    schedule(p);
+  }
+}
+
+void Bytecode::notify_eofs() {
+  for (const auto& ef : eofs_) {
+    for (auto p : ef.second) {
+      schedule(p);
+    }
+  }
+}
+
+void Bytecode::run_initial_constructs() {
+  for (auto p : initial_) {
+    run(p);
+  }
+}
+
+void Bytecode::evaluate(bool silent) {
+  silent_ = silent;
+  while (true) {
+    if (!active_.empty()) {
+      const auto p = active_.back();
+      active_.pop_back();
+      scheduled_[p] = false;
+      run(p);
+    } else if (!ranked_.empty()) {
+      const auto p = levels_[ranked_.top()];
+      ranked_.pop();
+      scheduled_[p] = false;
+      run(p);
+    } else {
+      break;
+    }
+  }
+  silent_ = false;
+}
+
+bool Bytecode::there_are_updates() const {
+  return !updates_.empty();
+}
+
+void Bytecode::update() {
+  // This is a for loop. Updates happen simultaneously
+  for (auto i = updates_.begin(), ie = updates_.end(); i != ie; ++i) {
+    const auto& t = i->target;
+    if (assign(t.first, t.second, i->msb, i->lsb, updates_.value(i))) {
+      changed(t.first);
+    }
+  }
+  updates_.clear();
+}
+
+void Bytecode::flush() {
+  for (auto v : dirty_) {
+    eval_->flag_changed(vars_[v].id);
+    vars_[v].dirty = false;
+  }
+  dirty_.clear();
+}
+
+uint32_t Bytecode::emit(Op op, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  code_.push_back({op, a, b, c, d});
+  return code_.size() - 1;
+}
+
+uint32_t Bytecode::temp(const Expression* e) {
+  const auto t = eval_->get_type(e);
+  if (t == Bits::Type::REAL) {
+    pool_.push_back(Bits(0.0));
+  } else {
+    pool_.push_back(Bits(eval_->get_width(e), static_cast<uint32_t>(0)));
+    pool_.back().reinterpret_type(t);
+  }
+  pool_regs_.push_back(make_pair(regs_.size(), pool_.size()-1));
+  regs_.push_back(nullptr);
+  return regs_.size() - 1;
+}
+
+uint32_t Bytecode::constant(const Bits& b) {
+  pool_.push_back(b);
+  pool_regs_.push_back(make_pair(regs_.size(), pool_.size()-1));
+  regs_.push_back(nullptr);
+  return regs_.size() - 1;
+}
+
+uint32_t Bytecode::slots(size_t n) {
+  ints_.resize(ints_.size() + n, 0);
+  return ints_.size() - n;
+}
+
+uint32_t Bytecode::expr(const Expression* e) {
+  res_ = 0;
+  e->accept(this);
+  return res_;
+}
+
+void Bytecode::uint_expr(const Expression* e, uint32_t slot) {
+  // Small numbers can be folded into the instruction stream
+  if (e->is(Node::Tag::number)) {
+    const auto val = eval_->get_value(e).to_uint();
+    if (val <= numeric_limits<uint32_t>::max()) {
+      emit(Op::IMM, slot, val);
+      return;
+    }
+  }
+  const auto r = expr(e);
+  emit(Op::UINT, slot, r);
+}
+
+void Bytecode::range(const Expression* e, uint32_t msb, uint32_t lsb) {
+  if (!e->is(Node::Tag::range_expression)) {
+    uint_expr(e, msb);
+    emit(Op::ICOPY, lsb, msb);
+    return;
+  }
+
+  const auto* re = static_cast<const RangeExpression*>(e);
+  switch (re->get_type()) {
+    case RangeExpression::Type::PLUS: {
+      const auto t = slots(1);
+      uint_expr(re->get_upper(), lsb);
+      uint_expr(re->get_lower(), t);
+      emit(Op::RPLUS, msb, lsb, t);
+      break;
+    }
+    case RangeExpression::Type::MINUS: {
+      const auto t = slots(1);
+      uint_expr(re->get_upper(), msb);
+      uint_expr(re->get_lower(), t);
+      emit(Op::RMINUS, lsb, msb, t);
+      break;
+    }
+    default:
+      uint_expr(re->get_upper(), msb);
+      uint_expr(re->get_lower(), lsb);
+      break;
+  }
+}
+
+pair<uint32_t, bool> Bytecode::deref(const Identifier* r, const Identifier* i) {
+  // Subscripts are stored in three consecutive slots: index, msb, and lsb
+  const auto base = slots(3);
+  emit(Op::IMM, base, 0);
+
+  Subscript sub;
+  if (!get_subscript(r, i, &sub)) {
+    return make_pair(base, false);
+  }
+  for (const auto& t : sub.terms) {
+    const auto s = slots(1);
+    uint_expr(t.second, s);
+    emit(Op::MADD, base, t.first, s);
+  }
+  if (sub.range == nullptr) {
+    return make_pair(base, false);
+  }
+  range(sub.range, base+1, base+2);
+  return make_pair(base, true);
+}
+
+void Bytecode::assign(const Identifier* lhs, uint32_t val) {
+  const auto var = find_var(lhs);
+  if (var == vars_.size()) {
+    return;
+  }
+  const auto* r = vars_[var].id;
+  if (r->empty_dim() && lhs->empty_dim()) {
+    emit(Op::STORE_SCALAR, val, var);
+    return;
+  }
+  const auto d = deref(r, lhs);
+  emit(d.second ? Op::STORE_SLICE : Op::STORE, val, var, d.first);
+}
+
+void Bytecode::patch(uint32_t pc) {
+  code_[pc].a = code_.size();
+}
+
+void Bytecode::emit_proc(size_t proc) {
+  const auto* n = procs_[proc];
+  switch (n->get_tag()) {
+    case Node::Tag::continuous_assign: {
+      const auto* ca = static_cast<const ContinuousAssign*>(n);
+      const auto val = expr(ca->get_rhs());
+      assign(ca->get_lhs(), val);
+      break;
+    }
+    case Node::Tag::event: {
+      const auto* e = static_cast<const Event*>(n);
+      const auto var = find_var(static_cast<const Identifier*>(e->get_expr()));
+      emit(Op::EVENT, var, static_cast<uint32_t>(e->get_type()), get_guarded(e));
+      break;
+    }
+    default:
+      n->accept(this);
+      break;
+  }
+}
+
+void Bytecode::task(const SystemTaskEnableStatement* s) {
+  emit(Op::TASK, tasks_.size());
+  tasks_.push_back(s);
+}
+
+void Bytecode::schedule(size_t proc) {
+  const auto rank = ranks_[proc];
+  if (rank != 0) {
+    const auto p = levels_[rank-1];
+    if (!scheduled_[p]) {
+      ranked_.push(rank-1);
+      scheduled_[p] = true;
+    }
+  } else if (!scheduled_[proc]) {
+    active_.push_back(proc);
+    scheduled_[proc] = true;
+  }
+}
+
+void Bytecode::run(size_t proc) {
+  auto* const regs = regs_.data();
+  auto* const ints = ints_.data();
+  for (const auto* i = code_.data() + entry_[proc]; ; ++i) {
+    switch (i->op) {
+      case Op::ADD:
+        regs[i->a]->arithmetic_plus(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::SUB:
+        regs[i->a]->arithmetic_minus(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::MUL:
+        regs[i->a]->arithmetic_multiply(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::DIV:
+        regs[i->a]->arithmetic_divide(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::MOD:
+        regs[i->a]->arithmetic_mod(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::POW:
+        regs[i->a]->arithmetic_pow(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::EQ:
+        regs[i->a]->logical_eq(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::NE:
+        regs[i->a]->logical_ne(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::LAND:
+        regs[i->a]->logical_and(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::LOR:
+        regs[i->a]->logical_or(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::LT:
+        regs[i->a]->logical_lt(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::LTE:
+        regs[i->a]->logical_lte(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::GT:
+        regs[i->a]->logical_gt(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::GTE:
+        regs[i->a]->logical_gte(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::AND:
+        regs[i->a]->bitwise_and(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::OR:
+        regs[i->a]->bitwise_or(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::XOR:
+        regs[i->a]->bitwise_xor(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::XNOR:
+        regs[i->a]->bitwise_xnor(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::SLL:
+        regs[i->a]->bitwise_sll(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::SAL:
+        regs[i->a]->bitwise_sal(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::SLR:
+        regs[i->a]->bitwise_slr(*regs[i->b], *regs[i->c]);
+        break;
+      case Op::SAR:
+        regs[i->a]->bitwise_sar(*regs[i->b], *regs[i->c]);
+        break;
+
+      case Op::UPLUS:
+        regs[i->a]->arithmetic_plus(*regs[i->b]);
+        break;
+      case Op::UMINUS:
+        regs[i->a]->arithmetic_minus(*regs[i->b]);
+        break;
+      case Op::LNOT:
+        regs[i->a]->logical_not(*regs[i->b]);
+        break;
+      case Op::NOT:
+        regs[i->a]->bitwise_not(*regs[i->b]);
+        break;
+      case Op::RAND:
+        regs[i->a]->reduce_and(*regs[i->b]);
+        break;
+      case Op::RNAND:
+        regs[i->a]->reduce_nand(*regs[i->b]);
+        break;
+      case Op::ROR:
+        regs[i->a]->reduce_or(*regs[i->b]);
+        break;
+      case Op::RNOR:
+        regs[i->a]->reduce_nor(*regs[i->b]);
+        break;
+      case Op::RXOR:
+        regs[i->a]->reduce_xor(*regs[i->b]);
+        break;
+      case Op::RXNOR:
+        regs[i->a]->reduce_xnor(*regs[i->b]);
+        break;
+
+      case Op::MOV:
+        regs[i->a]->assign(*regs[i->b]);
+        break;
+      case Op::CONCAT:
+        regs[i->a]->concat(*regs[i->b]);
+        break;
+      case Op::MCAT:
+        regs[i->a]->assign(*regs[i->b]);
+        for (size_t j = 1, je = ints[i->c]; j < je; ++j) {
+          regs[i->a]->concat(*regs[i->b]);
+        }
+        break;
+      case Op::FEOF:
+        regs[i->a]->set(0, (feof_ != nullptr) ? feof_(ints[i->b]) : true);
+        break;
+
+      case Op::IMM:
+        ints[i->a] = i->b;
+        break;
+      case Op::UINT:
+        ints[i->a] = regs[i->b]->to_uint();
+        break;
+      case Op::ICOPY:
+        ints[i->a] = ints[i->b];
+        break;
+      case Op::MADD:
+        ints[i->a] += i->b * ints[i->c];
+        break;
+      case Op::RPLUS:
+        ints[i->a] = ints[i->b] + ints[i->c] - 1;
+        break;
+      case Op::RMINUS:
+        ints[i->a] = ints[i->b] - ints[i->c] + 1;
+        break;
+
+      case Op::LOAD: {
+        const auto& v = vars_[i->b];
+        const auto idx = ints[i->c];
+        if (idx < v.arity) {
+          regs[i->a]->assign(v.data[idx]);
+        }
+        break;
+      }
+      case Op::LOAD_SLICE: {
+        const auto& v = vars_[i->b];
+        const auto idx = ints[i->c];
+        if (idx < v.arity) {
+          regs[i->a]->assign(v.data[idx], min(ints[i->c+1], v.width-1), min(ints[i->c+2], v.width-1));
+        }
+        break;
+      }
+      case Op::STORE:
+        if (assign(i->b, ints[i->c], -1, -1, *regs[i->a])) {
+          changed(i->b);
+        }
+        break;
+      case Op::STORE_SLICE:
+        if (assign(i->b, ints[i->c], ints[i->c+1], ints[i->c+2], *regs[i->a])) {
+          changed(i->b);
+        }
+        break;
+      case Op::STORE_SCALAR: {
+        auto& v = vars_[i->b].data[0];
+        if (!v.eq(*regs[i->a])) {
+          v.assign(*regs[i->a]);
+          changed(i->b);
+        }
+        break;
+      }
+      case Op::ENQUEUE:
+        if (!silent_) {
+          // Writes are keyed on the element that they target. Out of bounds
+          // writes are never coalesced.
+          const auto& v = vars_[i->b];
+          const auto idx = ints[i->c];
+          const auto key = (idx < v.arity) ? (v.base + idx) : decltype(updates_)::npos;
+          if (i->d) {
+            updates_.push_back(make_pair(i->b, idx), key, static_cast<int>(ints[i->c+1]), static_cast<int>(ints[i->c+2]), *regs[i->a]);
+          } else {
+            updates_.push_back(make_pair(i->b, idx), key, -1, -1, *regs[i->a]);
+          }
+        }
+        break;
+
+      case Op::JMP:
+        i = code_.data() + i->a - 1;
+        break;
+      case Op::JZ:
+        if (!regs[i->b]->to_bool()) {
+          i = code_.data() + i->a - 1;
+        }
+        break;
+      case Op::JEQ:
+        if (ints[i->b] == ints[i->c]) {
+          i = code_.data() + i->a - 1;
+        }
+        break;
+
+      case Op::EVENT: {
+        const auto val = vars_[i->a].data[0].to_bool();
+        const auto type = static_cast<Event::Type>(i->b);
+        if ((type != Event::Type::NEGEDGE && val) || (type != Event::Type::POSEDGE && !val)) {
+          schedule(i->c);
+        }
+        break;
+      }
+      case Op::TASK:
+        if (!silent_ && (task_ != nullptr)) {
+          task_(tasks_[i->a]);
+        }
+        break;
+      case Op::RET:
+        return;
+
+      default:
+        assert(false);
+        return;
+    }
+  }
+}
+
+bool Bytecode::assign(size_t var, size_t idx, int msb, int lsb, const Bits& val) {
+  auto& v = vars_[var];
+
+  // Corner Case: Ignore writes to out of bounds indices
+  if (idx >= v.arity) {
+    return false;
+  }
+  // Fast Path: Full assignments are easy to check
+  if (msb == -1) {
+    if (!v.data[idx].eq(val)) {
+      v.data[idx].assign(val);
+      return true;
+    }
+    return false;
+  }
+  // Corner Case: Ignore writes to bit ranges which are completely out of bounds
+  else if (static_cast<size_t>(lsb) >= v.width) {
+    return false;
+  }
+  // Partial Case: Perform as much of the assignment as possible
+  const auto m = min(static_cast<size_t>(msb), v.width-1);
+  const auto l = min(static_cast<size_t>(lsb), v.width-1);
+  if (!v.data[idx].eq(m, l, val)) {
+    v.data[idx].assign(m, l, val);
+    return true;
+  }
+  return false;
+}
+
+void Bytecode::changed(size_t var) {
+  auto& v = vars_[var];
+  if (!v.dirty) {
+    v.dirty = true;
+    dirty_.push_back(var);
+  }
+  for (auto p : monitors_[var]) {
+    schedule(p);
+  }
+}
+
+void Bytecode::visit(const BinaryExpression* be) {
+  const auto lhs = expr(be->get_lhs());
+  const auto rhs = expr(be->get_rhs());
+  const auto res = temp(be);
+
+  switch (be->get_op()) {
+    case BinaryExpression::Op::PLUS:
+      emit(Op::ADD, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::MINUS:
+      emit(Op::SUB, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::TIMES:
+      emit(Op::MUL, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::DIV:
+      emit(Op::DIV, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::MOD:
+      emit(Op::MOD, res, lhs, rhs);
+      break;
+    // NOTE: These are equivalent because we don't support x and z
+    case BinaryExpression::Op::EEEQ:
+    case BinaryExpression::Op::EEQ:
+      emit(Op::EQ, res, lhs, rhs);
+      break;
+    // NOTE: These are equivalent because we don't support x and z
+    case BinaryExpression::Op::BEEQ:
+    case BinaryExpression::Op::BEQ:
+      emit(Op::NE, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::AAMP:
+      emit(Op::LAND, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::PPIPE:
+      emit(Op::LOR, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::TTIMES:
+      emit(Op::POW, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::LT:
+      emit(Op::LT, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::LEQ:
+      emit(Op::LTE, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::GT:
+      emit(Op::GT, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::GEQ:
+      emit(Op::GTE, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::AMP:
+      emit(Op::AND, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::PIPE:
+      emit(Op::OR, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::CARAT:
+      emit(Op::XOR, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::TCARAT:
+      emit(Op::XNOR, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::LLT:
+      emit(Op::SLL, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::LLLT:
+      emit(Op::SAL, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::GGT:
+      emit(Op::SLR, res, lhs, rhs);
+      break;
+    case BinaryExpression::Op::GGGT:
+      emit(Op::SAR, res, lhs, rhs);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  res_ = res;
+}
+
+void Bytecode::visit(const ConditionalExpression* ce) {
+  const auto cond = expr(ce->get_cond());
+  const auto res = temp(ce);
+
+  const auto jz = emit(Op::JZ, 0, cond);
+  const auto lhs = expr(ce->get_lhs());
+  emit(Op::MOV, res, lhs);
+  const auto jmp = emit(Op::JMP);
+  patch(jz);
+  const auto rhs = expr(ce->get_rhs());
+  emit(Op::MOV, res, rhs);
+  patch(jmp);
+
+  res_ = res;
+}
+
+void Bytecode::visit(const FeofExpression* fe) {
+  const auto fd = slots(1);
+  uint_expr(fe->get_fd(), fd);
+  const auto res = temp(fe);
+  emit(Op::FEOF, res, fd);
+  res_ = res;
+}
+
+void Bytecode::visit(const FopenExpression* fe) {
+  // SwLogic doesn't install an fopen handler. Calls to $fopen() are resolved
+  // when a core is finalized and otherwise evaluate to zero.
+  (void) fe;
+  res_ = constant(Bits(32, static_cast<uint32_t>(0)));
+}
+
+void Bytecode::visit(const Concatenation* c) {
+  vector<uint32_t> vals;
+  for (auto i = c->begin_exprs(), ie = c->end_exprs(); i != ie; ++i) {
+    vals.push_back(expr(*i));
+  }
+  const auto res = temp(c);
+  emit(Op::MOV, res, vals[0]);
+  for (size_t i = 1, ie = vals.size(); i < ie; ++i) {
+    emit(Op::CONCAT, res, vals[i]);
+  }
+  res_ = res;
+}
+
+void Bytecode::visit(const Identifier* id) {
+  const auto var = find_var(id);
+  if ((var == vars_.size()) || (vars_[var].id == id)) {
+    fail("references to variables which are not declared locally");
+    res_ = 0;
+    return;
+  }
+  const auto* r = vars_[var].id;
+
+  // Fast Path: Full reads from scalars with matching width and type can refer
+  // to variable storage directly.
+  if (r->empty_dim() && id->empty_dim() && (eval_->get_width(id) == vars_[var].width) && (eval_->get_type(id) == eval_->get_type(r))) {
+    regs_.push_back(vars_[var].data);
+    res_ = regs_.size() - 1;
+    return;
+  }
+
+  const auto d = deref(r, id);
+  const auto res = temp(id);
+  emit(d.second ? Op::LOAD_SLICE : Op::LOAD, res, var, d.first);
+  res_ = res;
+}
+
+void Bytecode::visit(const MultipleConcatenation* mc) {
+  const auto n = slots(1);
+  uint_expr(mc->get_expr(), n);
+  const auto concat = expr(mc->get_concat());
+  const auto res = temp(mc);
+  emit(Op::MCAT, res, concat, n);
+  res_ = res;
+}
+
+void Bytecode::visit(const Number* n) {
+  res_ = constant(eval_->get_value(n));
+}
+
+void Bytecode::visit(const String* s) {
+  res_ = constant(eval_->get_value(s));
+}
+
+void Bytecode::visit(const UnaryExpression* ue) {
+  const auto lhs = expr(ue->get_lhs());
+  const auto res = temp(ue);
+
+  switch (ue->get_op()) {
+    case UnaryExpression::Op::PLUS:
+      emit(Op::UPLUS, res, lhs);
+      break;
+    case UnaryExpression::Op::MINUS:
+      emit(Op::UMINUS, res, lhs);
+      break;
+    case UnaryExpression::Op::BANG:
+      emit(Op::LNOT, res, lhs);
+      break;
+    case UnaryExpression::Op::TILDE:
+      emit(Op::NOT, res, lhs);
+      break;
+    case UnaryExpression::Op::AMP:
+      emit(Op::RAND, res, lhs);
+      break;
+    case UnaryExpression::Op::TAMP:
+      emit(Op::RNAND, res, lhs);
+      break;
+    case UnaryExpression::Op::PIPE:
+      emit(Op::ROR, res, lhs);
+      break;
+    case UnaryExpression::Op::TPIPE:
+      emit(Op::RNOR, res, lhs);
+      break;
+    case UnaryExpression::Op::CARAT:
+      emit(Op::RXOR, res, lhs);
+      break;
+    case UnaryExpression::Op::TCARAT:
+      emit(Op::RXNOR, res, lhs);
+      break;
+    default:
+      assert(false);
+      break;
+  }
+  res_ = res;
+}
+
+void Bytecode::visit(const BlockingAssign* ba) {
+  if (ba->is_non_null_ctrl()) {
+    return fail("timing control in blocking assignments");
+  }
+  const auto val = expr(ba->get_rhs());
+  assign(ba->get_lhs(), val);
+}
+
+void Bytecode::visit(const NonblockingAssign* na) {
+  if (na->is_non_null_ctrl()) {
+    return fail("timing control in non-blocking assignments");
+  }
+  const auto var = find_var(na->get_lhs());
+  if (var == vars_.size()) {
+    return;
+  }
+  const auto d = deref(vars_[var].id, na->get_lhs());
+  const auto val = expr(na->get_rhs());
+  emit(Op::ENQUEUE, val, var, d.first, d.second ? 1 : 0);
+}
+
+void Bytecode::visit(const CaseStatement* cs) {
+  // Case statements are lowered to a sequence of comparisons. Matching an item
+  // jumps to its body, which then jumps to the end of the statement.
+  const auto s = slots(1);
+  uint_expr(cs->get_cond(), s);
+
+  vector<uint32_t> ends;
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    if ((*i)->empty_exprs()) {
+      (*i)->accept_stmt(this);
+      break;
+    }
+    vector<uint32_t> matches;
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      const auto c = slots(1);
+      uint_expr(*j, c);
+      matches.push_back(emit(Op::JEQ, 0, s, c));
+    }
+    const auto next = emit(Op::JMP);
+    for (auto m : matches) {
+      patch(m);
+    }
+    (*i)->accept_stmt(this);
+    ends.push_back(emit(Op::JMP));
+    patch(next);
+  }
+  for (auto e : ends) {
+    patch(e);
+  }
+}
+
+void Bytecode::visit(const ConditionalStatement* cs) {
+  const auto cond = expr(cs->get_if());
+  const auto jz = emit(Op::JZ, 0, cond);
+  cs->accept_then(this);
+  const auto jmp = emit(Op::JMP);
+  patch(jz);
+  cs->accept_else(this);
+  patch(jmp);
+}
+
+void Bytecode::visit(const ForStatement* fs) {
+  // Loops are lowered to a test which jumps past the body and a jump from the
+  // end of the body back to the test. Most loops are unrolled before they get
+  // here, but nothing in this translation depends on their bounds.
+  const auto init = expr(fs->get_init()->get_rhs());
+  assign(fs->get_init()->get_lhs(), init);
+  const auto top = code_.size();
+  const auto cond = expr(fs->get_cond());
+  const auto jz = emit(Op::JZ, 0, cond);
+  fs->accept_stmt(this);
+  const auto update = expr(fs->get_update()->get_rhs());
+  assign(fs->get_update()->get_lhs(), update);
+  emit(Op::JMP, top);
+  patch(jz);
+}
+
+void Bytecode::visit(const RepeatStatement* rs) {
+  // The trip count is computed once, on entry, and compared against a counter
+  const auto s = slots(3);
+  uint_expr(rs->get_cond(), s);
+  emit(Op::IMM, s+1, 0);
+  emit(Op::IMM, s+2, 1);
+  const auto top = emit(Op::JEQ, 0, s+1, s);
+  rs->accept_stmt(this);
+  emit(Op::MADD, s+1, 1, s+2);
+  emit(Op::JMP, top);
+  patch(top);
+}
+
+void Bytecode::visit(const WhileStatement* ws) {
+  const auto top = code_.size();
+  const auto cond = expr(ws->get_cond());
+  const auto jz = emit(Op::JZ, 0, cond);
+  ws->accept_stmt(this);
+  emit(Op::JMP, top);
+  patch(jz);
+}
+
+} // namespace cascade::sw
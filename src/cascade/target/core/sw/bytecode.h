@@ -0,0 +1,216 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_BYTECODE_H
+#define CASCADE_SRC_TARGET_CORE_SW_BYTECODE_H
+
+#include <functional>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "common/bits.h"
+#include "target/core/common/lowering.h"
+#include "target/core/sw/update_buffer.h"
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+
+namespace cascade::sw {
+
+// This class translates the ir form of a module into a compact, register
+// based bytecode and provides an interpreter for the result. The interpreter
+// implements the same scheduling semantics as SwLogic (a lifo active queue,
+// silent evaluation, and an update queue for non-blocking assigns), but
+// subscripts, widths, and sensitivity lists are resolved once, at compile
+// time, rather than each time an AST node is visited.
+//
+// Variable registers alias the storage that Evaluate associates with
+// declarations, so the values of variables are always visible to code which
+// reads them through Evaluate. Because the interpreter doesn't invalidate
+// Evaluate's cached expression values on every write, callers must invoke
+// flush() before using Evaluate to compute the value of an expression.
+
+class Bytecode : public Lowering {
+  public:
+    // Typedefs:
+    typedef std::function<void(const SystemTaskEnableStatement*)> TaskHandler;
+    typedef std::function<bool(uint32_t)> FeofHandler;
+
+    // Constructors:
+    explicit Bytecode(Evaluate* eval);
+    ~Bytecode() override = default;
+
+    // Configuration Interface:
+    Bytecode& set_task_handler(TaskHandler h);
+    Bytecode& set_feof_handler(FeofHandler h);
+
+    // Compilation Interface:
+    //
+    // Compiles md. Returns false if md contains a construct which the
+    // interpreter doesn't support, in which case get_error() describes the
+    // problem and no other method of this class may be invoked.
+    bool compile(const ModuleDeclaration* md);
+    // Assigns a static evaluation order to a subset of the processes in md.
+    // The elements of levels are continuous assigns or the bodies of always
+    // blocks, in the order computed by Levelize.
+    void levelize(const std::vector<const Node*>& levels);
+
+    // Execution Interface:
+    //
+    // Schedules the processes which depend on the value of a variable. This
+    // method is a no-op for identifiers which aren't declared in md.
+    void notify(const Identifier* id);
+    // Schedules the processes which depend on the value of an $feof().
+    void notify_eofs();
+    // Runs the initial constructs in md, in declaration order.
+    void run_initial_constructs();
+    // Drains the active queue. Non-blocking assigns and system tasks are
+    // ignored in silent mode.
+    void evaluate(bool silent);
+    // Returns true if there are pending non-blocking assignments.
+    bool there_are_updates() const;
+    // Performs pending non-blocking assignments and schedules the processes
+    // which depend on their values. This method does not drain the active
+    // queue.
+    void update();
+    // Forces evaluate to recompute the value of any expression which depends
+    // on a variable that has been written since the last call to flush().
+    void flush();
+
+  private:
+    // Instruction Set:
+    enum class Op : uint8_t {
+      // Arithmetic, logical, and bitwise operators: a = b op c
+      ADD = 0, SUB, MUL, DIV, MOD, POW,
+      EQ, NE, LAND, LOR, LT, LTE, GT, GTE,
+      AND, OR, XOR, XNOR, SLL, SAL, SLR, SAR,
+      // Unary operators: a = op b
+      UPLUS, UMINUS, LNOT, NOT, RAND, RNAND, ROR, RNOR, RXOR, RXNOR,
+      // Data movement: a = b, a = {a,b}, a = {c{b}}, a = $feof(x[b])
+      MOV, CONCAT, MCAT, FEOF,
+      // Integer operations: x[a] = b, x[a] = b.to_uint(), x[a] = x[b],
+      // x[a] += b*x[c],
+      // x[a] = x[b]+x[c]-1, x[a] = x[b]-x[c]+1
+      IMM, UINT, ICOPY, MADD, RPLUS, RMINUS,
+      // Variable access: a = var[b] @ x[c...], var[b] @ x[c...] = a
+      LOAD, LOAD_SLICE, STORE, STORE_SLICE, STORE_SCALAR,
+      // Non-blocking assign: var[b] @ x[c...] <= a, d = is slice
+      ENQUEUE,
+      // Control flow: goto a, if (!b) goto a, if (x[b] == x[c]) goto a
+      JMP, JZ, JEQ,
+      // Processes: schedule c if var[a] matches edge b, task[a], return
+      EVENT, TASK, RET
+    };
+    struct Instr {
+      Op op;
+      uint32_t a;
+      uint32_t b;
+      uint32_t c;
+      uint32_t d;
+    };
+    struct Var {
+      const Identifier* id;
+      Bits* data;
+      size_t arity;
+      size_t width;
+      size_t base;
+      bool dirty;
+    };
+
+    // Handlers:
+    TaskHandler task_;
+    FeofHandler feof_;
+
+    // Program State:
+    std::vector<Instr> code_;
+    std::vector<Bits*> regs_;
+    std::vector<Bits> pool_;
+    std::vector<size_t> ints_;
+    std::vector<Var> vars_;
+    std::vector<size_t> entry_;
+
+    // Execution State:
+    bool silent_;
+    std::vector<size_t> active_;
+    std::vector<bool> scheduled_;
+    std::vector<size_t> ranks_;
+    std::vector<size_t> levels_;
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ranked_;
+    UpdateBuffer<std::pair<size_t, size_t>> updates_;
+    std::vector<size_t> dirty_;
+
+    // Compilation State:
+    std::vector<std::pair<uint32_t, size_t>> pool_regs_;
+    uint32_t res_;
+
+    // Compilation Helpers:
+    uint32_t emit(Op op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0);
+    uint32_t temp(const Expression* e);
+    uint32_t constant(const Bits& b);
+    uint32_t slots(size_t n);
+    uint32_t expr(const Expression* e);
+    void uint_expr(const Expression* e, uint32_t slot);
+    void range(const Expression* e, uint32_t msb, uint32_t lsb);
+    std::pair<uint32_t, bool> deref(const Identifier* r, const Identifier* i);
+    void assign(const Identifier* lhs, uint32_t val);
+    void patch(uint32_t pc);
+    void emit_proc(size_t proc);
+    void task(const SystemTaskEnableStatement* s) override;
+
+    // Execution Helpers:
+    void schedule(size_t proc);
+    void run(size_t proc);
+    bool assign(size_t var, size_t idx, int msb, int lsb, const Bits& val);
+    void changed(size_t var);
+
+    // Visitor Interface:
+    void visit(const BinaryExpression* be) override;
+    void visit(const ConditionalExpression* ce) override;
+    void visit(const FeofExpression* fe) override;
+    void visit(const FopenExpression* fe) override;
+    void visit(const Concatenation* c) override;
+    void visit(const Identifier* id) override;
+    void visit(const MultipleConcatenation* mc) override;
+    void visit(const Number* n) override;
+    void visit(const String* s) override;
+    void visit(const UnaryExpression* ue) override;
+    void visit(const BlockingAssign* ba) override;
+    void visit(const NonblockingAssign* na) override;
+    void visit(const CaseStatement* cs) override;
+    void visit(const ConditionalStatement* cs) override;
+    void visit(const ForStatement* fs) override;
+    void visit(const RepeatStatement* rs) override;
+    void visit(const WhileStatement* ws) override;
+};
+
+} // namespace cascade::sw
+
+#endif
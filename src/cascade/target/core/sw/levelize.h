@@ -0,0 +1,188 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_LEVELIZE_H
+#define CASCADE_SRC_TARGET_CORE_SW_LEVELIZE_H
+
+#include <cassert>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "verilog/analyze/read_set.h"
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade::sw {
+
+// This class computes a static evaluation order for the combinational
+// processes in a module: continuous assigns and always blocks which are
+// triggered only by changes in value (always @(*) blocks are expanded into
+// this form by EventExpand) and which contain no non-blocking assigns. If
+// the processes which read a variable are always evaluated after the
+// processes which write it, then each process only needs to be evaluated
+// once per delta. Processes which appear on a combinational cycle, or
+// downstream from one, are omitted from the result and should be scheduled
+// dynamically.
+
+class Levelize : public Visitor {
+  public:
+    explicit Levelize(const ModuleDeclaration* md);
+    ~Levelize() override = default;
+
+    // Returns continuous assigns and always constructs in topological order.
+    const std::vector<const ModuleItem*>& order() const;
+
+  private:
+    std::vector<const ModuleItem*> order_;
+    std::unordered_set<const Identifier*> writes_;
+    bool combinational_;
+
+    void visit(const BlockingAssign* ba) override;
+    void visit(const NonblockingAssign* na) override;
+    void visit(const TimingControlStatement* tcs) override;
+};
+
+inline Levelize::Levelize(const ModuleDeclaration* md) : Visitor() {
+  // Collect combinational processes along with their read and write sets
+  std::vector<const ModuleItem*> procs;
+  std::vector<std::unordered_set<const Identifier*>> reads;
+  std::unordered_map<const Identifier*, std::vector<size_t>> writers;
+
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    std::unordered_set<const Identifier*> rs;
+    writes_.clear();
+    combinational_ = true;
+
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      for (auto* e : ReadSet(ca->get_rhs())) {
+        if (e->is(Node::Tag::identifier)) {
+          rs.insert(Resolve().get_resolution(static_cast<const Identifier*>(e)));
+        }
+      }
+      writes_.insert(Resolve().get_resolution(ca->get_lhs()));
+    } else if ((*i)->is(Node::Tag::always_construct)) {
+      const auto* ac = static_cast<const AlwaysConstruct*>(*i);
+      if (!ac->get_stmt()->is(Node::Tag::timing_control_statement)) {
+        continue;
+      }
+      const auto* tcs = static_cast<const TimingControlStatement*>(ac->get_stmt());
+      if (!tcs->get_ctrl()->is(Node::Tag::event_control)) {
+        continue;
+      }
+      const auto* ec = static_cast<const EventControl*>(tcs->get_ctrl());
+      for (auto j = ec->begin_events(), je = ec->end_events(); j != je; ++j) {
+        if (((*j)->get_type() != Event::Type::EDGE) || !(*j)->get_expr()->is(Node::Tag::identifier)) {
+          combinational_ = false;
+          break;
+        }
+        rs.insert(Resolve().get_resolution(static_cast<const Identifier*>((*j)->get_expr())));
+      }
+      if (combinational_) {
+        tcs->accept_stmt(this);
+      }
+      if (!combinational_) {
+        continue;
+      }
+    } else {
+      continue;
+    }
+
+    for (auto* w : writes_) {
+      writers[w].push_back(procs.size());
+    }
+    procs.push_back(*i);
+    reads.push_back(rs);
+  }
+
+  // Build the dependence graph. Processes which read their own outputs are
+  // rescheduled by the writes they perform, so self-edges are ignored.
+  std::vector<std::unordered_set<size_t>> succs(procs.size());
+  std::vector<size_t> preds(procs.size(), 0);
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    for (auto* r : reads[p]) {
+      const auto itr = writers.find(r);
+      if (itr == writers.end()) {
+        continue;
+      }
+      for (auto w : itr->second) {
+        if ((w != p) && succs[w].insert(p).second) {
+          ++preds[p];
+        }
+      }
+    }
+  }
+
+  // Topological sort. Anything left with a non-zero in-degree is on or
+  // downstream from a cycle.
+  std::vector<size_t> ready;
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    if (preds[p] == 0) {
+      ready.push_back(p);
+    }
+  }
+  for (size_t i = 0; i < ready.size(); ++i) {
+    order_.push_back(procs[ready[i]]);
+    for (auto s : succs[ready[i]]) {
+      if (--preds[s] == 0) {
+        ready.push_back(s);
+      }
+    }
+  }
+}
+
+inline const std::vector<const ModuleItem*>& Levelize::order() const {
+  return order_;
+}
+
+inline void Levelize::visit(const BlockingAssign* ba) {
+  if (ba->is_non_null_ctrl()) {
+    combinational_ = false;
+    return;
+  }
+  const auto* r = Resolve().get_resolution(ba->get_lhs());
+  assert(r != nullptr);
+  writes_.insert(r);
+}
+
+inline void Levelize::visit(const NonblockingAssign* na) {
+  (void) na;
+  combinational_ = false;
+}
+
+inline void Levelize::visit(const TimingControlStatement* tcs) {
+  (void) tcs;
+  combinational_ = false;
+}
+
+} // namespace cascade::sw
+
+#endif
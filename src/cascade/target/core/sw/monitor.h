@@ -32,6 +32,9 @@
 #define CASCADE_SRC_TARGET_CORE_SW_MONITOR_H
 
 #include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "verilog/analyze/read_set.h"
 #include "verilog/analyze/resolve.h"
 #include "verilog/ast/ast.h"
@@ -39,23 +42,34 @@
 
 namespace cascade::sw {
 
+// This class attaches the nodes which should be scheduled when a variable
+// changes value to that variable's monitor list. Optionally, it will also
+// record the reads of array variables which each of those nodes performs, so
+// that writes to a single element only wake up the nodes that can see it.
+
 class Monitor : public Editor {
   public:
-    Monitor();
+    typedef std::unordered_map<const Identifier*, std::vector<std::pair<const Node*, const Identifier*>>> ArrayReads;
+
+    explicit Monitor(ArrayReads* reads = nullptr);
     ~Monitor() override = default;
 
     void init(ModuleItem* mi);
 
   private:
+    ArrayReads* reads_;
+
     void wait_on_node(Node* n, FeofExpression* fe);
-    void wait_on_node(Node* n, Identifier* m);
+    void wait_on_node(Node* n, Identifier* m, const Identifier* use);
     void wait_on_reads(Node* n, Expression* e);
 
     void edit(Event* e) override;
     void edit(ContinuousAssign* ca) override;
 };
 
-inline Monitor::Monitor() : Editor() { }
+inline Monitor::Monitor(ArrayReads* reads) : Editor() { 
+  reads_ = reads;
+}
 
 inline void Monitor::init(ModuleItem* mi) {
   mi->accept(this);
@@ -65,8 +79,11 @@ inline void Monitor::wait_on_node(Node* n, FeofExpression* fe) {
   fe->monitor_.push_back(n);
 }
 
-inline void Monitor::wait_on_node(Node* n, Identifier* m) {
+inline void Monitor::wait_on_node(Node* n, Identifier* m, const Identifier* use) {
   m->monitor_.push_back(n);
+  if ((reads_ != nullptr) && !m->empty_dim()) {
+    (*reads_)[m].push_back(std::make_pair(n, use));
+  }
 }
 
 inline void Monitor::wait_on_reads(Node* n, Expression* m) {
@@ -75,7 +92,7 @@ inline void Monitor::wait_on_reads(Node* n, Expression* m) {
       const auto* id = static_cast<const Identifier*>(i);
       auto* r = Resolve().get_resolution(id);
       assert(r != nullptr);
-      wait_on_node(n, const_cast<Identifier*>(r));
+      wait_on_node(n, const_cast<Identifier*>(r), id);
     } else if (i->is(Node::Tag::feof_expression)) {
       const auto* fe = static_cast<const FeofExpression*>(i);
       wait_on_node(n, const_cast<FeofExpression*>(fe));
@@ -90,7 +107,7 @@ inline void Monitor::edit(Event* e) {
   assert(e->get_expr()->is(Node::Tag::identifier));
   auto* id = static_cast<Identifier*>(e->get_expr());
   auto* r = Resolve().get_resolution(id);
-  wait_on_node(e, const_cast<Identifier*>(r));
+  wait_on_node(e, const_cast<Identifier*>(r), id);
 }
 
 inline void Monitor::edit(ContinuousAssign* ca) {
@@ -0,0 +1,338 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_PARTITION_H
+#define CASCADE_SRC_TARGET_CORE_SW_PARTITION_H
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "verilog/analyze/read_set.h"
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade::sw {
+
+// This class splits the processes in a module (continuous assigns and always
+// constructs) into clusters which can be simulated independently, exchanging
+// only the values of the variables which are written in one cluster and read
+// in another. Processes which write the same variable are always placed in
+// the same cluster, as are processes which are triggered by an edge on a
+// variable and the process which writes it. Exchanging values between
+// clusters takes an extra round of evaluation, and this keeps derived clocks
+// from glitching while their inputs are in flight. Clusters are grown greedily from the heaviest unassigned
+// process, by repeatedly absorbing the neighbor which shares the most
+// variables with the cluster, until each holds roughly 1/n of the module.
+// Modules which contain initial constructs, instantiations, or which read from
+// or open files are not split, since those operations can't be replicated
+// safely across clusters.
+
+class Partition : public Visitor {
+  public:
+    Partition(const ModuleDeclaration* md, size_t n);
+    ~Partition() override = default;
+
+    // Returns the processes in each cluster, in source order, or an empty
+    // vector if this module can't be split into more than one cluster.
+    const std::vector<std::vector<const ModuleItem*>>& clusters() const;
+    // Returns the resolved variables which are read or written by a cluster.
+    const std::unordered_set<const Identifier*>& reads(size_t c) const;
+    const std::unordered_set<const Identifier*>& writes(size_t c) const;
+
+  private:
+    std::vector<std::vector<const ModuleItem*>> clusters_;
+    std::vector<std::unordered_set<const Identifier*>> reads_;
+    std::vector<std::unordered_set<const Identifier*>> writes_;
+    std::unordered_set<const Identifier*> ws_;
+    std::unordered_set<const Identifier*> es_;
+    bool supported_;
+
+    void visit(const Event* e) override;
+    void visit(const BlockingAssign* ba) override;
+    void visit(const NonblockingAssign* na) override;
+    void visit(const VariableAssign* va) override;
+    void visit(const FeofExpression* fe) override;
+    void visit(const FopenExpression* fe) override;
+    void visit(const FseekStatement* fs) override;
+    void visit(const GetStatement* gs) override;
+};
+
+inline Partition::Partition(const ModuleDeclaration* md, size_t n) : Visitor() {
+  // Collect processes along with their read and write sets
+  std::vector<const ModuleItem*> procs;
+  std::vector<std::unordered_set<const Identifier*>> reads;
+  std::vector<std::unordered_set<const Identifier*>> writes;
+  std::vector<std::unordered_set<const Identifier*>> triggers;
+  supported_ = true;
+
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    std::unordered_set<const Identifier*> rs;
+    ws_.clear();
+    es_.clear();
+
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      for (auto* e : ReadSet(ca->get_rhs())) {
+        if (e->is(Node::Tag::identifier)) {
+          rs.insert(Resolve().get_resolution(static_cast<const Identifier*>(e)));
+        }
+      }
+      for (auto j = ca->begin_lhs(), je = ca->end_lhs(); j != je; ++j) {
+        ws_.insert(Resolve().get_resolution(*j));
+      }
+      ca->accept_rhs(this);
+    } else if ((*i)->is(Node::Tag::always_construct)) {
+      const auto* ac = static_cast<const AlwaysConstruct*>(*i);
+      for (auto* e : ReadSet(ac->get_stmt())) {
+        if (e->is(Node::Tag::identifier)) {
+          rs.insert(Resolve().get_resolution(static_cast<const Identifier*>(e)));
+        }
+      }
+      ac->accept_stmt(this);
+    } else if ((*i)->is(Node::Tag::port_declaration) || (*i)->is_subclass_of(Node::Tag::declaration)) {
+      (*i)->accept(this);
+      continue;
+    } else {
+      supported_ = false;
+    }
+    if (!supported_) {
+      return;
+    }
+
+    procs.push_back(*i);
+    reads.push_back(rs);
+    writes.push_back(ws_);
+    triggers.push_back(es_);
+  }
+
+  // Merge processes which write the same variable into groups
+  std::vector<size_t> group(procs.size());
+  std::iota(group.begin(), group.end(), 0);
+  const auto find = [&group](size_t p) {
+    while (group[p] != p) {
+      p = group[p] = group[group[p]];
+    }
+    return p;
+  };
+  std::unordered_map<const Identifier*, size_t> writer;
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    for (auto* w : writes[p]) {
+      const auto itr = writer.find(w);
+      if (itr == writer.end()) {
+        writer[w] = p;
+      } else {
+        group[find(p)] = find(itr->second);
+      }
+    }
+  }
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    for (auto* e : triggers[p]) {
+      const auto itr = writer.find(e);
+      if (itr != writer.end()) {
+        group[find(p)] = find(itr->second);
+      }
+    }
+  }
+
+  // Weigh each group by the number of variables its processes touch, and
+  // connect groups which exchange values.
+  std::vector<size_t> weight(procs.size(), 0);
+  std::vector<std::unordered_map<size_t, size_t>> edges(procs.size());
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    const auto g = find(p);
+    weight[g] += 1 + reads[p].size() + writes[p].size();
+    for (auto* r : reads[p]) {
+      const auto itr = writer.find(r);
+      if (itr == writer.end()) {
+        continue;
+      }
+      const auto h = find(itr->second);
+      if (g != h) {
+        ++edges[g][h];
+        ++edges[h][g];
+      }
+    }
+  }
+  std::vector<size_t> roots;
+  size_t total = 0;
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    if (find(p) == p) {
+      roots.push_back(p);
+      total += weight[p];
+    }
+  }
+  n = std::min(n, roots.size());
+  if (n < 2) {
+    return;
+  }
+  std::stable_sort(roots.begin(), roots.end(), [&weight](size_t a, size_t b) {
+    return weight[a] > weight[b];
+  });
+
+  // Grow clusters one at a time. The last cluster absorbs whatever is left.
+  std::vector<size_t> cluster(procs.size(), n);
+  size_t seed = 0;
+  for (size_t c = 0; c < n; ++c) {
+    const auto target = total / (n - c);
+    std::priority_queue<std::pair<size_t, size_t>> frontier;
+    std::unordered_map<size_t, size_t> gain;
+    size_t w = 0;
+    while ((c+1 == n) || (w < target)) {
+      auto next = procs.size();
+      while (!frontier.empty()) {
+        const auto g = frontier.top().second;
+        frontier.pop();
+        if (cluster[g] == n) {
+          next = g;
+          break;
+        }
+      }
+      for (; (next == procs.size()) && (seed < roots.size()); ++seed) {
+        if (cluster[roots[seed]] == n) {
+          next = roots[seed];
+        }
+      }
+      if (next == procs.size()) {
+        break;
+      }
+      cluster[next] = c;
+      w += weight[next];
+      for (const auto& e : edges[next]) {
+        if (cluster[e.first] == n) {
+          frontier.push(std::make_pair(gain[e.first] += e.second, e.first));
+        }
+      }
+    }
+    total -= w;
+  }
+
+  // Record the results, dropping any clusters which came up empty
+  clusters_.resize(n);
+  reads_.resize(n);
+  writes_.resize(n);
+  for (size_t p = 0, pe = procs.size(); p < pe; ++p) {
+    const auto c = cluster[find(p)];
+    assert(c < n);
+    clusters_[c].push_back(procs[p]);
+    reads_[c].insert(reads[p].begin(), reads[p].end());
+    writes_[c].insert(writes[p].begin(), writes[p].end());
+  }
+  for (size_t c = n; c > 0; --c) {
+    if (clusters_[c-1].empty()) {
+      clusters_.erase(clusters_.begin() + c - 1);
+      reads_.erase(reads_.begin() + c - 1);
+      writes_.erase(writes_.begin() + c - 1);
+    }
+  }
+  if (clusters_.size() < 2) {
+    clusters_.clear();
+    reads_.clear();
+    writes_.clear();
+  }
+}
+
+inline const std::vector<std::vector<const ModuleItem*>>& Partition::clusters() const {
+  return clusters_;
+}
+
+inline const std::unordered_set<const Identifier*>& Partition::reads(size_t c) const {
+  assert(c < reads_.size());
+  return reads_[c];
+}
+
+inline const std::unordered_set<const Identifier*>& Partition::writes(size_t c) const {
+  assert(c < writes_.size());
+  return writes_[c];
+}
+
+inline void Partition::visit(const Event* e) {
+  if ((e->get_type() != Event::Type::EDGE) && e->get_expr()->is(Node::Tag::identifier)) {
+    const auto* r = Resolve().get_resolution(static_cast<const Identifier*>(e->get_expr()));
+    assert(r != nullptr);
+    es_.insert(r);
+  }
+}
+
+inline void Partition::visit(const BlockingAssign* ba) {
+  for (auto i = ba->begin_lhs(), ie = ba->end_lhs(); i != ie; ++i) {
+    const auto* r = Resolve().get_resolution(*i);
+    assert(r != nullptr);
+    ws_.insert(r);
+  }
+  ba->accept_rhs(this);
+}
+
+inline void Partition::visit(const NonblockingAssign* na) {
+  for (auto i = na->begin_lhs(), ie = na->end_lhs(); i != ie; ++i) {
+    const auto* r = Resolve().get_resolution(*i);
+    assert(r != nullptr);
+    ws_.insert(r);
+  }
+  na->accept_rhs(this);
+}
+
+inline void Partition::visit(const VariableAssign* va) {
+  for (auto i = va->begin_lhs(), ie = va->end_lhs(); i != ie; ++i) {
+    const auto* r = Resolve().get_resolution(*i);
+    assert(r != nullptr);
+    ws_.insert(r);
+  }
+  va->accept_rhs(this);
+}
+
+inline void Partition::visit(const FeofExpression* fe) {
+  (void) fe;
+  supported_ = false;
+}
+
+inline void Partition::visit(const FopenExpression* fe) {
+  (void) fe;
+  supported_ = false;
+}
+
+inline void Partition::visit(const FseekStatement* fs) {
+  (void) fs;
+  supported_ = false;
+}
+
+inline void Partition::visit(const GetStatement* gs) {
+  (void) gs;
+  supported_ = false;
+}
+
+} // namespace cascade::sw
+
+#endif
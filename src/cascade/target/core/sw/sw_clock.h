@@ -52,6 +52,7 @@ class SwClock : public Clock {
 
     bool overrides_done_step() const override;
     void done_step() override;
+    bool is_thread_safe() const override;
 
     void read(VId id, const Bits* b) override;
     void evaluate() override;
@@ -106,6 +107,10 @@ inline void SwClock::done_step() {
   there_are_updates_ = true;
 }
 
+inline bool SwClock::is_thread_safe() const {
+  return true;
+}
+
 inline void SwClock::read(VId id, const Bits* b) {
   // Clocks should never have an input
   assert(false);
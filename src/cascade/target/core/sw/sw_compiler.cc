@@ -31,6 +31,7 @@
 #include "target/core/sw/sw_compiler.h"
 
 #include "target/compiler.h"
+#include "target/core/common/interfacestream.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/analyze/module_info.h"
 #include "verilog/analyze/resolve.h"
@@ -44,6 +45,13 @@ SwCompiler::SwCompiler() : CoreCompiler() {
   set_led(nullptr, nullptr);
   set_pad(nullptr, nullptr);
   set_reset(nullptr, nullptr);
+  set_bytecode(false);
+  set_levelize(false);
+  set_partitions(1);
+}
+
+SwCompiler::~SwCompiler() {
+  pool_.stop_now();
 }
 
 SwCompiler& SwCompiler::set_led(Bits* b, mutex* l) {
@@ -64,6 +72,26 @@ SwCompiler& SwCompiler::set_reset(Bits* b, mutex* l) {
   return *this;
 }
 
+SwCompiler& SwCompiler::set_bytecode(bool enable) {
+  bytecode_ = enable;
+  return *this;
+}
+
+SwCompiler& SwCompiler::set_levelize(bool enable) {
+  levelize_ = enable;
+  return *this;
+}
+
+SwCompiler& SwCompiler::set_partitions(size_t n) {
+  partitions_ = n;
+  pool_.stop_now();
+  if (partitions_ > 1) {
+    pool_.set_num_threads(partitions_-1);
+    pool_.run();
+  }
+  return *this;
+}
+
 void SwCompiler::stop_compile(Engine::Id id) {
   // Does nothing. Compilations all return in a reasonable amount of time.
   (void) id;
@@ -111,10 +139,35 @@ SwLed* SwCompiler::compile_led(Engine::Id id, ModuleDeclaration* md, Interface*
   }
 }
 
-SwLogic* SwCompiler::compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
+Logic* SwCompiler::compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
   (void) id;
 
   ModuleInfo info(md);
+  // Modules which can be split into more than one cluster are simulated by
+  // one thread per cluster. Everything else falls back on a single core.
+  if (partitions_ > 1) {
+    Partition p(md, partitions_);
+    if (!p.clusters().empty()) {
+      auto* c = new SwParallelLogic(interface, md, &pool_);
+      for (auto* i : info.inputs()) {
+        c->set_input(i, to_vid(i));
+      }
+      for (auto* s : info.stateful()) { 
+        c->set_state(s, to_vid(s));
+      }
+      for (auto* o : info.outputs()) {
+        c->set_output(o, to_vid(o));
+      }
+      // Clusters which can't be translated to bytecode run on the ast
+      // interpreter, which is worth a warning but isn't an error.
+      string error;
+      if (!c->split(p, levelize_, bytecode_, &error)) {
+        interfacestream(interface, Runtime::stdwarn_) << error << " Falling back on ast interpretation." << endl;
+      }
+      return c;
+    }
+  }
+
   auto* c = new SwLogic(interface, md);
   for (auto* i : info.inputs()) {
     c->set_input(i, to_vid(i));
@@ -125,6 +178,18 @@ SwLogic* SwCompiler::compile_logic(Engine::Id id, ModuleDeclaration* md, Interfa
   for (auto* o : info.outputs()) {
     c->set_output(o, to_vid(o));
   }
+  c->pack();
+  // Cores without combinational logic fall back on dynamic scheduling, and
+  // cores which can't be translated to bytecode fall back on ast
+  // interpretation. Bytecode is only ever used on request, so warn if we're
+  // unable to provide it. This isn't an error, the module still runs.
+  if (levelize_) {
+    c->levelize();
+  }
+  string error;
+  if (bytecode_ && !c->compile_bytecode(&error)) {
+    interfacestream(interface, Runtime::stdwarn_) << error << " Falling back on ast interpretation." << endl;
+  }
   return c;
 } 
 
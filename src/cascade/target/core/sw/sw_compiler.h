@@ -32,10 +32,12 @@
 #define CASCADE_SRC_TARGET_CORE_SW_SW_COMPILER_H
 
 #include <mutex>
+#include "common/thread_pool.h"
 #include "target/core/sw/sw_clock.h"
 #include "target/core/sw/sw_led.h"
 #include "target/core/sw/sw_logic.h"
 #include "target/core/sw/sw_pad.h"
+#include "target/core/sw/sw_parallel_logic.h"
 #include "target/core/sw/sw_reset.h"
 #include "target/core_compiler.h"
 
@@ -44,18 +46,21 @@ namespace cascade::sw {
 class SwCompiler : public CoreCompiler {
   public:
     SwCompiler();
-    ~SwCompiler() override = default;
+    ~SwCompiler() override;
 
     SwCompiler& set_led(Bits* b, std::mutex* l);
     SwCompiler& set_pad(Bits* b, std::mutex* l);
     SwCompiler& set_reset(Bits* b, std::mutex* l);
+    SwCompiler& set_bytecode(bool enable);
+    SwCompiler& set_levelize(bool enable);
+    SwCompiler& set_partitions(size_t n);
 
     void stop_compile(Engine::Id id) override;
 
   private:
     SwClock* compile_clock(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
     SwLed* compile_led(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
-    SwLogic* compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
+    Logic* compile_logic(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
     SwPad* compile_pad(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
     SwReset* compile_reset(Engine::Id id, ModuleDeclaration* md, Interface* interface) override;
 
@@ -66,6 +71,13 @@ class SwCompiler : public CoreCompiler {
     std::mutex* led_lock_;
     std::mutex* pad_lock_;
     std::mutex* reset_lock_;
+
+    bool bytecode_;
+    bool levelize_;
+    size_t partitions_;
+    // Runs the clusters of every parallel core. Threads are capped at one
+    // fewer than partitions_, since callers run a cluster of their own.
+    ThreadPool pool_;
 };
 
 } // namespace cascade::sw
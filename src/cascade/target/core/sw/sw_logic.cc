@@ -36,7 +36,7 @@
 #include "target/core/common/interfacestream.h"
 #include "target/core/common/printf.h"
 #include "target/core/common/scanf.h"
-#include "target/core/sw/monitor.h"
+#include "target/core/sw/levelize.h"
 #include "target/input.h"
 #include "target/state.h"
 #include "verilog/analyze/module_info.h"
@@ -51,11 +51,11 @@ namespace cascade::sw {
 SwLogic::SwLogic(Interface* interface, ModuleDeclaration* md) : Logic(interface), Visitor() { 
   // Record pointer to source code and provision update pool
   src_ = md;
-  update_pool_.resize(1);
+  bytecode_ = nullptr;
 
   // Initialize monitors and system tasks
   for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
-    Monitor().init(*i);
+    Monitor(&array_reads_).init(*i);
   }
   eval_.set_feof_handler([this](Evaluate* eval, const FeofExpression* fe) {
     const auto fd = eval_.get_value(fe->get_fd()).to_uint();
@@ -76,6 +76,9 @@ SwLogic::SwLogic(Interface* interface, ModuleDeclaration* md) : Logic(interface)
 }
 
 SwLogic::~SwLogic() {
+  if (bytecode_ != nullptr) {
+    delete bytecode_;
+  }
   delete src_;
   for (auto& s : streams_) {
     delete s.second;
@@ -100,21 +103,116 @@ SwLogic& SwLogic::set_output(const Identifier* id, VId vid) {
   return *this;
 }
 
+void SwLogic::pack() {
+  assert(bytecode_ == nullptr);
+
+  // Stateful variables are placed in vid order so that get_state() and
+  // set_state() walk the arena front to back. Everything else follows in
+  // roughly the order that it's touched: inputs, outputs, and then locals.
+  vector<pair<VId, const Identifier*>> state(state_.begin(), state_.end());
+  sort(state.begin(), state.end());
+  for (const auto& sv : state) {
+    const auto n = eval_.get_array_value(sv.second).size();
+    const auto idx = arena_.push_back(&eval_, sv.second);
+    slots_.push_back(make_tuple(sv.first, sv.second, idx, n));
+  }
+  for (auto* i : inputs_) {
+    if (i != nullptr) {
+      arena_.push_back(&eval_, i);
+    }
+  }
+  for (const auto& o : outputs_) {
+    arena_.push_back(&eval_, o.first);
+  }
+  for (auto* l : ModuleInfo(src_).locals()) {
+    arena_.push_back(&eval_, l);
+  }
+  arena_.allocate(&eval_);
+
+  // Stateful variables are the targets of non-blocking assignments. Expect
+  // roughly one write per variable per step.
+  updates_.reserve(arena_.size(), slots_.size());
+}
+
+bool SwLogic::compile_bytecode(string* error) {
+  // Variable storage is shared between the interpreter and eval_, so there's
+  // no need to transfer the state that was computed by the constructor.
+  auto* bc = new Bytecode(&eval_);
+  if (!bc->compile(src_)) {
+    *error = bc->get_error();
+    delete bc;
+    return false;
+  }
+  bc->set_task_handler([this](const SystemTaskEnableStatement* s) {
+    bytecode_->flush();
+    schedule_now(s);
+  });
+  bc->set_feof_handler([this](uint32_t fd) {
+    return get_stream(fd)->eof();
+  });
+  if (!levels_.empty()) {
+    bc->levelize(levels_);
+  }
+  bytecode_ = bc;
+  return true;
+}
+
+bool SwLogic::levelize() {
+  // Record the rank of each process in the bits of common_ which aren't used
+  // by non-Number nodes. A rank of zero indicates a dynamically scheduled
+  // process. The events which guard a combinational always block share its
+  // rank, since any change in their value triggers the block. Processes are
+  // statements, events, or continuous assigns, never Numbers, whose format
+  // and size live in the same bits.
+  const Levelize l(src_);
+  for (auto* mi : l.order()) {
+    const auto rank = levels_.size() + 1;
+    if (mi->is(Node::Tag::continuous_assign)) {
+      levels_.push_back(mi);
+    } else {
+      const auto* tcs = static_cast<const TimingControlStatement*>(static_cast<const AlwaysConstruct*>(mi)->get_stmt());
+      const auto* ec = static_cast<const EventControl*>(tcs->get_ctrl());
+      for (auto i = ec->begin_events(), ie = ec->end_events(); i != ie; ++i) {
+        const_cast<Event*>(*i)->set_val<2,30>(rank);
+      }
+      levels_.push_back(tcs->get_stmt());
+    }
+    assert(!levels_.back()->is(Node::Tag::number));
+    const_cast<Node*>(levels_.back())->set_val<2,30>(rank);
+  }
+  if (bytecode_ != nullptr) {
+    bytecode_->levelize(levels_);
+  }
+  return !levels_.empty();
+}
+
 State* SwLogic::get_state() {
+  // Stateful variables are packed contiguously at the front of the arena
+  assert(slots_.size() == state_.size());
   auto* s = new State();
-  for (const auto& sv : state_) {
-    s->insert(sv.first, eval_.get_array_value(sv.second));
+  for (const auto& sv : slots_) {
+    const auto* b = arena_.get(get<2>(sv));
+    Vector<Bits> bs;
+    bs.insert(bs.end(), b, b + get<3>(sv));
+    s->insert(get<0>(sv), bs);
   }
   return s;
 }
 
 void SwLogic::set_state(const State* s) {
-  for (const auto& sv : state_) {
-    const auto itr = s->find(sv.first);
-    if (itr != s->end()) {
-      eval_.assign_array_value(sv.second, itr->second);
-      notify(sv.second);
+  assert(slots_.size() == state_.size());
+  for (const auto& sv : slots_) {
+    const auto itr = s->find(get<0>(sv));
+    if (itr == s->end()) {
+      continue;
     }
+    assert(itr->second.size() == get<3>(sv));
+    auto* b = arena_.get(get<2>(sv));
+    for (size_t i = 0, ie = get<3>(sv); i < ie; ++i) {
+      b[i].assign(itr->second[i]);
+    }
+    eval_.flag_changed(get<1>(sv));
+    notify(get<1>(sv));
   }
   silent_evaluate();
 }
@@ -180,6 +278,10 @@ void SwLogic::finalize() {
     }
   }
   // Schedule initial constructs
+  if (bytecode_ != nullptr) {
+    bytecode_->run_initial_constructs();
+    return;
+  }
   for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
     if ((*i)->is(Node::Tag::initial_construct)) {
       schedule_now(*i);
@@ -187,6 +289,10 @@ void SwLogic::finalize() {
   }
 }
 
+bool SwLogic::is_thread_safe() const {
+  return true;
+}
+
 void SwLogic::read(VId vid, const Bits* b) {
   const auto* id = inputs_[vid];
   if (eval_.assign_value(id, *b)) {
@@ -197,39 +303,45 @@ void SwLogic::read(VId vid, const Bits* b) {
 void SwLogic::evaluate() {
   // This is a while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
+  if (bytecode_ != nullptr) {
+    bytecode_->evaluate(false);
   }
+  drain_active();
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
   }
 }
 
 bool SwLogic::there_are_updates() const {
+  if (bytecode_ != nullptr) {
+    return bytecode_->there_are_updates();
+  }
   return !updates_.empty();
 }
 
 void SwLogic::update() {
+  if (bytecode_ != nullptr) {
+    there_were_tasks_ = false;
+    bytecode_->update();
+    bytecode_->evaluate(false);
+    for (auto& o : outputs_) {
+      interface()->write(o.second, &eval_.get_value(o.first));
+    }
+    return;
+  }
+
   // This is a for loop. Updates happen simultaneously
-  for (size_t i = 0, ie = updates_.size(); i < ie; ++i) {
-    const auto& val = update_pool_[i];
-    if (eval_.assign_value(get<0>(updates_[i]), get<1>(updates_[i]), get<2>(updates_[i]), get<3>(updates_[i]), val)) {
-      notify(get<0>(updates_[i]));
+  for (auto i = updates_.begin(), ie = updates_.end(); i != ie; ++i) {
+    const auto& t = i->target;
+    if (eval_.assign_value(t.first, t.second, i->msb, i->lsb, updates_.value(i))) {
+      notify(t.first, t.second);
     }
   }
   updates_.clear();
 
   // This is while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
-  }
+  drain_active();
 
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
@@ -240,6 +352,36 @@ bool SwLogic::there_were_tasks() const {
   return there_were_tasks_;
 }
 
+size_t SwLogic::open_loop(VId clk, bool val, size_t itr) {
+  // Resolve the clock once and toggle its value in place rather than going
+  // through read(). The runtime only invokes this method when there are no
+  // outputs, so the calls to evaluate() and update() below write nothing back
+  // to the interface. Those calls are qualified to avoid virtual dispatch,
+  // and update() already drains any evaluations that it triggers.
+  const auto* id = inputs_[clk];
+  assert(id != nullptr);
+  auto& b = const_cast<Bits&>(eval_.get_value(id));
+  if (b.get(0) != val) {
+    b.flip(0);
+    eval_.flag_changed(id);
+  }
+
+  size_t res = 0;
+  for (auto tasks = false; (res < itr) && !tasks; ++res) {
+    b.flip(0);
+    eval_.flag_changed(id);
+    notify(id);
+
+    SwLogic::evaluate();
+    tasks = there_were_tasks_;
+    while (SwLogic::there_are_updates()) {
+      SwLogic::update();
+      tasks = tasks || there_were_tasks_;
+    }
+  }
+  return res;
+}
+
 SwLogic::EofIndex::EofIndex(SwLogic* sw) : Visitor() {
   sw_ = sw;
 }
@@ -253,13 +395,29 @@ void SwLogic::schedule_now(const Node* n) {
 }
 
 void SwLogic::schedule_active(const Node* n) {
-  if (!n->get_flag<1>()) {
+  assert(!n->is(Node::Tag::number));
+  const auto rank = n->get_val<2,30>();
+  if (rank != 0) {
+    const auto* l = levels_[rank-1];
+    if (!l->get_flag<1>()) {
+      ranked_.push(rank-1);
+      const_cast<Node*>(l)->set_flag<1>(true);
+    }
+  } else if (!n->get_flag<1>()) {
     active_.push_back(n);
     const_cast<Node*>(n)->set_flag<1>(true);
   }
 }
 
 void SwLogic::notify(const Node* n) {
+  if (bytecode_ != nullptr) {
+    if (n->is(Node::Tag::identifier)) {
+      bytecode_->notify(static_cast<const Identifier*>(n));
+    } else if (n->is(Node::Tag::feof_expression)) {
+      bytecode_->notify_eofs();
+    }
+    return;
+  }
   switch (n->get_tag()) {
     case Node::Tag::identifier:
       for (auto* m : static_cast<const Identifier*>(n)->monitor_) {
@@ -281,15 +439,59 @@ void SwLogic::notify(const Node* n) {
   }
 }
 
+void SwLogic::notify(const Identifier* id, size_t idx) {
+  // Writes to a single element of an array only wake up the nodes which can
+  // observe that element.
+  const auto itr = array_reads_.find(id);
+  if ((bytecode_ != nullptr) || (itr == array_reads_.end())) {
+    return notify(id);
+  }
+  for (const auto& r : itr->second) {
+    if (eval_.observes(id, r.second, idx)) {
+      schedule_active(r.first);
+    }
+  }
+}
+
+void SwLogic::notify_write(const Identifier* lhs) {
+  const auto* r = Resolve().get_resolution(lhs);
+  assert(r != nullptr);
+  if (r->empty_dim()) {
+    notify(r);
+  } else {
+    notify(r, get<0>(eval_.dereference(r, lhs)));
+  }
+}
+
+void SwLogic::drain_active() {
+  // Dynamically scheduled events run first. Ranked processes are run one at a
+  // time in increasing order of rank, so that by the time a process runs,
+  // everything upstream from it has settled.
+  while (true) {
+    if (!active_.empty()) {
+      auto* e = active_.back();
+      active_.pop_back();
+      const_cast<Node*>(e)->set_flag<1>(false);
+      schedule_now(e);
+    } else if (!ranked_.empty()) {
+      auto* e = levels_[ranked_.top()];
+      ranked_.pop();
+      const_cast<Node*>(e)->set_flag<1>(false);
+      schedule_now(e);
+    } else {
+      break;
+    }
+  }
+}
+
 void SwLogic::silent_evaluate() {
   // Turn on silent mode and drain the active queue
-  silent_ = true;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
+  if (bytecode_ != nullptr) {
+    bytecode_->evaluate(true);
+    return;
   }
+  silent_ = true;
+  drain_active();
   silent_ = false;
 }
 
@@ -326,7 +528,7 @@ void SwLogic::visit(const Event* e) {
 void SwLogic::visit(const ContinuousAssign* ca) {
   const auto& val = eval_.get_value(ca->get_rhs());
   if (eval_.assign_value(ca->get_lhs(), val)) {
-    notify(Resolve().get_resolution(ca->get_lhs()));
+    notify_write(ca->get_lhs());
   }
 }
 
@@ -336,7 +538,7 @@ void SwLogic::visit(const BlockingAssign* ba) {
 
   const auto& res = eval_.get_value(ba->get_rhs());
   if (eval_.assign_value(ba->get_lhs(), res)) {
-    notify(Resolve().get_resolution(ba->get_lhs()));
+    notify_write(ba->get_lhs());
   }
 }
 
@@ -350,13 +552,12 @@ void SwLogic::visit(const NonblockingAssign* na) {
     const auto target = eval_.dereference(r, na->get_lhs());
     const auto& res = eval_.get_value(na->get_rhs());
 
-    const auto idx = updates_.size();
-    if (idx >= update_pool_.size()) {
-      update_pool_.resize(2*update_pool_.size());
-    } 
-
-    updates_.push_back(make_tuple(r, get<0>(target), get<1>(target), get<2>(target)));
-    update_pool_[idx].copy(res);
+    // Writes are keyed on the arena offset of the element that they target.
+    // Writes to elements outside of the arena are never coalesced.
+    const auto idx = get<0>(target);
+    const auto& val = eval_.get_array_value(r);
+    const auto key = (idx < val.size()) ? arena_.offset(&val[idx]) : arena_.size();
+    updates_.push_back(make_pair(r, idx), key, get<1>(target), get<2>(target), res);
   }
 }
 
@@ -31,12 +31,18 @@
 #ifndef CASCADE_SRC_TARGET_CORE_SW_SW_LOGIC_H
 #define CASCADE_SRC_TARGET_CORE_SW_SW_LOGIC_H
 
+#include <functional>
+#include <queue>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "common/bits.h"
 #include "target/core.h"
+#include "target/core/sw/arena.h"
+#include "target/core/sw/bytecode.h"
+#include "target/core/sw/monitor.h"
+#include "target/core/sw/update_buffer.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/ast/visitors/visitor.h"
 
@@ -56,12 +62,26 @@ class SwLogic : public Logic, public Visitor {
     SwLogic& set_state(const Identifier* id, VId vid);
     SwLogic& set_output(const Identifier* id, VId vid);
 
+    // Moves variable storage into a single contiguous arena, with stateful
+    // variables first. This method must be called after the calls to
+    // set_state() and before any call to compile_bytecode().
+    void pack();
+    // Translates this core into bytecode. Returns false and leaves the core
+    // in its default, ast-interpreting mode if translation fails, in which
+    // case error describes the problem.
+    bool compile_bytecode(std::string* error);
+    // Computes a static evaluation order for the combinational logic in this
+    // core. Returns false and leaves the core in its default, dynamically
+    // scheduled mode if there is no combinational logic to order.
+    bool levelize();
+
     // Core Interface:
     State* get_state() override;
     void set_state(const State* s) override;
     Input* get_input() override;
     void set_input(const Input* i) override;
     void finalize() override; 
+    bool is_thread_safe() const override;
 
     void read(VId vid, const Bits* b) override;
     void evaluate() override;
@@ -69,6 +89,8 @@ class SwLogic : public Logic, public Visitor {
     void update() override;
     bool there_were_tasks() const override;
 
+    size_t open_loop(VId clk, bool val, size_t itr) override;
+
   private:
     class EofIndex : public Visitor {
       public:
@@ -84,20 +106,28 @@ class SwLogic : public Logic, public Visitor {
     std::vector<std::pair<const Identifier*, VId>> outputs_;
     std::unordered_map<VId, const Identifier*> state_;
     std::vector<const FeofExpression*> eofs_;
+    Monitor::ArrayReads array_reads_;
+    std::vector<std::tuple<VId, const Identifier*, size_t, size_t>> slots_;
+    Arena arena_;
 
     // Control State:
     bool silent_;
     bool there_were_tasks_;
     std::vector<const Node*> active_;
-    std::vector<std::tuple<const Identifier*,size_t,int,int>> updates_;
-    std::vector<Bits> update_pool_;
+    std::vector<const Node*> levels_;
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ranked_;
+    UpdateBuffer<std::pair<const Identifier*, size_t>> updates_;
     Evaluate eval_;
+    Bytecode* bytecode_;
     std::unordered_map<FId, interfacestream*> streams_;
 
     // Scheduling: 
     void schedule_now(const Node* n);
     void schedule_active(const Node* n);
     void notify(const Node* n);
+    void notify(const Identifier* id, size_t idx);
+    void notify_write(const Identifier* lhs);
+    void drain_active();
 
     // Finalize Helpers:
     void silent_evaluate();
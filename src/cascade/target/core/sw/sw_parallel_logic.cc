@@ -0,0 +1,521 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "target/core/sw/sw_parallel_logic.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <unordered_set>
+#include "target/input.h"
+#include "target/state.h"
+#include "verilog/ast/ast.h"
+
+using namespace std;
+
+namespace cascade::sw {
+
+SwParallelLogic::SwParallelLogic(Interface* interface, ModuleDeclaration* md, ThreadPool* pool) : Logic(interface) {
+  src_ = md;
+  there_were_tasks_ = false;
+  pool_ = pool;
+}
+
+SwParallelLogic::~SwParallelLogic() {
+  for (auto* c : clusters_) {
+    delete c;
+  }
+  for (auto* i : interfaces_) {
+    delete i;
+  }
+  delete src_;
+}
+
+SwParallelLogic& SwParallelLogic::set_input(const Identifier* id, VId vid) {
+  inputs_.push_back(make_pair(id, vid));
+  return *this;
+}
+
+SwParallelLogic& SwParallelLogic::set_state(const Identifier* id, VId vid) {
+  state_.push_back(make_pair(id, vid));
+  return *this;
+}
+
+SwParallelLogic& SwParallelLogic::set_output(const Identifier* id, VId vid) {
+  outputs_.push_back(make_pair(id, vid));
+  return *this;
+}
+
+bool SwParallelLogic::split(const Partition& p, bool levelize, bool bytecode, string* error) {
+  assert(clusters_.empty());
+  const auto n = p.clusters().size();
+  assert(n > 1);
+
+  // Ports keep the vids assigned by the runtime. Variables which are written
+  // in one cluster and read in another are assigned vids past the end of
+  // those.
+  auto res = true;
+  unordered_map<const Identifier*, VId> vids;
+  VId next = 0;
+  for (const auto* vs : {&inputs_, &state_, &outputs_}) {
+    for (const auto& v : *vs) {
+      vids[v.first] = v.second;
+      next = max(next, v.second+1);
+    }
+  }
+  unordered_map<const Identifier*, size_t> writer;
+  for (size_t c = 0; c < n; ++c) {
+    for (auto* w : p.writes(c)) {
+      writer[w] = c;
+    }
+  }
+  unordered_set<const Identifier*> crossing;
+  for (size_t c = 0; c < n; ++c) {
+    for (auto* r : p.reads(c)) {
+      const auto itr = writer.find(r);
+      if ((itr != writer.end()) && (itr->second != c)) {
+        crossing.insert(r);
+        if (vids.find(r) == vids.end()) {
+          vids[r] = next++;
+        }
+      }
+    }
+  }
+  readers_.resize(next);
+  external_.resize(next, false);
+  for (const auto& o : outputs_) {
+    external_[o.second] = true;
+  }
+
+  // Ports which aren't written by any process are owned by the first
+  // cluster so that their values are still preserved across calls to
+  // get_state() and get_input().
+  const auto owner = [&writer](const Identifier* id) {
+    const auto itr = writer.find(id);
+    return (itr == writer.end()) ? 0 : itr->second;
+  };
+  unordered_set<const Identifier*> ins;
+  for (const auto& i : inputs_) {
+    ins.insert(i.first);
+  }
+  unordered_set<const Identifier*> read;
+  for (size_t c = 0; c < n; ++c) {
+    read.insert(p.reads(c).begin(), p.reads(c).end());
+  }
+
+  for (size_t c = 0; c < n; ++c) {
+    // Every cluster gets a copy of the port declarations, but only the
+    // variables and processes which it uses. Parameters are always copied,
+    // since they may appear in the dimensions of other declarations.
+    unordered_set<const Identifier*> uses(p.reads(c).begin(), p.reads(c).end());
+    uses.insert(p.writes(c).begin(), p.writes(c).end());
+    for (const auto& s : state_) {
+      if (owner(s.first) == c) {
+        uses.insert(s.first);
+      }
+    }
+    auto* md = new ModuleDeclaration(src_->get_attrs()->clone(), src_->get_id()->clone());
+    for (auto i = src_->begin_ports(), ie = src_->end_ports(); i != ie; ++i) {
+      md->push_back_ports((*i)->clone());
+    }
+    const unordered_set<const ModuleItem*> procs(p.clusters()[c].begin(), p.clusters()[c].end());
+    unordered_map<const Identifier*, const Identifier*> ids;
+    for (auto i = src_->begin_items(), ie = src_->end_items(); i != ie; ++i) {
+      if (procs.find(*i) != procs.end()) {
+        md->push_back_items((*i)->clone());
+      } else if ((*i)->is(Node::Tag::port_declaration)) {
+        auto* pd = static_cast<PortDeclaration*>((*i)->clone());
+        ids[static_cast<const PortDeclaration*>(*i)->get_decl()->get_id()] = pd->get_decl()->get_id();
+        md->push_back_items(pd);
+      } else if ((*i)->is_subclass_of(Node::Tag::declaration)) {
+        const auto* id = static_cast<const Declaration*>(*i)->get_id();
+        if (((*i)->is(Node::Tag::reg_declaration) || (*i)->is(Node::Tag::net_declaration)) && (uses.find(id) == uses.end())) {
+          continue;
+        }
+        auto* d = static_cast<Declaration*>((*i)->clone());
+        ids[static_cast<const Declaration*>(*i)->get_id()] = d->get_id();
+        md->push_back_items(d);
+      }
+    }
+
+    auto* ci = new ClusterInterface(this, next);
+    auto* sw = new SwLogic(ci, md);
+    for (const auto& v : vids) {
+      const auto itr = ids.find(v.first);
+      if (itr == ids.end()) {
+        continue;
+      }
+      const auto reads = p.reads(c).find(v.first) != p.reads(c).end();
+      const auto writes = p.writes(c).find(v.first) != p.writes(c).end();
+      const auto mine = owner(v.first) == c;
+
+      // Clusters read the variables that they don't write themselves, and
+      // write the ports that they own along with any variables which are read
+      // by other clusters.
+      if ((reads && !writes) || (mine && (ins.find(v.first) != ins.end()) && (read.find(v.first) == read.end()))) {
+        sw->set_input(itr->second, v.second);
+        readers_[v.second].push_back(c);
+      }
+      if (mine && (external_[v.second] || (writes && (crossing.find(v.first) != crossing.end())))) {
+        sw->set_output(itr->second, v.second);
+      }
+    }
+    for (const auto& s : state_) {
+      const auto* id = ids[s.first];
+      if ((owner(s.first) == c) || (p.reads(c).find(s.first) != p.reads(c).end())) {
+        sw->set_state(id, s.second);
+      }
+      if (owner(s.first) == c) {
+        owners_[s.second] = c;
+      }
+    }
+
+    sw->pack();
+    if (levelize) {
+      sw->levelize();
+    }
+    if (bytecode && !sw->compile_bytecode(error)) {
+      res = false;
+    }
+    clusters_.push_back(sw);
+    interfaces_.push_back(ci);
+  }
+
+  active_.resize(n, 0);
+  return res;
+}
+
+State* SwParallelLogic::get_state() {
+  vector<State*> ss;
+  for (auto* c : clusters_) {
+    ss.push_back(c->get_state());
+  }
+  auto* s = new State();
+  for (const auto& sv : state_) {
+    const auto* cs = ss[owners_[sv.second]];
+    const auto itr = cs->find(sv.second);
+    assert(itr != cs->end());
+    s->insert(sv.second, itr->second);
+  }
+  for (auto* cs : ss) {
+    delete cs;
+  }
+  return s;
+}
+
+void SwParallelLogic::set_state(const State* s) {
+  for (auto* c : clusters_) {
+    c->set_state(s);
+  }
+}
+
+Input* SwParallelLogic::get_input() {
+  vector<Input*> is;
+  for (auto* c : clusters_) {
+    is.push_back(c->get_input());
+  }
+  auto* i = new Input();
+  for (const auto& iv : inputs_) {
+    if (readers_[iv.second].empty()) {
+      continue;
+    }
+    const auto* ci = is[readers_[iv.second].front()];
+    const auto itr = ci->find(iv.second);
+    assert(itr != ci->end());
+    i->insert(iv.second, itr->second);
+  }
+  for (auto* ci : is) {
+    delete ci;
+  }
+  return i;
+}
+
+void SwParallelLogic::set_input(const Input* i) {
+  for (auto* c : clusters_) {
+    c->set_input(i);
+  }
+}
+
+void SwParallelLogic::finalize() {
+  for (auto* c : clusters_) {
+    c->finalize();
+  }
+}
+
+bool SwParallelLogic::is_thread_safe() const {
+  return true;
+}
+
+void SwParallelLogic::read(VId vid, const Bits* b) {
+  for (auto c : readers_[vid]) {
+    clusters_[c]->read(vid, b);
+    active_[c] = 1;
+  }
+}
+
+void SwParallelLogic::evaluate() {
+  there_were_tasks_ = false;
+  fill(active_.begin(), active_.end(), 1);
+  do {
+    run(Phase::EVALUATE);
+  } while (exchange());
+}
+
+bool SwParallelLogic::there_are_updates() const {
+  for (auto* c : clusters_) {
+    if (c->there_are_updates()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SwParallelLogic::update() {
+  there_were_tasks_ = false;
+  run(Phase::UPDATE);
+  while (exchange()) {
+    run(Phase::EVALUATE);
+  }
+}
+
+bool SwParallelLogic::there_were_tasks() const {
+  return there_were_tasks_;
+}
+
+void SwParallelLogic::run(Phase p) {
+  batch_.clear();
+  for (size_t c = 0, ce = clusters_.size(); c < ce; ++c) {
+    if ((p == Phase::EVALUATE) ? active_[c] : clusters_[c]->there_are_updates()) {
+      batch_.push_back(c);
+    }
+    active_[c] = 0;
+  }
+  if (batch_.empty()) {
+    return;
+  }
+  const auto step = [this, p](size_t c) {
+    if (p == Phase::EVALUATE) {
+      clusters_[c]->evaluate();
+    } else {
+      clusters_[c]->update();
+    }
+  };
+
+  // Hand all but the first cluster off to the pool and run the first one
+  // here. Block until the pool has finished the rest.
+  size_t remaining = batch_.size() - 1;
+  mutex lock;
+  condition_variable cv;
+  for (size_t i = 1, ie = batch_.size(); i < ie; ++i) {
+    const auto c = batch_[i];
+    pool_->insert([&step, &remaining, &lock, &cv, c]{
+      step(c);
+      lock_guard<mutex> lg(lock);
+      if (--remaining == 0) {
+        cv.notify_one();
+      }
+    });
+  }
+  step(batch_[0]);
+  unique_lock<mutex> ul(lock);
+  cv.wait(ul, [&remaining]{ return remaining == 0; });
+
+  for (auto c : batch_) {
+    there_were_tasks_ = there_were_tasks_ || clusters_[c]->there_were_tasks();
+    interfaces_[c]->flush();
+  }
+}
+
+bool SwParallelLogic::exchange() {
+  // Deliver the values which were written by each cluster to the clusters
+  // which read them and, for ports, to the runtime.
+  auto res = false;
+  for (auto* ci : interfaces_) {
+    for (auto v : ci->dirty_) {
+      ci->is_dirty_[v] = false;
+      const auto* b = &ci->vals_[v];
+      if (external_[v]) {
+        // Clusters only mark values which have changed
+        interface()->write_changed(v, b);
+      }
+      for (auto c : readers_[v]) {
+        clusters_[c]->read(v, b);
+        active_[c] = 1;
+        res = true;
+      }
+    }
+    ci->dirty_.clear();
+  }
+  return res;
+}
+
+SwParallelLogic::ClusterInterface::ClusterInterface(SwParallelLogic* parent, size_t n) : Interface() {
+  parent_ = parent;
+  vals_.resize(n);
+  is_dirty_.resize(n, false);
+}
+
+void SwParallelLogic::ClusterInterface::write(VId id, const Bits* b) {
+  // Same as the runtime's data plane: vals_ is populated with default
+  // constructed values, so the first write always goes through.
+  if ((vals_[id].size() == b->size()) && (vals_[id] == *b)) {
+    return;
+  }
+  vals_[id] = *b;
+  mark(id);
+}
+
+void SwParallelLogic::ClusterInterface::write(VId id, bool b) {
+  if (vals_[id].size() == 0) {
+    vals_[id] = Bits(b);
+  } else if (vals_[id].to_bool() != b) {
+    vals_[id].flip(0);
+  } else {
+    return;
+  }
+  mark(id);
+}
+
+void SwParallelLogic::ClusterInterface::debug(uint32_t action, const string& arg) {
+  // System tasks take effect immediately, so anything that this cluster has
+  // already printed needs to go out first. Output which follows a call to
+  // finish() would otherwise be dropped by the runtime.
+  flush();
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  parent_->interface()->debug(action, arg);
+}
+
+void SwParallelLogic::ClusterInterface::finish(uint32_t arg) {
+  flush();
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  parent_->interface()->finish(arg);
+}
+
+void SwParallelLogic::ClusterInterface::restart(const string& path) {
+  flush();
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  parent_->interface()->restart(path);
+}
+
+void SwParallelLogic::ClusterInterface::retarget(const string& s) {
+  flush();
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  parent_->interface()->retarget(s);
+}
+
+void SwParallelLogic::ClusterInterface::save(const string& path) {
+  flush();
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  parent_->interface()->save(path);
+}
+
+FId SwParallelLogic::ClusterInterface::fopen(const string& path, uint8_t mode) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->fopen(path, mode);
+}
+
+int32_t SwParallelLogic::ClusterInterface::in_avail(FId id) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->in_avail(id);
+}
+
+uint32_t SwParallelLogic::ClusterInterface::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->pubseekoff(id, off, way, which);
+}
+
+uint32_t SwParallelLogic::ClusterInterface::pubseekpos(FId id, int32_t pos, uint8_t which) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->pubseekpos(id, pos, which);
+}
+
+int32_t SwParallelLogic::ClusterInterface::pubsync(FId id) {
+  // Syncs are ordered with the output that surrounds them
+  put(id).sync = true;
+  return 0;
+}
+
+int32_t SwParallelLogic::ClusterInterface::sbumpc(FId id) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->sbumpc(id);
+}
+
+int32_t SwParallelLogic::ClusterInterface::sgetc(FId id) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->sgetc(id);
+}
+
+uint32_t SwParallelLogic::ClusterInterface::sgetn(FId id, char* c, uint32_t n) {
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  return parent_->interface()->sgetn(id, c, n);
+}
+
+int32_t SwParallelLogic::ClusterInterface::sputc(FId id, char c) {
+  put(id).text.push_back(c);
+  return static_cast<uint8_t>(c);
+}
+
+uint32_t SwParallelLogic::ClusterInterface::sputn(FId id, const char* c, uint32_t n) {
+  put(id).text.append(c, n);
+  return n;
+}
+
+void SwParallelLogic::ClusterInterface::mark(VId id) {
+  if (!is_dirty_[id]) {
+    is_dirty_[id] = true;
+    dirty_.push_back(id);
+  }
+}
+
+SwParallelLogic::ClusterInterface::Put& SwParallelLogic::ClusterInterface::put(FId id) {
+  if (puts_.empty() || (puts_.back().id != id) || puts_.back().sync) {
+    puts_.push_back({id, "", false});
+  }
+  return puts_.back();
+}
+
+void SwParallelLogic::ClusterInterface::flush() {
+  if (puts_.empty()) {
+    return;
+  }
+  lock_guard<recursive_mutex> lg(parent_->io_lock_);
+  for (const auto& p : puts_) {
+    if (!p.text.empty()) {
+      parent_->interface()->sputn(p.id, p.text.c_str(), p.text.length());
+    }
+    if (p.sync) {
+      parent_->interface()->pubsync(p.id);
+    }
+  }
+  puts_.clear();
+}
+
+} // namespace cascade::sw
@@ -0,0 +1,171 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_SW_PARALLEL_LOGIC_H
+#define CASCADE_SRC_TARGET_CORE_SW_SW_PARALLEL_LOGIC_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/bits.h"
+#include "common/thread_pool.h"
+#include "target/core.h"
+#include "target/core/sw/partition.h"
+#include "target/core/sw/sw_logic.h"
+#include "target/interface.h"
+
+namespace cascade::sw {
+
+// This class simulates a single module by splitting it into clusters (see
+// Partition) and running each cluster in its own SwLogic. Clusters are run
+// concurrently on a pool which is shared by every core that the compiler
+// produces. Clusters only communicate through the values of the variables
+// which cross cluster boundaries. These are buffered while the clusters run
+// and then exchanged, serially, once every cluster has finished evaluating.
+// Clusters which receive new values are run again until the module is
+// quiescent. Output to streams is buffered in the same way, and then
+// forwarded in cluster order, so that it appears in a deterministic order.
+
+class SwParallelLogic : public Logic {
+  public:
+    SwParallelLogic(Interface* interface, ModuleDeclaration* md, ThreadPool* pool);
+    ~SwParallelLogic() override;
+
+    // Configuration Logic:
+    SwParallelLogic& set_input(const Identifier* id, VId vid);
+    SwParallelLogic& set_state(const Identifier* id, VId vid);
+    SwParallelLogic& set_output(const Identifier* id, VId vid);
+
+    // Builds one core per cluster in p, each of which is packed, and
+    // optionally levelized and translated to bytecode. Each cluster only
+    // declares the ports of this module and the variables that it uses. This
+    // method must be called after the calls to set_input(), set_state(), and
+    // set_output(). Returns false if any cluster couldn't be translated to
+    // bytecode, in which case error describes the problem.
+    bool split(const Partition& p, bool levelize, bool bytecode, std::string* error);
+
+    // Core Interface:
+    State* get_state() override;
+    void set_state(const State* s) override;
+    Input* get_input() override;
+    void set_input(const Input* i) override;
+    void finalize() override; 
+    bool is_thread_safe() const override;
+
+    void read(VId vid, const Bits* b) override;
+    void evaluate() override;
+    bool there_are_updates() const override;
+    void update() override;
+    bool there_were_tasks() const override;
+
+  private:
+    // Buffers the writes performed by a cluster and forwards everything else
+    // to the interface of the enclosing core.
+    class ClusterInterface : public Interface {
+      public:
+        ClusterInterface(SwParallelLogic* parent, size_t n);
+        ~ClusterInterface() override = default;
+
+        void write(VId id, const Bits* b) override;
+        void write(VId id, bool b) override;
+
+        void debug(uint32_t action, const std::string& arg) override;
+        void finish(uint32_t arg) override;
+        void restart(const std::string& path) override;
+        void retarget(const std::string& s) override;
+        void save(const std::string& path) override;
+
+        FId fopen(const std::string& path, uint8_t mode) override;
+        int32_t in_avail(FId id) override;
+        uint32_t pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) override;
+        uint32_t pubseekpos(FId id, int32_t pos, uint8_t which) override;
+        int32_t pubsync(FId id) override;
+        int32_t sbumpc(FId id) override;
+        int32_t sgetc(FId id) override;
+        uint32_t sgetn(FId id, char* c, uint32_t n) override;
+        int32_t sputc(FId id, char c) override;
+        uint32_t sputn(FId id, const char* c, uint32_t n) override;
+
+      private:
+        friend class SwParallelLogic;
+
+        // A run of characters written to a stream, or a request to sync it
+        struct Put {
+          FId id;
+          std::string text;
+          bool sync;
+        };
+
+        SwParallelLogic* parent_;
+        std::vector<Bits> vals_;
+        std::vector<VId> dirty_;
+        std::vector<bool> is_dirty_;
+        std::vector<Put> puts_;
+
+        void mark(VId id);
+        Put& put(FId id);
+        void flush();
+    };
+
+    enum class Phase : uint8_t {
+      EVALUATE = 0,
+      UPDATE
+    };
+
+    // Source Management:
+    ModuleDeclaration* src_;
+    std::vector<std::pair<const Identifier*, VId>> inputs_;
+    std::vector<std::pair<const Identifier*, VId>> state_;
+    std::vector<std::pair<const Identifier*, VId>> outputs_;
+
+    // Cluster Management:
+    std::vector<SwLogic*> clusters_;
+    std::vector<ClusterInterface*> interfaces_;
+    std::vector<std::vector<size_t>> readers_;
+    std::vector<bool> external_;
+    std::unordered_map<VId, size_t> owners_;
+
+    // Control State:
+    std::vector<uint8_t> active_;
+    std::vector<size_t> batch_;
+    bool there_were_tasks_;
+    ThreadPool* pool_;
+    std::recursive_mutex io_lock_;
+
+    // Control Helpers:
+    void run(Phase p);
+    bool exchange();
+};
+
+} // namespace cascade::sw
+
+#endif
@@ -0,0 +1,161 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_TARGET_CORE_SW_UPDATE_BUFFER_H
+#define CASCADE_SRC_TARGET_CORE_SW_UPDATE_BUFFER_H
+
+#include <cassert>
+#include <stddef.h>
+#include <vector>
+#include "common/bits.h"
+
+namespace cascade::sw {
+
+// This class is a reusable buffer of pending non-blocking assignments. Each
+// write is tagged with a dense key which identifies the variable element that
+// it targets. A write to the same element and bit range as the most recent
+// pending write to that element replaces its value rather than adding a new
+// entry. Since no later write in the buffer can overlap with it, the result
+// of applying the buffer in order is unchanged. Values are copied into
+// pre-allocated storage which is reused from one step to the next.
+
+template <typename T>
+class UpdateBuffer {
+  public:
+    struct Update {
+      T target;
+      size_t key;
+      int msb;
+      int lsb;
+    };
+    typedef typename std::vector<Update>::const_iterator const_iterator;
+
+    // Sentinel key for writes which should never be coalesced
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    UpdateBuffer();
+
+    // Sets the number of distinct keys and pre-allocates storage for n writes
+    void reserve(size_t keys, size_t n);
+
+    // Records a write of val to bits [msb:lsb] of target. Ranges of -1 -1
+    // denote a full write.
+    void push_back(const T& target, size_t key, int msb, int lsb, const Bits& val);
+
+    // Iterators over pending writes and their values, in program order
+    const_iterator begin() const;
+    const_iterator end() const;
+    const Bits& value(const_iterator itr) const;
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+  private:
+    std::vector<Update> updates_;
+    std::vector<Bits> pool_;
+    std::vector<size_t> last_;
+};
+
+template <typename T>
+inline UpdateBuffer<T>::UpdateBuffer() {
+  pool_.resize(1);
+}
+
+template <typename T>
+inline void UpdateBuffer<T>::reserve(size_t keys, size_t n) {
+  assert(updates_.empty());
+  last_.resize(keys, 0);
+  updates_.reserve(n);
+  if (n > pool_.size()) {
+    pool_.resize(n);
+  }
+}
+
+template <typename T>
+inline void UpdateBuffer<T>::push_back(const T& target, size_t key, int msb, int lsb, const Bits& val) {
+  // Keys are offset by one so that zero can denote no pending write
+  if (key < last_.size()) {
+    auto& l = last_[key];
+    if ((l != 0) && (updates_[l-1].msb == msb) && (updates_[l-1].lsb == lsb)) {
+      pool_[l-1].copy(val);
+      return;
+    }
+    l = updates_.size() + 1;
+  } else {
+    key = npos;
+  }
+
+  const auto idx = updates_.size();
+  if (idx >= pool_.size()) {
+    pool_.resize(2*pool_.size());
+  }
+  updates_.push_back({target, key, msb, lsb});
+  pool_[idx].copy(val);
+}
+
+template <typename T>
+inline typename UpdateBuffer<T>::const_iterator UpdateBuffer<T>::begin() const {
+  return updates_.begin();
+}
+
+template <typename T>
+inline typename UpdateBuffer<T>::const_iterator UpdateBuffer<T>::end() const {
+  return updates_.end();
+}
+
+template <typename T>
+inline const Bits& UpdateBuffer<T>::value(const_iterator itr) const {
+  return pool_[itr - updates_.begin()];
+}
+
+template <typename T>
+inline size_t UpdateBuffer<T>::size() const {
+  return updates_.size();
+}
+
+template <typename T>
+inline bool UpdateBuffer<T>::empty() const {
+  return updates_.empty();
+}
+
+template <typename T>
+inline void UpdateBuffer<T>::clear() {
+  for (const auto& u : updates_) {
+    if (u.key != npos) {
+      last_[u.key] = 0;
+    }
+  }
+  updates_.clear();
+}
+
+} // namespace cascade::sw
+
+#endif
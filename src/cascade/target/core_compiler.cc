@@ -80,6 +80,16 @@ void CoreCompiler::stop_async() {
   // Does nothing.
 }
 
+bool CoreCompiler::precompile(const ModuleDeclaration* md) {
+  // Does nothing.
+  (void) md;
+  return true;
+}
+
+void CoreCompiler::stop_precompile() {
+  // Does nothing.
+}
+
 Clock* CoreCompiler::compile_clock(Engine::Id id, ModuleDeclaration* md, Interface* interface) {
   (void) id;
   (void) interface;
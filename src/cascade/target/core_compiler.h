@@ -71,6 +71,19 @@ class CoreCompiler {
     // requests have returned. The default implementation does nothing.
     virtual void stop_async();
 
+    // Speculation Interface:
+    //
+    // Target specific implementations may override this method to do some of
+    // the work that compile() would do for md ahead of time, say by populating
+    // a cache, without producing a core. Implementations must not disturb any
+    // in-flight compilations or running cores. Returns false if the work could
+    // not be done right now and is worth trying again later. The default
+    // implementation does nothing and returns true.
+    virtual bool precompile(const ModuleDeclaration* md);
+    // Forces any invocation of precompile() to return in a *reasonably short*
+    // amount of time. The default implementation does nothing.
+    virtual void stop_precompile();
+
   protected:
     // These methods inherit ownership of md and are responsible for deleting
     // it or passing it off to another owner with the same expectation. In the
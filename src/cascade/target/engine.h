@@ -53,6 +53,7 @@ class Engine {
     bool is_clock() const;
     bool is_logic() const;
     bool is_stub() const;
+    bool is_thread_safe() const;
     Id get_id() const;
 
     // Scheduling Interface:
@@ -127,6 +128,10 @@ inline bool Engine::is_stub() const {
   return c_->is_stub();
 }
 
+inline bool Engine::is_thread_safe() const {
+  return c_->is_thread_safe();
+}
+
 inline Engine::Id Engine::get_id() const {
   return id_;
 }
@@ -77,8 +77,8 @@ size_t Input::deserialize(istream& is) {
   is.read(reinterpret_cast<char*>(&n), 4);
   size_t res = 4;
 
-  // Read that many id / bit pairs
-  for (size_t i = 0; i < n; ++i) {
+  // Read that many id / bit pairs, or until the stream runs dry
+  for (size_t i = 0; (i < n) && is.good(); ++i) {
     VId id; 
     Bits bits;
     is.read(reinterpret_cast<char*>(&id), 4);
@@ -48,6 +48,10 @@ class Interface {
     // invoke the corresponding data-plane methods on the runtime.
     virtual void write(VId id, const Bits* b) = 0;
     virtual void write(VId id, bool b) = 0;
+    // Cores which already know that b differs from the last value they wrote
+    // to id can call this method instead to bypass change detection. Targets
+    // which can't take advantage of this hint simply forward it to write().
+    virtual void write_changed(VId id, const Bits* b);
 
     // These methods must perform whatever target-specific logic is necessary to
     // invoke the corresponding system task calls on the runtime.
@@ -71,6 +75,10 @@ class Interface {
     virtual uint32_t sputn(FId id, const char* c, uint32_t n) = 0;
 };
 
+inline void Interface::write_changed(VId id, const Bits* b) {
+  write(id, b);
+}
+
 } // namespace cascade
 
 #endif
@@ -80,8 +80,8 @@ size_t State::deserialize(istream& is) {
   is.read(reinterpret_cast<char*>(&n), 4);
   size_t res = 4;
 
-  // Read that many id / bit pairs
-  for (size_t i = 0; i < n; ++i) {
+  // Read that many id / bit pairs, or until the stream runs dry
+  for (size_t i = 0; (i < n) && is.good(); ++i) {
     VId id; 
     is.read(reinterpret_cast<char*>(&id), 4);
     res += 4;
@@ -90,7 +90,7 @@ size_t State::deserialize(istream& is) {
     is.read(reinterpret_cast<char*>(&arity), 4);
     res += 4;
 
-    for (size_t j = 0; j < arity; ++j) {
+    for (size_t j = 0; (j < arity) && is.good(); ++j) {
       Bits bits;
       res += bits.deserialize(is);
       state_[id].push_back(bits);
@@ -171,7 +171,7 @@ bool Evaluate::assign_value(const Identifier* id, const Bits& val) {
   if (get<1>(dres) == -1) {
     if (!r->bit_val_[idx].eq(val)) {
       const_cast<Identifier*>(r)->bit_val_[idx].assign(val);
-      flag_changed(r);
+      flag_changed(r, idx);
       return true;
     }
     return false;
@@ -185,7 +185,7 @@ bool Evaluate::assign_value(const Identifier* id, const Bits& val) {
   const auto lsb = min(static_cast<size_t>(get<2>(dres)), get_width(r)-1);
   if (!r->bit_val_[idx].eq(msb, lsb, val)) {
     const_cast<Identifier*>(r)->bit_val_[idx].assign(msb, lsb, val);
-    flag_changed(r);
+    flag_changed(r, idx);
     return true;
   }
   return false;
@@ -252,6 +252,23 @@ tuple<size_t,int,int> Evaluate::dereference(const Identifier* r, const Identifie
   return make_tuple(idx, rng.first, rng.second);
 }
 
+bool Evaluate::observes(const Identifier* r, const Identifier* i, size_t idx) {
+  // Scalars, self-references, and references to an entire array can observe
+  // every element.
+  if (r->empty_dim() || (i == r) || (i->size_dim() < r->size_dim())) {
+    return true;
+  }
+  // So can references which slice one of the array's dimensions, such as the
+  // one that appears in the port list of a module with an array port.
+  auto iitr = i->begin_dim();
+  for (size_t d = 0, de = r->size_dim(); d < de; ++d, ++iitr) {
+    if ((*iitr)->is(Node::Tag::range_expression)) {
+      return true;
+    }
+  }
+  return get<0>(dereference(r, i)) == idx;
+}
+
 bool Evaluate::assign_value(const Identifier* id, size_t idx, int msb, int lsb, const Bits& val) {
   if (id->bit_val_.empty()) {
     init(const_cast<Identifier*>(id));
@@ -265,7 +282,7 @@ bool Evaluate::assign_value(const Identifier* id, size_t idx, int msb, int lsb,
   if (msb == -1) {
     if (!id->bit_val_[idx].eq(val)) {
       const_cast<Identifier*>(id)->bit_val_[idx].assign(val);
-      flag_changed(id);
+      flag_changed(id, idx);
       return true;
     }
     return false;
@@ -279,12 +296,19 @@ bool Evaluate::assign_value(const Identifier* id, size_t idx, int msb, int lsb,
   const auto l = min(static_cast<size_t>(lsb), get_width(id)-1);
   if (!id->bit_val_[idx].eq(m, l, val)) {
     const_cast<Identifier*>(id)->bit_val_[idx].assign(m, l, val);
-    flag_changed(id);
+    flag_changed(id, idx);
     return true;
   }
   return false;
 }
 
+void Evaluate::relocate(const Identifier* id, Bits* storage) {
+  if (id->bit_val_.empty()) {
+    init(const_cast<Identifier*>(id));
+  }
+  const_cast<Identifier*>(id)->bit_val_.borrow(storage);
+}
+
 void Evaluate::flag_changed(const Identifier* id) {
   for (auto i = Resolve().use_begin(id), ie = Resolve().use_end(id); i != ie; ++i) {
     const_cast<Expression*>(*i)->set_flag<0>(true);
@@ -292,6 +316,28 @@ void Evaluate::flag_changed(const Identifier* id) {
   const_cast<Identifier*>(id)->set_flag<0>(false);
 }
 
+void Evaluate::flag_changed(const Identifier* id, size_t idx) {
+  if (id->empty_dim()) {
+    return flag_changed(id);
+  }
+  // Only flag the uses of id which can see this element, along with the
+  // expressions that contain them. References whose subscripts depend on id
+  // are flagged when we reach the use of id inside of the subscript.
+  for (auto i = Resolve().use_begin(id), ie = Resolve().use_end(id); i != ie; ++i) {
+    if (!(*i)->is(Node::Tag::identifier)) {
+      continue;
+    }
+    const auto* u = static_cast<const Identifier*>(*i);
+    if ((Resolve().get_resolution(u) != id) || !observes(id, u, idx)) {
+      continue;
+    }
+    for (const Node* n = u; n->is_subclass_of(Node::Tag::expression); n = n->get_parent()) {
+      const_cast<Node*>(n)->set_flag<0>(true);
+    }
+  }
+  const_cast<Identifier*>(id)->set_flag<0>(false);
+}
+
 void Evaluate::flag_changed(const FeofExpression* fe) {
   for (const Node* n = fe; n->is_subclass_of(Node::Tag::expression); n = n->get_parent()) {
     const auto* e = static_cast<const Expression*>(n);
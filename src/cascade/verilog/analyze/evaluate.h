@@ -115,6 +115,11 @@ class Evaluate : public Editor {
     // undefined if i does not resolve to r. Returns -1 -1 for range to
     // indicate that no slice was provided.
     std::tuple<size_t,int,int> dereference(const Identifier* r, const Identifier* i);
+    // Low-level interface: Returns true if the value of i could depend on the
+    // idx'th element of r's underlying array, based on the current values of
+    // the expressions in i's dimensions. This method is undefined if i does
+    // not resolve to r.
+    bool observes(const Identifier* r, const Identifier* i, size_t idx);
     // Low-level interface: Sets the value of the ss'th element in id's
     // underlying array. Note that this value is set *in place*. This method
     // DOES NOT resolve id and then update the value which it finds there.
@@ -125,10 +130,17 @@ class Evaluate : public Editor {
     // DOES NOT resolve id and then update the value which it finds there.
     template <typename B>
     void assign_word(const Identifier* id, size_t idx, size_t n, B b);
+    // Low-level interface: Moves the underlying array of id into storage,
+    // which must hold at least get_array_value(id).size() elements and
+    // outlive id. Values are preserved. This method DOES NOT resolve id.
+    void relocate(const Identifier* id, Bits* storage);
 
     // Forced a recomputation for the next evaluation of any expression that
     // depends on this variable.
     void flag_changed(const Identifier* id);
+    // Forces a recomputation for the next evaluation of any expression that
+    // depends on the idx'th element of this variable.
+    void flag_changed(const Identifier* id, size_t idx);
     // Forces a recomputation for the next evaluation of this expression or any
     // expression that depends on this one.
     void flag_changed(const FeofExpression* fe);
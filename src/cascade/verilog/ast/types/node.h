@@ -164,6 +164,7 @@ class Node {
     DECORATION(uint32_t, common);
     // common_[0]    Evaluate: needs_update_
     // common_[1]    SwLogic:  active_
+    // common_[2-31] SwLogic:  rank_ (processes only, never Numbers)
     // common_[2-4]  Number:   format_
     // common_[5]    Number:   signed_
     // common_[6-31] Number:   size_
@@ -182,6 +183,7 @@ class Node {
 };
 
 inline Node::Node(Tag tag) {
+  common_ = 0;
   set_flag<0>(true);
   set_flag<1>(false);
   tag_ = tag;
@@ -97,6 +97,33 @@ void run_code(const string& march, const string& path, const string& expected, b
   EXPECT_EQ(sb->str(), expected);
 }
 
+void run_configured(const string& march, const string& path, const string& expected, const function<void(Cascade&)>& config, bool omit_from_coverage) {
+  if (::coverage && omit_from_coverage) {
+    return;
+  }
+
+  auto* sb = new stringbuf();
+  auto* eb = new stringbuf();
+
+  Cascade c;
+  c.set_fopen_dirs(System::src_root());
+  c.set_stdout(sb);
+  c.set_stderr(eb);
+  config(c);
+  c.run();
+
+  c << "`include \"share/cascade/march/" << march << ".v\"\n"
+    << "`include \"" << path << "\"" << endl;
+
+  c.stop_now();
+  ASSERT_FALSE(c.bad()) << eb->str();
+
+  c.run();
+  c.wait_for_stop();
+  EXPECT_EQ(sb->str(), expected);
+  EXPECT_EQ(eb->str(), "");
+}
+
 void run_concurrent(const string& march, const string& path, const string& expected, bool omit_from_coverage) {
   if (::coverage && omit_from_coverage) {
     return;
@@ -31,13 +31,20 @@
 #ifndef TEST_HARNESS_H
 #define TEST_HARNESS_H
 
+#include <functional>
 #include <string>
 
 namespace cascade {
 
+class Cascade;
+
 void run_parse(const std::string& path, bool expected);
 void run_typecheck(const std::string& march, const std::string& path, bool expected);
 void run_code(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
+// Like run_code(), but applies config to the instance of cascade before it
+// starts running and fails if anything is written to stderr. Compiler errors,
+// including the rejection of a module by a backend, are reported on stderr.
+void run_configured(const std::string& march, const std::string& path, const std::string& expected, const std::function<void(Cascade&)>& config, bool omit_from_coverage = false);
 void run_concurrent(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
 void run_benchmark(const std::string& path, const std::string& expected);
 
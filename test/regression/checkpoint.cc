@@ -0,0 +1,239 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "runtime/module.h"
+#include "runtime/runtime.h"
+#include "target/compiler.h"
+#include "target/core/sw/sw_compiler.h"
+
+using namespace cascade;
+using namespace std;
+
+namespace {
+
+// Declares the registers used by these tests. The always block makes them
+// stateful, which is what a checkpoint captures; otherwise they'd be treated
+// as wires holding their initial values.
+string decls(const string& x, const string& y) {
+  return "reg[7:0] x = " + x + ";\nreg[95:0] y = " + y + ";\nalways @(posedge clock.val) begin x <= x; y <= y; end\n";
+}
+
+// Evals code in a fresh runtime, runs f, and then waits for the program to
+// finish. Blocking evals are queued behind anything that f schedules, so f
+// can use them to wait for a save() or restart() to take effect.
+void run_checkpoint(const string& code, const function<void(Runtime&)>& f, const string& out, const string& err) {
+  stringbuf ob;
+  stringbuf eb;
+  Runtime rt;
+  rt.get_compiler()->set("sw", new sw::SwCompiler());
+  rt.rdbuf(Runtime::stdout_, &ob);
+  rt.rdbuf(Runtime::stderr_, &eb);
+  rt.run();
+
+  stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+  EXPECT_FALSE(rt.eval_all(march).second);
+  stringstream ss(code);
+  EXPECT_FALSE(rt.eval_all(ss).second);
+  f(rt);
+  stringstream fin("initial $finish;\n");
+  rt.eval_all(fin);
+
+  rt.wait_for_stop();
+  EXPECT_EQ(ob.str(), out);
+  EXPECT_EQ(eb.str(), err);
+}
+
+void save(Runtime& rt, const string& path) {
+  rt.save(path);
+  stringstream ss;
+  rt.eval_all(ss);
+}
+
+void restart(Runtime& rt, const string& path) {
+  rt.restart(path);
+  stringstream ss("initial $write(\"%h %h\", x, y);\n");
+  rt.eval_all(ss);
+}
+
+// Attempts to restart from path and checks that the runtime rejects it.
+void expect_restart_error(const string& path) {
+  stringbuf eb;
+  Runtime rt;
+  rt.get_compiler()->set("sw", new sw::SwCompiler());
+  rt.rdbuf(Runtime::stderr_, &eb);
+  rt.run();
+  stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+  EXPECT_FALSE(rt.eval_all(march).second);
+  stringstream ss(decls("0", "0"));
+  EXPECT_FALSE(rt.eval_all(ss).second);
+  rt.restart(path);
+  rt.wait_for_stop();
+
+  EXPECT_TRUE(rt.is_finished());
+  EXPECT_EQ(eb.str().find("Unable to restart from save file '" + path + "'"), 0u);
+}
+
+// Runs code with background checkpointing enabled, long enough for the
+// checkpointer to append to the file after y changes. Returns the sequence
+// numbers of the two copies of the index.
+pair<uint64_t, uint64_t> run_incremental(const string& path) {
+  stringbuf eb;
+  { Runtime rt;
+    rt.get_compiler()->set("sw", new sw::SwCompiler());
+    rt.rdbuf(Runtime::stderr_, &eb);
+    rt.set_checkpoint(path, 1);
+    rt.run();
+
+    stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+    EXPECT_FALSE(rt.eval_all(march).second);
+    stringstream ss1(decls("8'h2a", "1"));
+    EXPECT_FALSE(rt.eval_all(ss1).second);
+    this_thread::sleep_for(chrono::milliseconds(2500));
+    stringstream ss2("initial y = 96'h0123456789abcdef01234567;\n");
+    EXPECT_FALSE(rt.eval_all(ss2).second);
+    this_thread::sleep_for(chrono::milliseconds(2500));
+    rt.stop_now();
+  }
+  EXPECT_EQ(eb.str(), "");
+
+  ifstream ifs(path, ios::binary);
+  uint32_t n = 0;
+  ifs.seekg(12);
+  ifs.read(reinterpret_cast<char*>(&n), 4);
+  pair<uint64_t, uint64_t> res(0, 0);
+  ifs.read(reinterpret_cast<char*>(&res.first), 8);
+  ifs.seekg(16 + Module::checkpoint_slot_size(n));
+  ifs.read(reinterpret_cast<char*>(&res.second), 8);
+  EXPECT_TRUE(ifs.good());
+  return res;
+}
+
+} // namespace
+
+TEST(checkpoint, round_trip) {
+  const string path = "/tmp/cascade_checkpoint_round_trip.bin";
+  ::remove(path.c_str());
+  run_checkpoint(decls("8'h2a", "96'h0123456789abcdef01234567"), [&path](Runtime& rt){ save(rt, path); }, "", "");
+  run_checkpoint(decls("0", "0"), [&path](Runtime& rt){ restart(rt, path); }, "2a 0123456789abcdef01234567", "");
+  ::remove(path.c_str());
+}
+TEST(checkpoint, truncated) {
+  const string path = "/tmp/cascade_checkpoint_truncated.bin";
+  ::remove(path.c_str());
+  run_checkpoint(decls("8'h2a", "0"), [&path](Runtime& rt){ save(rt, path); }, "", "");
+
+  // Drop the last byte of the checkpoint. The index now points past the end
+  // of the file, and the restart should fail without touching the program.
+  ifstream ifs(path, ios::binary);
+  const string contents((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+  ifs.close();
+  ASSERT_GT(contents.length(), 16u);
+  ofstream ofs(path, ios::binary | ios::trunc);
+  ofs.write(contents.data(), contents.length()-1);
+  ofs.close();
+
+  expect_restart_error(path);
+  ::remove(path.c_str());
+}
+TEST(checkpoint, corrupt_payload) {
+  const string path = "/tmp/cascade_checkpoint_corrupt_payload.bin";
+  ::remove(path.c_str());
+  run_checkpoint(decls("8'h2a", "0"), [&path](Runtime& rt){ save(rt, path); }, "", "");
+
+  // Flip a bit in the last byte of the checkpoint. The file is the right
+  // size and would still deserialize, but its digest no longer matches the
+  // index, so the restart should fail without touching the program.
+  fstream fs(path, ios::in | ios::out | ios::binary);
+  fs.seekg(-1, ios::end);
+  const auto pos = fs.tellg();
+  const auto c = fs.get();
+  fs.seekp(pos);
+  fs.put(static_cast<char>(c ^ 1));
+  fs.close();
+
+  expect_restart_error(path);
+  ::remove(path.c_str());
+}
+TEST(checkpoint, incremental) {
+  const string path = "/tmp/cascade_checkpoint_incremental.bin";
+  ::remove(path.c_str());
+  const auto seqs = run_incremental(path);
+  EXPECT_GT(max(seqs.first, seqs.second), 1u);
+  run_checkpoint(decls("0", "0"), [&path](Runtime& rt){ restart(rt, path); }, "2a 0123456789abcdef01234567", "");
+  ::remove(path.c_str());
+}
+TEST(checkpoint, torn_index) {
+  const string path = "/tmp/cascade_checkpoint_torn_index.bin";
+  ::remove(path.c_str());
+  const auto seqs = run_incremental(path);
+  ASSERT_GT(min(seqs.first, seqs.second), 0u);
+
+  // Clobber the check at the end of the newer copy of the index, as though
+  // we'd crashed while writing it. Restart should fall back on the older
+  // copy, which still refers to a complete checkpoint.
+  fstream fs(path, ios::in | ios::out | ios::binary);
+  uint32_t n = 0;
+  fs.seekg(12);
+  fs.read(reinterpret_cast<char*>(&n), 4);
+  const auto slot = (seqs.first > seqs.second) ? 0 : 1;
+  const auto pos = 16 + (slot+1) * Module::checkpoint_slot_size(n) - 1;
+  fs.seekg(pos);
+  const auto c = fs.get();
+  fs.seekp(pos);
+  fs.put(static_cast<char>(~c));
+  fs.close();
+
+  stringbuf ob;
+  stringbuf eb;
+  { Runtime rt;
+    rt.get_compiler()->set("sw", new sw::SwCompiler());
+    rt.rdbuf(Runtime::stdout_, &ob);
+    rt.rdbuf(Runtime::stderr_, &eb);
+    rt.run();
+    stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+    EXPECT_FALSE(rt.eval_all(march).second);
+    stringstream ss(decls("0", "0"));
+    EXPECT_FALSE(rt.eval_all(ss).second);
+    restart(rt, path);
+    stringstream fin("initial $finish;\n");
+    rt.eval_all(fin);
+    rt.wait_for_stop();
+  }
+  EXPECT_EQ(ob.str().substr(0, 3), "2a ");
+  EXPECT_EQ(eb.str(), "");
+  ::remove(path.c_str());
+}
@@ -0,0 +1,103 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "runtime/runtime.h"
+#include "target/compiler.h"
+#include "target/core/sw/sw_compiler.h"
+
+using namespace cascade;
+using namespace std;
+
+namespace {
+
+// The runtime parses its input inside of an eval interrupt. This buffer
+// invokes a callback the first time that it runs dry, so any interrupts which
+// the callback schedules land in the same drain as the eval.
+class trapbuf : public stringbuf {
+  public:
+    trapbuf(const string& s, const function<void()>& trap) : stringbuf(s) {
+      trap_ = trap;
+    }
+    ~trapbuf() override = default;
+
+  private:
+    function<void()> trap_;
+
+    int_type underflow() override {
+      const auto res = stringbuf::underflow();
+      if ((res == traits_type::eof()) && (trap_ != nullptr)) {
+        trap_();
+        trap_ = nullptr;
+      }
+      return res;
+    }
+};
+
+// Evals a declaration and then triggers trap in the same drain. Interrupts
+// like save() and retarget() reschedule themselves until those evals have
+// been handled, so this hangs unless the runtime resyncs in between.
+void run_trap(const function<void(Runtime&)>& trap) {
+  stringbuf eb;
+  Runtime rt;
+  rt.get_compiler()->set("sw", new sw::SwCompiler());
+  rt.rdbuf(Runtime::stderr_, &eb);
+  rt.run();
+
+  stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+  EXPECT_FALSE(rt.eval_all(march).second);
+
+  trapbuf tb("reg[7:0] x = 8'd42;\n", [&rt, &trap]{ trap(rt); });
+  istream is(&tb);
+  EXPECT_FALSE(rt.eval_all(is).second);
+
+  rt.stop_now();
+  EXPECT_EQ(eb.str(), "");
+}
+
+} // namespace
+
+TEST(interrupts, eval_then_save) {
+  const auto path = "/tmp/cascade_interrupts_save.bin";
+  ::remove(path);
+  run_trap([path](Runtime& rt){ rt.save(path); });
+  ifstream ifs(path, ios::binary | ios::ate);
+  ASSERT_TRUE(ifs.is_open());
+  EXPECT_GT(ifs.tellg(), 0);
+  ::remove(path);
+}
+TEST(interrupts, eval_then_retarget) {
+  run_trap([](Runtime& rt){ rt.retarget("regression/minimal"); });
+}
@@ -0,0 +1,67 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+#include "include/cascade.h"
+#include "test/harness.h"
+
+using namespace cascade;
+
+// The array and bitcoin benchmarks are split into clusters. The others read
+// from files and are simulated by a single core, which should be unaffected
+// by this setting.
+
+TEST(sim_threads, array) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/array/run_5.v", "1048577\n", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, bitcoin) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/bitcoin/run_4.v", "0000000f 00000093\n", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, mips32) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/mips32/run_bubble_128.v", "1", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, nw) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/nw/run_4.v", "-1126", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, regex) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", [](Cascade& c){c.set_sim_threads(4);});
+}
+
+// Every module is split on its own here, and they all share a single pool.
+
+TEST(sim_threads, no_inline_array) {
+  run_configured("regression/no_inline", "share/cascade/test/benchmark/array/run_5.v", "1048577\n", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, no_inline_bitcoin) {
+  run_configured("regression/no_inline", "share/cascade/test/benchmark/bitcoin/run_4.v", "0000000f 00000093\n", [](Cascade& c){c.set_sim_threads(4);});
+}
+TEST(sim_threads, bytecode_bitcoin) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/bitcoin/run_4.v", "0000000f 00000093\n", [](Cascade& c){c.set_sim_threads(4); c.set_enable_bytecode(true);});
+}
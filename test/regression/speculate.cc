@@ -0,0 +1,85 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "include/cascade.h"
+#include "runtime/runtime.h"
+#include "target/compiler.h"
+#include "target/core/sw/sw_compiler.h"
+#include "test/harness.h"
+
+using namespace cascade;
+using namespace std;
+
+// Speculative compilations run in the background while the program is idle,
+// and must never change its behavior.
+
+namespace {
+
+void configure(Cascade& c) {
+  c.set_speculation("regression/minimal:regression/verilator32");
+}
+
+} // namespace
+
+TEST(speculate, array) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/array/run_5.v", "1048577\n", configure);
+}
+TEST(speculate, regex) {
+  run_configured("regression/minimal", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", configure);
+}
+TEST(speculate, idle_then_retarget) {
+  stringbuf ob;
+  stringbuf eb;
+  Runtime rt;
+  rt.get_compiler()->set("sw", new sw::SwCompiler());
+  rt.rdbuf(Runtime::stdout_, &ob);
+  rt.rdbuf(Runtime::stderr_, &eb);
+  rt.set_speculation("regression/minimal");
+  rt.run();
+
+  stringstream march("`include \"share/cascade/march/regression/minimal.v\"\n");
+  EXPECT_FALSE(rt.eval_all(march).second);
+  stringstream ss1("reg[7:0] x = 8'd42;\n");
+  EXPECT_FALSE(rt.eval_all(ss1).second);
+
+  // Give the speculator long enough to ask for the program and compile it
+  this_thread::sleep_for(chrono::milliseconds(2000));
+  rt.retarget("regression/minimal");
+  stringstream ss2("initial begin $write(x); $finish; end\n");
+  EXPECT_FALSE(rt.eval_all(ss2).second);
+
+  rt.wait_for_stop();
+  EXPECT_EQ(ob.str(), "42");
+  EXPECT_EQ(eb.str(), "");
+}
@@ -29,10 +29,23 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "gtest/gtest.h"
+#include "include/cascade.h"
 #include "test/harness.h"
 
 using namespace cascade;
 
+// The slots tests disable inlining, so that each module is verilated and
+// compiled separately and then linked together.
+
+namespace {
+
+void slots(Cascade& c) {
+  c.set_enable_inlining(false);
+  c.set_enable_slot_compilation(true);
+}
+
+} // namespace
+
 TEST(verilator32, array) {
   run_code("regression/verilator32", "share/cascade/test/benchmark/array/run_5.v", "1048577\n");
 }
@@ -48,6 +61,12 @@ TEST(verilator32, nw) {
 TEST(verilator32, regex) {
   run_code("regression/verilator32", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
 }
+TEST(verilator32, slots_array) {
+  run_configured("regression/verilator32", "share/cascade/test/benchmark/array/run_5.v", "1048577\n", slots);
+}
+TEST(verilator32, slots_regex) {
+  run_configured("regression/verilator32", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", slots);
+}
 
 #if __x86_64__ || __ppc64__
 TEST(verilator64, array) {
@@ -65,4 +84,10 @@ TEST(verilator64, nw) {
 TEST(verilator64, regex) {
   run_code("regression/verilator64", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
 }
+TEST(verilator64, slots_array) {
+  run_configured("regression/verilator64", "share/cascade/test/benchmark/array/run_5.v", "1048577\n", slots);
+}
+TEST(verilator64, slots_regex) {
+  run_configured("regression/verilator64", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", slots);
+}
 #endif
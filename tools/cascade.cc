@@ -57,6 +57,18 @@ auto& inc_dirs = StrArg<string>::create("-I")
 auto& input_path = StrArg<string>::create("-e")
   .usage("path/to/file.v")
   .description("Read input from file");
+auto& checkpoint = StrArg<string>::create("--checkpoint")
+  .usage("path/to/file")
+  .description("Periodically saves the state of the running program to this file in the background; restart with $restart()")
+  .initial("");
+auto& checkpoint_interval = StrArg<size_t>::create("--checkpoint_interval")
+  .usage("<s>")
+  .description("Minimum number of seconds between checkpoints")
+  .initial(60);
+auto& speculate = StrArg<string>::create("--speculate")
+  .usage("<march1>:<march2>:...:<marchn>")
+  .description("While idle, compiles the program in the background for each of these march targets so that a later $retarget() finishes sooner")
+  .initial("");
 
 __attribute__((unused)) auto& g2 = Group::create("Quartus Server Options");
 auto& quartus_host = StrArg<string>::create("--quartus_host")
@@ -85,9 +97,27 @@ auto& enable_log = FlagArg::create("--enable_log")
 __attribute__((unused)) auto& g4 = Group::create("Optimization Options");
 auto& disable_inlining = FlagArg::create("--disable_inlining")
   .description("Prevents cascade from inlining modules");
-auto& open_loop_target = StrArg<size_t>::create("--open_loop_target")
+auto& enable_bytecode = FlagArg::create("--enable_bytecode")
+  .description("Compiles software logic to bytecode rather than interpreting it directly");
+auto& enable_levelization = FlagArg::create("--enable_levelization")
+  .description("Statically schedules combinational logic in software rather than ordering it dynamically");
+auto& enable_slot_compilation = FlagArg::create("--enable_slot_compilation")
+  .description("Verilates each hardware module separately so that modules which haven't changed don't need to be recompiled");
+auto& native_path = StrArg<string>::create("--native_path")
+  .usage("path/to/dir")
+  .description("Scratch directory for building native code; the output of failed builds is left here")
+  .initial("/tmp/native");
+auto& open_loop_target = StrArg<double>::create("--open_loop_target")
+  .usage("<s>")
+  .description("Target number of seconds (fractions allowed) to run in open loop for before transferring control back to runtime")
+  .initial(0.01);
+auto& eval_threads = StrArg<size_t>::create("--eval_threads")
   .usage("<n>")
-  .description("Maximum number of seconds to run in open loop for before transferring control back to runtime")
+  .description("Number of threads to use when evaluating modules which have not been inlined")
+  .initial(1);
+auto& sim_threads = StrArg<size_t>::create("--sim_threads")
+  .usage("<n>")
+  .description("Number of threads to split a single large software module across")
   .initial(1);
 
 __attribute__((unused)) auto& g5 = Group::create("REPL Options");
@@ -200,9 +230,19 @@ int main(int argc, char** argv) {
   ::cascade_->set_fopen_dirs(::fopen_dirs.value());
   ::cascade_->set_include_dirs(::inc_dirs.value());
   ::cascade_->set_enable_inlining(!::disable_inlining.value());
+  ::cascade_->set_enable_bytecode(::enable_bytecode.value());
+  ::cascade_->set_enable_levelization(::enable_levelization.value());
+  ::cascade_->set_enable_slot_compilation(::enable_slot_compilation.value());
+  ::cascade_->set_native_path(::native_path.value());
   ::cascade_->set_open_loop_target(::open_loop_target.value());
   ::cascade_->set_quartus_server(::quartus_host.value(), ::quartus_port.value());
   ::cascade_->set_profile_interval(::profile.value());
+  ::cascade_->set_eval_threads(::eval_threads.value());
+  ::cascade_->set_sim_threads(::sim_threads.value());
+  if (::checkpoint.value() != "") {
+    ::cascade_->set_checkpoint(::checkpoint.value(), ::checkpoint_interval.value());
+  }
+  ::cascade_->set_speculation(::speculate.value());
 
   // Map standard streams to colored outbufs
   if (::disable_repl.value()) {
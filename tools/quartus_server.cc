@@ -46,6 +46,10 @@ auto& cache = StrArg<string>::create("--cache")
   .usage("<path/to/cache>")
   .description("Path to directory to use as compilation cache")
   .initial("/tmp/quartus_cache");
+auto& cache_size = StrArg<size_t>::create("--cache_size")
+  .usage("<int>")
+  .description("Maximum size of the compilation cache in MB; least recently used bitstreams are evicted first; 0 means unbounded")
+  .initial(0);
 auto& path = StrArg<string>::create("--path")
   .usage("<path/to/quarus>")
   .description("Path to quartus installation directory")
@@ -79,6 +83,7 @@ int main(int argc, char** argv) {
 
   ::qs = new avmm::QuartusServer();
   ::qs->set_cache_path(::cache.value());
+  ::qs->set_cache_size(::cache_size.value() << 20);
   ::qs->set_quartus_path(::path.value());
   ::qs->set_quartus_tunnel_command(::tunnel_command.value());
   ::qs->set_port(::port.value());